@@ -1,7 +1,27 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
 #include <johl/Arrays.h>
+#include <johl/Kernels.h>
+#include <johl/Allocators.h>
+#include <johl/MmapAllocator.h>
+#include <johl/ChunkedArrays.h>
+#include <johl/TiledArrays.h>
+#include <johl/HandleArrays.h>
+#include <johl/IndexedArrays.h>
+#include <johl/ArraysView.h>
+#include <johl/Select.h>
+#include <johl/Reduce.h>
+#include <johl/SearchIndex.h>
+#include <johl/SnapshotArrays.h>
+#include <johl/TrackedArrays.h>
 #include <random>
 #include <iostream>
 
@@ -32,6 +52,15 @@ struct Vec4
   }
 };
 
+//sum and minMax per component
+namespace johl
+{
+  template<>
+  struct is_float_vector<Vec4> : std::true_type
+  {
+  };
+}
+
 struct Name
 {
   char value[32];
@@ -59,6 +88,8 @@ inline Entity createEntity(std::mt19937& generator, float threshold)
 
   Entity e;
   e.active = dis(generator) < threshold;
+  e.id = generator();
+  memset(&e.debugname, 0, sizeof(e.debugname));
   e.position = Vec4{dis(generator),dis(generator),dis(generator),dis(generator)};
   e.velocity = Vec4{dis(generator),dis(generator),dis(generator),dis(generator)};
 
@@ -84,6 +115,11 @@ inline void setup(int num, float active, EntityVector& container)
   }  
 }
 
+inline void append(const Entity& e, EntityVector& container)
+{
+  container.push_back(e);
+}
+
 inline void update(EntityVector& container)
 {
   const size_t size = container.size();
@@ -102,10 +138,16 @@ inline void update(EntityVector& container)
 
 
 //=============================================================================
-// EntityVector
+// EntityArrays
 //=============================================================================
 
-using EntityArrays = johl::Arrays<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+template<typename TGrowth>
+using BasicEntityArrays = johl::BasicArrays<TGrowth, bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+using EntityArrays = BasicEntityArrays<johl::geometric_growth<>>;
+using EntityArraysExactGrowth = BasicEntityArrays<johl::exact_growth>;
+using EntityArraysBlockGrowth = BasicEntityArrays<johl::block_growth<1024>>;
+using EntityArraysDoubleGrowth = BasicEntityArrays<johl::geometric_growth<2, 1>>;
 
 inline void setup(int num, float active, EntityArrays& container)
 {
@@ -120,6 +162,49 @@ inline void setup(int num, float active, EntityArrays& container)
   }  
 }
 
+template<typename TGrowth>
+inline void append(const Entity& e, BasicEntityArrays<TGrowth>& container)
+{
+  container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+inline void update(size_t begin, size_t end, const bool* active, const Vec4* velocity, Vec4* position)
+{
+  for(size_t i=begin;i<end; ++i)
+  {
+    if(active[i])
+    {
+      position[i] += velocity[i] * 0.1f;
+    }
+  }
+}
+
+inline void parallelUpdate(EntityArrays& container, johl::ThreadPool& pool)
+{
+  auto f = [](size_t begin, size_t end, const bool* active, const Vec4* velocity, Vec4* position)
+  {
+    update(begin, end, active, velocity, position);
+  };
+
+  container.parallelForEach<0, 3, 2>(pool, f, 1<<14);
+}
+
+//same as update(EntityArrays&), but only visits the rows of selection (the
+//active rows, see johl::select)
+inline void updateSelected(EntityArrays& container, const johl::Selection& selection)
+{
+  johl::filter(container, selection).forEach<2, 3>([](Vec4& position, const Vec4& velocity)
+  {
+    position += velocity * 0.1f;
+  });
+}
+
+//same as update(EntityArrays&), but uses the vectorized kernels
+inline void updateKernels(EntityArrays& container)
+{
+  johl::kernels::maskedAxpy<2, 3, 0>(container, 0.1f);
+}
+
 inline void update(EntityArrays& container)
 {
   const size_t size = container.size();
@@ -137,6 +222,75 @@ inline void update(EntityArrays& container)
 }
 
 
+//=============================================================================
+// EntityColdArrays
+//=============================================================================
+
+//same as EntityArrays, the rarely used debug name is stored in its own block
+using EntityColdArrays = johl::Arrays<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, johl::cold<Name>>;
+
+inline void setup(int num, float active, EntityColdArrays& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+inline void append(const Entity& e, EntityColdArrays& container)
+{
+  container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+inline void update(EntityColdArrays& container)
+{
+  update(0, container.size(), container.data<0>(), container.data<3>(), container.data<2>());
+}
+
+
+//=============================================================================
+// EntityBitsArrays
+//=============================================================================
+
+//same as EntityArrays, the active flags are packed into 64 bit words
+using EntityBitsArrays = johl::Arrays<johl::bits, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+inline void setup(int num, float active, EntityBitsArrays& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+inline void append(const Entity& e, EntityBitsArrays& container)
+{
+  container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+//visits only the active rows, 64 inactive rows are skipped at once
+inline void update(EntityBitsArrays& container)
+{
+  const Vec4* velocity = container.data<3>();    
+  Vec4* position = container.data<2>();  
+
+  container.forEachSetBit<0>([=](size_t i)
+  {
+    position[i] += velocity[i] * 0.1f;
+  });
+}
+
+
 //=============================================================================
 // EntityArrays2
 //=============================================================================
@@ -171,3 +325,357 @@ inline void update(EntityArrays2& container)
     }
   }
 }
+
+
+//=============================================================================
+// EntityDeque
+//=============================================================================
+
+using EntityDeque = std::deque<Entity>;
+
+inline void setup(int num, float active, EntityDeque& container)
+{
+  std::mt19937 generator(0);
+  
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active );
+    container.push_back(e);
+  }  
+}
+
+inline void append(const Entity& e, EntityDeque& container)
+{
+  container.push_back(e);
+}
+
+inline void update(EntityDeque& container)
+{
+  for(Entity& e : container)
+  {
+    if(e.active)
+    {
+      e.position += e.velocity * 0.1f;
+    }
+  }
+}
+
+
+//=============================================================================
+// EntityChunkedArrays
+//=============================================================================
+
+using EntityChunkedArrays = johl::ChunkedArrays<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+inline void setup(int num, float active, EntityChunkedArrays& container)
+{
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+inline void append(const Entity& e, EntityChunkedArrays& container)
+{
+  container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+//same loop as update(EntityArrays&), once per chunk
+inline void update(EntityChunkedArrays& container)
+{
+  auto f = [](size_t begin, size_t end, const bool* active, const Vec4* velocity, Vec4* position)
+  {
+    update(begin, end, active, velocity, position);
+  };
+
+  container.forEachChunk<0, 3, 2>(f);
+}
+
+
+//=============================================================================
+// EntityTiledArrays
+//=============================================================================
+
+template<size_t TTileRows>
+using EntityTiledArrays = johl::TiledArrays<TTileRows, bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+template<size_t TTileRows>
+inline void setup(int num, float active, EntityTiledArrays<TTileRows>& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+template<size_t TTileRows>
+inline void append(const Entity& e, EntityTiledArrays<TTileRows>& container)
+{
+  container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+//same loop as update(EntityArrays&), once per tile
+template<size_t TTileRows>
+inline void update(EntityTiledArrays<TTileRows>& container)
+{
+  auto f = [](size_t begin, size_t end, const bool* active, const Vec4* velocity, Vec4* position)
+  {
+    update(begin, end, active, velocity, position);
+  };
+
+  container.template forEachTile<0, 3, 2>(f);
+}
+
+
+//=============================================================================
+// EntityHandleArrays
+//=============================================================================
+
+using EntityHandleArrays = johl::HandleArrays<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+inline void setup(int num, float active, EntityHandleArrays& container, std::vector<johl::Handle>& handles)
+{
+  container.reserve(num);
+  handles.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    handles.push_back(container.create(e.active, e.id, e.position, e.velocity, e.debugname));
+  }  
+}
+
+inline void setup(int num, float active, EntityHandleArrays& container)
+{
+  std::vector<johl::Handle> handles;
+  setup(num, active, container, handles);
+}
+
+//same loop as update(EntityArrays&), the rows are dense
+inline void update(EntityHandleArrays& container)
+{
+  update(0, container.size(), container.data<0>(), container.data<3>(), container.data<2>());
+}
+
+
+//=============================================================================
+// EntityIndexedArrays
+//=============================================================================
+
+//hash index on the ids
+using EntityIndexedArrays = johl::IndexedArrays<1, bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+//entities with a duplicate id are skipped
+inline void setup(int num, float active, EntityIndexedArrays& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+inline unsigned idAt(const EntityIndexedArrays& container, size_t row)
+{
+  return container.at<1>(row);
+}
+
+inline size_t findEntity(const EntityIndexedArrays& container, unsigned id)
+{
+  return container.find<1>(id);
+}
+
+inline bool appendEntity(EntityIndexedArrays& container, const Entity& e)
+{
+  return container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+inline void removeEntity(EntityIndexedArrays& container, size_t row)
+{
+  container.removeAtUnordered(row);
+}
+
+inline bool insertEntity(EntityIndexedArrays& container, size_t row, const Entity& e)
+{
+  return container.insertAt(row, e.active, e.id, e.position, e.velocity, e.debugname);
+}
+
+inline void removeEntityOrdered(EntityIndexedArrays& container, size_t row)
+{
+  container.removeAt(row);
+}
+
+//the same arrays with a side std::unordered_map from ids to rows
+struct EntityMappedArrays
+{
+  EntityArrays arrays;
+  std::unordered_map<unsigned, size_t> rows;
+
+  size_t size() const { return arrays.size(); }
+};
+
+inline unsigned idAt(const EntityMappedArrays& container, size_t row)
+{
+  return container.arrays.at<1>(row);
+}
+
+inline size_t findEntity(const EntityMappedArrays& container, unsigned id)
+{
+  const auto it = container.rows.find(id);
+  return it == container.rows.end() ? EntityIndexedArrays::npos : it->second;
+}
+
+inline bool appendEntity(EntityMappedArrays& container, const Entity& e)
+{
+  if(!container.rows.emplace(e.id, container.arrays.size()).second)
+    return false;
+
+  container.arrays.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  return true;
+}
+
+//swap-and-pop, the row of the moved entity is updated in the map
+inline void removeEntity(EntityMappedArrays& container, size_t row)
+{
+  const size_t last = container.arrays.size() - 1;
+  container.rows.erase(container.arrays.at<1>(row));
+  if(row != last)
+    container.rows[container.arrays.at<1>(last)] = row;
+
+  container.arrays.removeAtUnordered(row);
+}
+
+//the rows behind the inserted or removed row move, their map entries are
+//updated in one pass over the map
+inline bool insertEntity(EntityMappedArrays& container, size_t row, const Entity& e)
+{
+  if(container.rows.count(e.id) != 0)
+    return false;
+
+  for(auto& entry : container.rows)
+  {
+    if(entry.second >= row)
+      ++entry.second;
+  }
+
+  container.rows.emplace(e.id, row);
+  container.arrays.emplaceAt(row, e.active, e.id, e.position, e.velocity, e.debugname);
+  return true;
+}
+
+inline void removeEntityOrdered(EntityMappedArrays& container, size_t row)
+{
+  container.rows.erase(container.arrays.at<1>(row));
+  for(auto& entry : container.rows)
+  {
+    if(entry.second > row)
+      --entry.second;
+  }
+
+  container.arrays.removeAt(row);
+}
+
+inline void setup(int num, float active, EntityMappedArrays& container)
+{
+  container.arrays.reserve(num);
+  container.rows.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+    appendEntity(container, createEntity(generator, active));
+}
+
+
+//=============================================================================
+// EntityTrackedArrays
+//=============================================================================
+
+template<bool trackChanges>
+using EntityTrackedArrays = johl::BasicTrackedArrays<johl::geometric_growth<>, trackChanges, bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+template<bool trackChanges>
+inline void setup(int num, float active, EntityTrackedArrays<trackChanges>& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+
+  container.clearDirty();
+}
+
+
+//=============================================================================
+// EntitySnapshotArrays
+//=============================================================================
+
+using EntitySnapshotArrays = johl::SnapshotArrays<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+inline void setup(int num, float active, EntitySnapshotArrays& container)
+{
+  container.reserve(num);
+
+  std::mt19937 generator(0);
+
+  for(int i=0;i<num; ++i)
+  {
+    Entity e = createEntity(generator, active);
+    container.append(e.active, e.id, e.position, e.velocity, e.debugname);
+  }  
+}
+
+
+//=============================================================================
+// EntityArraysView
+//=============================================================================
+
+//read-only view of a file written by save(EntityArrays)
+using EntityArraysView = johl::ArraysView<bool, unsigned, johl::aligned<Vec4, 16>, aligned<Vec4, 16>, Name>;
+
+//sum of all positions of active entities, reads the arrays once
+inline float sumActivePositions(size_t num, const bool* active, const Vec4* position)
+{
+  float sum = 0.0f;
+  for(size_t i=0;i<num; ++i)
+  {
+    if(active[i])
+      sum += position[i].x + position[i].y + position[i].z;
+  }
+  return sum;
+}
+
+
+//=============================================================================
+// Allocators
+//=============================================================================
+
+//release everything at once (arena) or nothing to do (other allocators)
+inline void resetAllocator(johl::Allocator& allocator)
+{
+  unused(allocator);
+}
+
+inline void resetAllocator(johl::LinearArenaAllocator& allocator)
+{
+  allocator.reset();
+}
@@ -23,7 +23,968 @@ void BM_Sequential(benchmark::State& state) {
 
 BENCHMARK_TEMPLATE2(BM_Sequential, EntityVector, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
 BENCHMARK_TEMPLATE2(BM_Sequential, EntityArrays, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityColdArrays, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityBitsArrays, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityHandleArrays, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
 BENCHMARK_TEMPLATE2(BM_Sequential, EntityArrays2, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityChunkedArrays, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityDeque, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityTiledArrays<4>, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityTiledArrays<8>, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE2(BM_Sequential, EntityTiledArrays<16>, 16)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+
+//reads id, position and velocity of random rows, with SoA the three values
+//are in different cache lines (and pages) of large containers
+inline float readRow(const EntityVector& entities, unsigned i)
+{
+  const Entity& e = entities[i];
+  return (float)e.id + e.position.x + e.velocity.x;
+}
+
+inline float readRow(const EntityArrays& entities, unsigned i)
+{
+  return (float)entities.data<1>()[i] + entities.data<2>()[i].x + entities.data<3>()[i].x;
+}
+
+template<size_t TTileRows>
+inline float readRow(const EntityTiledArrays<TTileRows>& entities, unsigned i)
+{
+  return (float)entities.template at<1>(i) + entities.template at<2>(i).x + entities.template at<3>(i).x;
+}
+
+template <class Q> 
+void BM_RandomRow(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const int numLookups = 1<<16;
+
+  Q entities;
+  setup(num, 0.5f, entities);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  std::vector<unsigned> indices(numLookups);
+  for(unsigned& index : indices)
+    index = dis(generator);
+  
+  while (state.KeepRunning()) 
+  {    
+    float sum = 0.0f;
+    for(unsigned index : indices)
+      sum += readRow(entities, index);
+
+    benchmark::DoNotOptimize(sum);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * numLookups);
+}
+
+BENCHMARK_TEMPLATE(BM_RandomRow, EntityVector)->Range(minEntities, 1<<22);
+BENCHMARK_TEMPLATE(BM_RandomRow, EntityArrays)->Range(minEntities, 1<<22);
+BENCHMARK_TEMPLATE(BM_RandomRow, EntityTiledArrays<4>)->Range(minEntities, 1<<22);
+BENCHMARK_TEMPLATE(BM_RandomRow, EntityTiledArrays<8>)->Range(minEntities, 1<<22);
+BENCHMARK_TEMPLATE(BM_RandomRow, EntityTiledArrays<16>)->Range(minEntities, 1<<22);
+
+static const int maxHandleEntities = 1<<20;
+
+//destroy a random entity and create a new one, n entities stay alive
+void BM_HandleChurn(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntityHandleArrays entities;
+  std::vector<johl::Handle> handles;
+  setup(num, 0.5f, entities, handles);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  const Entity e = createEntity(generator, 0.5f);
+  
+  while (state.KeepRunning()) 
+  {    
+    const unsigned k = dis(generator);
+    entities.destroy(handles[k]);
+    handles[k] = entities.create(e.active, e.id, e.position, e.velocity, e.debugname);
+  }    
+
+  benchmark::DoNotOptimize(entities.size());
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HandleChurn)->Range(minEntities, maxHandleEntities);
+
+//random lookups by handle, after churn has shuffled the rows
+void BM_HandleLookup(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const int numLookups = 1<<16;
+
+  EntityHandleArrays entities;
+  std::vector<johl::Handle> handles;
+  setup(num, 0.5f, entities, handles);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  for(int i=0; i<num; ++i)
+  {
+    const unsigned k = dis(generator);
+    entities.destroy(handles[k]);
+    handles[k] = entities.create(true, (unsigned)k, Vec4{1.0f, 0.0f, 0.0f, 0.0f}, Vec4{1.0f, 0.0f, 0.0f, 0.0f}, Name());
+  }
+
+  std::vector<johl::Handle> lookups(numLookups);
+  for(johl::Handle& handle : lookups)
+    handle = handles[dis(generator)];
+  
+  while (state.KeepRunning()) 
+  {    
+    float sum = 0.0f;
+    for(johl::Handle handle : lookups)
+      sum += entities.at<2>(handle).x;
+
+    benchmark::DoNotOptimize(sum);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * numLookups);
+}
+
+BENCHMARK(BM_HandleLookup)->Range(minEntities, maxHandleEntities);
+
+static const int minIndexedEntities = 1<<16;
+static const int maxIndexedEntities = 1<<22;
+
+//mixed workload on an id index: 80% lookups of random ids, 10% appends of
+//new entities and 10% removes of random rows (swap-and-pop)
+template <typename TContainer> 
+void BM_IndexedMixed(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  TContainer entities;
+  setup(num, 0.5f, entities);
+
+  std::mt19937 generator(1);
+  std::vector<Entity> created;
+  for(int i=0; i<4096; ++i)
+    created.push_back(createEntity(generator, 0.5f));
+
+  size_t next = 0;
+  size_t found = 0;
+  while (state.KeepRunning()) 
+  {    
+    const unsigned op = generator() % 10;
+    if(op == 0)
+    {
+      //new random id, so the number of entities stays about the same
+      Entity& e = created[next];
+      e.id = generator();
+      appendEntity(entities, e);
+      next = (next + 1) % created.size();
+    }
+    else if(op == 1)
+    {
+      removeEntity(entities, generator() % entities.size());
+    }
+    else
+    {
+      found += findEntity(entities, idAt(entities, generator() % entities.size()));
+    }
+  }    
+
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_IndexedMixed, EntityIndexedArrays)->Range(minIndexedEntities, maxIndexedEntities);
+BENCHMARK_TEMPLATE(BM_IndexedMixed, EntityMappedArrays)->Range(minIndexedEntities, maxIndexedEntities);
+
+//ordered inserts and removes at random rows (half each), the index has to
+//follow the rows that move behind them
+template <typename TContainer> 
+void BM_IndexedOrdered(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  TContainer entities;
+  setup(num, 0.5f, entities);
+
+  std::mt19937 generator(1);
+  std::vector<Entity> created;
+  for(int i=0; i<4096; ++i)
+    created.push_back(createEntity(generator, 0.5f));
+
+  size_t next = 0;
+  while (state.KeepRunning()) 
+  {    
+    if(generator() % 2 == 0)
+    {
+      Entity& e = created[next];
+      e.id = generator();
+      insertEntity(entities, generator() % (entities.size() + 1), e);
+      next = (next + 1) % created.size();
+    }
+    else
+    {
+      removeEntityOrdered(entities, generator() % entities.size());
+    }
+  }    
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_IndexedOrdered, EntityIndexedArrays)->Range(1<<10, 1<<18);
+BENCHMARK_TEMPLATE(BM_IndexedOrdered, EntityMappedArrays)->Range(1<<10, 1<<18);
+
+//selects the active rows once per iteration, then runs 'passes' updates
+//over the selected rows (compare with 'passes' times BM_Sequential)
+template <int passes> 
+void BM_SequentialSelect(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const float active = static_cast<float>(state.range_y())/256.0f;
+
+  EntityArrays entities;
+  setup(num, active, entities);
+  johl::Selection selection;
+  
+  while (state.KeepRunning()) 
+  {    
+    johl::select<0>(entities, selection);
+    for(int pass=0; pass<passes; ++pass)
+      updateSelected(entities, selection);
+  }    
+}
+
+BENCHMARK_TEMPLATE(BM_SequentialSelect, 1)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE(BM_SequentialSelect, 4)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+
+//EntityArrays update with the simd kernels (levels that are not supported 
+//by the cpu fall back to the best supported level)
+template <johl::kernels::SimdLevel level> 
+void BM_SequentialKernels(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const float active = static_cast<float>(state.range_y())/256.0f;
+
+  const johl::kernels::SimdLevel detected = johl::kernels::detectSimdLevel();
+  johl::kernels::setSimdLevel(level);
+
+  EntityArrays entities;
+  setup(num, active, entities);
+  
+  while (state.KeepRunning()) 
+  {    
+    updateKernels(entities);
+  }    
+
+  johl::kernels::setSimdLevel(detected);
+}
+
+BENCHMARK_TEMPLATE(BM_SequentialKernels, johl::kernels::SimdLevel::Scalar)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE(BM_SequentialKernels, johl::kernels::SimdLevel::SSE2)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE(BM_SequentialKernels, johl::kernels::SimdLevel::AVX2)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+BENCHMARK_TEMPLATE(BM_SequentialKernels, johl::kernels::SimdLevel::AVX512)->RangePair(minEntities, maxEntities, minPercentage, maxPercentage);
+
+//append without reserving upfront, measures the growth policy of the container
+template <class Q> 
+void BM_Append(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  std::mt19937 generator(0);
+  std::vector<Entity> source;
+  source.reserve(num);
+  for(int i=0; i<num; ++i)
+    source.push_back(createEntity(generator, 0.5f));
+
+  while (state.KeepRunning()) 
+  {    
+    Q entities;
+    for(int i=0; i<num; ++i)
+      append(source[i], entities);
+
+    benchmark::DoNotOptimize(entities.size());
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+//exact and block growth are O(n^2), keep their range small enough to finish
+static const int maxAppendEntities = 1<<24;
+
+BENCHMARK_TEMPLATE(BM_Append, EntityVector)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityArrays)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityColdArrays)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityBitsArrays)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityArraysDoubleGrowth)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityArraysBlockGrowth)->Range(minEntities, maxEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityArraysExactGrowth)->Range(minEntities, maxEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityChunkedArrays)->Range(minEntities, maxAppendEntities);
+BENCHMARK_TEMPLATE(BM_Append, EntityDeque)->Range(minEntities, maxAppendEntities);
+
+//same as BM_Append<EntityArrays>, but the arena expands the block in place 
+//(all arrays of EntityArrays are trivially relocatable)
+void BM_AppendExpandInPlace(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  std::mt19937 generator(0);
+  std::vector<Entity> source;
+  source.reserve(num);
+  for(int i=0; i<num; ++i)
+    source.push_back(createEntity(generator, 0.5f));
+
+  johl::LinearArenaAllocator arena(sizeof(Entity) * maxAppendEntities);
+
+  while (state.KeepRunning()) 
+  {    
+    {
+      EntityArrays entities(&arena);
+      for(int i=0; i<num; ++i)
+        append(source[i], entities);
+
+      benchmark::DoNotOptimize(entities.size());
+    }
+    arena.reset();
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK(BM_AppendExpandInPlace)->Range(minEntities, maxAppendEntities);
+
+//non-trivial columns: append (by value) vs. emplaceBack (in place)
+using HeavyArrays = johl::Arrays<std::string, std::vector<int>, std::string>;
+
+template <bool Emplace> 
+void BM_AppendHeavy(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const std::string name(64, 'x');
+  const std::vector<int> values(32, 1);
+
+  while (state.KeepRunning()) 
+  {    
+    HeavyArrays arrays;
+    arrays.reserve(num);
+
+    for(int i=0; i<num; ++i)
+    {
+      if(Emplace)
+        arrays.emplaceBack(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(values), std::forward_as_tuple(64, 'y'));
+      else
+        arrays.append(name, values, std::string(64, 'y'));
+    }
+
+    benchmark::DoNotOptimize(arrays.data<0>());
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE(BM_AppendHeavy, false)->Range(minEntities, maxEntities);
+BENCHMARK_TEMPLATE(BM_AppendHeavy, true)->Range(minEntities, maxEntities);
+
+//remove all inactive entities (range_y is the percentage of entities to remove)
+enum class Remove 
+{
+  At,
+  AtUnordered,
+  If
+};
+
+template <Remove method> 
+void BM_Remove(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const float active = 1.0f - static_cast<float>(state.range_y())/100.0f;
+
+  EntityArrays source;
+  setup(num, active, source);
+  EntityArrays entities;
+  entities.reserve(num);
+
+  while (state.KeepRunning()) 
+  {    
+    state.PauseTiming();
+    entities = source;
+    state.ResumeTiming();
+
+    const bool* flags = entities.data<0>();
+
+    switch(method)
+    {
+    case Remove::At:
+      for(size_t i = entities.size(); i > 0; --i)
+        if(!flags[i - 1])
+          entities.removeAt(i - 1);
+      break;
+    case Remove::AtUnordered:
+      for(size_t i = entities.size(); i > 0; --i)
+        if(!flags[i - 1])
+          entities.removeAtUnordered(i - 1);
+      break;
+    case Remove::If:
+      entities.removeIf([=](size_t i) { return !flags[i]; });
+      break;
+    }
+
+    benchmark::DoNotOptimize(entities.size());
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE(BM_Remove, Remove::At)->RangePair(minEntities, maxEntities, 1, 50);
+BENCHMARK_TEMPLATE(BM_Remove, Remove::AtUnordered)->RangePair(minEntities, maxEntities, 1, 50);
+BENCHMARK_TEMPLATE(BM_Remove, Remove::If)->RangePair(minEntities, maxEntities, 1, 50);
+
+//sort all entities by id
+template <bool Stable> 
+void sortById(EntityVector& entities)
+{
+  auto cmp = [](const Entity& a, const Entity& b) { return a.id < b.id; };
+  if(Stable)
+    std::stable_sort(entities.begin(), entities.end(), cmp);
+  else
+    std::sort(entities.begin(), entities.end(), cmp);
+}
+
+//Stable: radix sort, otherwise comparison sort
+template <bool Stable> 
+void sortById(EntityArrays& entities)
+{
+  if(Stable)
+    entities.stableSortBy<1>();
+  else
+    entities.sortBy<1>(std::less<unsigned>());
+}
+
+template <class Q, bool Stable> 
+void BM_Sort(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  Q source;
+  setup(num, 0.5f, source);
+  Q entities;
+
+  while (state.KeepRunning()) 
+  {    
+    state.PauseTiming();
+    entities = source;
+    state.ResumeTiming();
+
+    sortById<Stable>(entities);
+    benchmark::DoNotOptimize(entities.size());
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+static const int maxSortEntities = 1<<20;
+
+BENCHMARK_TEMPLATE2(BM_Sort, EntityVector, false)->Range(minEntities, maxSortEntities);
+BENCHMARK_TEMPLATE2(BM_Sort, EntityVector, true)->Range(minEntities, maxSortEntities);
+BENCHMARK_TEMPLATE2(BM_Sort, EntityArrays, false)->Range(minEntities, maxSortEntities);
+BENCHMARK_TEMPLATE2(BM_Sort, EntityArrays, true)->Range(minEntities, maxSortEntities);
+
+//scaling of parallelForEach, range_y is the number of threads
+void BM_ParallelUpdate(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const size_t threads = state.range_y();
+
+  johl::ThreadPool pool(threads);
+  EntityArrays entities;
+  setup(num, 0.5f, entities);
+  
+  while (state.KeepRunning()) 
+  {    
+    parallelUpdate(entities, pool);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+static void parallelArgs(benchmark::internal::Benchmark* b)
+{
+  const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  for(int num = 1<<20; num <= 1<<24; num *= 4)
+  {
+    for(int threads = 1; threads < maxThreads; threads *= 2)
+      b->ArgPair(num, threads);
+    b->ArgPair(num, maxThreads);
+  }
+}
+
+BENCHMARK(BM_ParallelUpdate)->Apply(parallelArgs)->UseRealTime();
+
+//build and destroy many small tables (range_x rows each, appended row by row)
+template <class TAllocator> 
+void BM_AllocatorChurn(benchmark::State& state) {   
+
+  const int numTables = 1000;
+  const int num = state.range_x();
+
+  std::mt19937 generator(0);
+  const Entity e = createEntity(generator, 0.5f);
+
+  TAllocator allocator;
+  std::vector<EntityArrays> tables;
+  tables.reserve(numTables);
+
+  while (state.KeepRunning()) 
+  {    
+    for(int t=0; t<numTables; ++t)
+    {
+      tables.emplace_back(&allocator);
+      for(int i=0; i<num; ++i)
+        append(e, tables.back());
+    }
+
+    benchmark::DoNotOptimize(tables.back().data<0>());
+    tables.clear();
+    resetAllocator(allocator);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * numTables);
+}
+
+BENCHMARK_TEMPLATE(BM_AllocatorChurn, johl::MallocAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorChurn, johl::LinearArenaAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorChurn, johl::FreeListPoolAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorChurn, johl::ThreadLocalCachingAllocator)->Range(1, 1<<10);
+
+//short lived scratch tables: each table is destroyed before the next one is 
+//built (and the arena is reset)
+template <class TAllocator> 
+void BM_AllocatorScratch(benchmark::State& state) {   
+
+  const int numTables = 1000;
+  const int num = state.range_x();
+
+  std::mt19937 generator(0);
+  const Entity e = createEntity(generator, 0.5f);
+
+  TAllocator allocator;
+
+  while (state.KeepRunning()) 
+  {    
+    for(int t=0; t<numTables; ++t)
+    {
+      EntityArrays table(&allocator);
+      for(int i=0; i<num; ++i)
+        append(e, table);
+
+      benchmark::DoNotOptimize(table.data<0>());
+      resetAllocator(allocator);
+    }
+  }    
+
+  state.SetItemsProcessed(state.iterations() * numTables);
+}
+
+BENCHMARK_TEMPLATE(BM_AllocatorScratch, johl::MallocAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorScratch, johl::LinearArenaAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorScratch, johl::FreeListPoolAllocator)->Range(1, 1<<10);
+BENCHMARK_TEMPLATE(BM_AllocatorScratch, johl::ThreadLocalCachingAllocator)->Range(1, 1<<10);
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+static const int minLargeRows = 1<<20;
+static const int maxLargeRows = 1<<27;
+
+//large containers: malloc (Mmap == false) or one reserved virtual range per container
+template <bool Mmap, bool HugePages> 
+struct LargeAllocator
+{
+  LargeAllocator()
+    : mmap(johl::MmapAllocator::hugePageSize * 1024, HugePages)
+  {
+  }
+
+  johl::Allocator* get()
+  {
+    return Mmap ? static_cast<johl::Allocator*>(&mmap) : johl::Allocator::defaultAllocator();
+  }
+
+  johl::MmapAllocator mmap;
+};
+
+//appending rows one by one, reallocations copy all rows unless the allocator
+//reserved enough address space up front
+template <bool Mmap, bool HugePages> 
+void BM_GrowLarge(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  LargeAllocator<Mmap, HugePages> allocator;
+  
+  while (state.KeepRunning()) 
+  {
+    Arrays<int, float> arrays(allocator.get());
+    for(int i=0; i<num; ++i)
+      arrays.append(i, 1.0f);
+
+    benchmark::DoNotOptimize(arrays.data<0>());
+  }
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE2(BM_GrowLarge, false, false)->Range(minLargeRows, maxLargeRows);
+BENCHMARK_TEMPLATE2(BM_GrowLarge, true, true)->Range(minLargeRows, maxLargeRows);
+
+//gathers 1<<20 random rows, dominated by cache and TLB misses once the array
+//is larger than the reach of the TLB
+template <bool Mmap, bool HugePages> 
+void BM_RandomAccess(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const int numLookups = 1<<20;
+  LargeAllocator<Mmap, HugePages> allocator;
+
+  Arrays<float> arrays(allocator.get());
+  arrays.reserve(num);
+  for(int i=0; i<num; ++i)
+    arrays.append((float)i);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  std::vector<unsigned> indices(numLookups);
+  for(unsigned& index : indices)
+    index = dis(generator);
+
+  const float* data = arrays.data<0>();
+  
+  while (state.KeepRunning()) 
+  {
+    float sum = 0.0f;
+    for(unsigned index : indices)
+      sum += data[index];
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * numLookups);
+}
+
+BENCHMARK_TEMPLATE2(BM_RandomAccess, false, false)->Range(minLargeRows, maxLargeRows);
+BENCHMARK_TEMPLATE2(BM_RandomAccess, true, false)->Range(minLargeRows, maxLargeRows);
+BENCHMARK_TEMPLATE2(BM_RandomAccess, true, true)->Range(minLargeRows, maxLargeRows);
+#endif
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+static const char* entitiesBinaryPath = "benchmark_entities.bin";
+static const char* entitiesTextPath = "benchmark_entities.txt";
+
+//writes num entities as binary file (save) and as text file (one row per line)
+inline void writeEntityFiles(int num)
+{
+  EntityArrays entities;
+  setup(num, 0.5f, entities);
+  johl::save(entities, entitiesBinaryPath);
+
+  std::ofstream text(entitiesTextPath);
+  for(size_t i=0; i<entities.size(); ++i)
+  {
+    const Vec4& p = entities.at<2>(i);
+    const Vec4& v = entities.at<3>(i);
+    text << entities.at<0>(i) << ' ' << entities.at<1>(i) << ' '
+         << p.x << ' ' << p.y << ' ' << p.z << ' ' << p.w << ' '
+         << v.x << ' ' << v.y << ' ' << v.z << ' ' << v.w << '\n';
+  }
+}
+
+//open the file and touch the positions of all active entities once
+void BM_LoadView(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  writeEntityFiles(num);
+
+  while (state.KeepRunning()) 
+  {    
+    EntityArraysView entities(entitiesBinaryPath);
+    benchmark::DoNotOptimize(sumActivePositions(entities.size(), entities.data<0>(), entities.data<2>()));
+  }    
+
+  std::remove(entitiesBinaryPath);
+  std::remove(entitiesTextPath);
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+//parse the text file and append row by row, then touch the positions once
+void BM_LoadParse(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  writeEntityFiles(num);
+
+  while (state.KeepRunning()) 
+  {    
+    std::ifstream text(entitiesTextPath);
+    EntityArrays entities;
+
+    bool active;
+    unsigned id;
+    Vec4 p, v;
+    while(text >> active >> id >> p.x >> p.y >> p.z >> p.w >> v.x >> v.y >> v.z >> v.w)
+      entities.append(active, id, p, v, Name());
+
+    benchmark::DoNotOptimize(sumActivePositions(entities.size(), entities.data<0>(), entities.data<2>()));
+  }    
+
+  std::remove(entitiesBinaryPath);
+  std::remove(entitiesTextPath);
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK(BM_LoadView)->Range(1<<10, 1<<20);
+BENCHMARK(BM_LoadParse)->Range(1<<10, 1<<20);
+#endif
+
+//column reductions: hand written loops (std::accumulate on array<N>()),
+//johl/Reduce.h and johl/Reduce.h on the default thread pool
+enum ReduceMode
+{
+  ReduceLoop,
+  ReduceSimd,
+  ReduceParallel
+};
+
+template <ReduceMode mode> 
+void BM_SumIds(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntityArrays entities;
+  setup(num, 0.5f, entities);
+  
+  while (state.KeepRunning()) 
+  {    
+    unsigned sum = 0;
+    if(mode == ReduceLoop)
+      sum = std::accumulate(entities.array<1>().begin(), entities.array<1>().end(), 0u);
+    else if(mode == ReduceSimd)
+      sum = johl::sum<1>(entities);
+    else
+      sum = johl::sum<1>(johl::ThreadPool::defaultPool(), entities);
+
+    benchmark::DoNotOptimize(sum);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+inline Vec4 minVec4(const Vec4& a, const Vec4& b)
+{
+  return Vec4{std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w)};
+}
+
+inline Vec4 maxVec4(const Vec4& a, const Vec4& b)
+{
+  return Vec4{std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w)};
+}
+
+//bounds of the positions
+template <ReduceMode mode> 
+void BM_Bounds(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntityArrays entities;
+  setup(num, 0.5f, entities);
+  
+  while (state.KeepRunning()) 
+  {    
+    std::pair<Vec4, Vec4> bounds;
+    if(mode == ReduceLoop)
+    {
+      const Vec4 first = entities.at<2>(0);
+      bounds.first = std::accumulate(entities.array<2>().begin(), entities.array<2>().end(), first, minVec4);
+      bounds.second = std::accumulate(entities.array<2>().begin(), entities.array<2>().end(), first, maxVec4);
+    }
+    else if(mode == ReduceSimd)
+      bounds = johl::minMax<2>(entities);
+    else
+      bounds = johl::minMax<2>(johl::ThreadPool::defaultPool(), entities);
+
+    benchmark::DoNotOptimize(bounds);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+//histogram of the ids in 256 bins
+template <ReduceMode mode> 
+void BM_HistogramIds(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntityArrays entities;
+  setup(num, 0.5f, entities);
+  const unsigned* ids = entities.data<1>();
+  size_t counts[256];
+  
+  while (state.KeepRunning()) 
+  {    
+    if(mode == ReduceLoop)
+    {
+      std::fill(counts, counts + 256, 0);
+      for(int i=0; i<num; ++i)
+        ++counts[ids[i] & 255];
+    }
+    else if(mode == ReduceSimd)
+      johl::histogram<1>(entities, 256, [](unsigned id) { return (size_t)(id & 255); }, counts);
+    else
+      johl::histogram<1>(johl::ThreadPool::defaultPool(), entities, 256, [](unsigned id) { return (size_t)(id & 255); }, counts);
+
+    benchmark::DoNotOptimize(counts);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE(BM_SumIds, ReduceLoop)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_SumIds, ReduceSimd)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_SumIds, ReduceParallel)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_Bounds, ReduceLoop)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_Bounds, ReduceSimd)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_Bounds, ReduceParallel)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_HistogramIds, ReduceLoop)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_HistogramIds, ReduceSimd)->Range(1<<10, 1<<22);
+BENCHMARK_TEMPLATE(BM_HistogramIds, ReduceParallel)->Range(1<<10, 1<<22);
+
+//random lookups in a sorted array of timestamps
+template <bool eytzinger> 
+void BM_LowerBound(benchmark::State& state) {   
+
+  const int num = state.range_x();
+  const int numLookups = 1<<16;
+
+  std::mt19937 generator(0);
+  Arrays<unsigned> timestamps;
+  timestamps.reserve(num);
+  unsigned t = 0;
+  for(int i=0; i<num; ++i)
+  {
+    t += 1 + generator() % 8;
+    timestamps.append(t);
+  }
+
+  johl::SearchIndex<unsigned> index;
+  index.build<0>(timestamps);
+
+  std::uniform_int_distribution<unsigned> dis(0, t);
+  std::vector<unsigned> lookups(numLookups);
+  for(unsigned& lookup : lookups)
+    lookup = dis(generator);
+  
+  while (state.KeepRunning()) 
+  {    
+    size_t sum = 0;
+    if(eytzinger)
+    {
+      for(unsigned lookup : lookups)
+        sum += index.lowerBound(lookup);
+    }
+    else
+    {
+      const unsigned* begin = timestamps.data<0>();
+      const unsigned* end = begin + timestamps.size();
+      for(unsigned lookup : lookups)
+        sum += std::lower_bound(begin, end, lookup) - begin;
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }    
+
+  state.SetItemsProcessed(state.iterations() * numLookups);
+}
+
+BENCHMARK_TEMPLATE(BM_LowerBound, false)->Range(1<<10, 1<<26);
+BENCHMARK_TEMPLATE(BM_LowerBound, true)->Range(1<<10, 1<<26);
+
+//moves 1% of the entities, then copies the changed positions to a second
+//buffer (e.g. for rendering): only the dirty rows with change tracking,
+//all rows without
+template <bool trackChanges> 
+void BM_DirtyUpdate(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntityTrackedArrays<trackChanges> entities;
+  setup(num, 0.5f, entities);
+  std::vector<Vec4> positions(num);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  std::vector<unsigned> moved(num / 100 + 1);
+  for(unsigned& row : moved)
+    row = dis(generator);
+
+  const Vec4 offset{0.1f, 0.0f, 0.0f, 0.0f};
+  while (state.KeepRunning()) 
+  {    
+    for(unsigned row : moved)
+      entities.template at<2>(row) += offset;
+
+    const Vec4* position = entities.template data<2>();
+    entities.template forEachDirty<2>([&](size_t i) { positions[i] = position[i]; });
+    entities.template clearDirty<2>();
+  }    
+
+  benchmark::DoNotOptimize(positions.data());
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE(BM_DirtyUpdate, false)->Range(1<<10, 1<<20);
+BENCHMARK_TEMPLATE(BM_DirtyUpdate, true)->Range(1<<10, 1<<20);
+
+//hands the entities to a reader (e.g. the render thread) and moves 1% of 
+//them: a copy-on-write snapshot (copies the positions on the first write)
+//against a full copy of all arrays
+template <bool snapshot> 
+void BM_SnapshotUpdate(benchmark::State& state) {   
+
+  const int num = state.range_x();
+
+  EntitySnapshotArrays snapshotEntities;
+  EntityArrays entities;
+  setup(num, 0.5f, snapshotEntities);
+  setup(num, 0.5f, entities);
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<unsigned> dis(0, num - 1);
+  std::vector<unsigned> moved(num / 100 + 1);
+  for(unsigned& row : moved)
+    row = dis(generator);
+
+  const Vec4 offset{0.1f, 0.0f, 0.0f, 0.0f};
+  while (state.KeepRunning()) 
+  {    
+    if(snapshot)
+    {
+      EntitySnapshotArrays::Snapshot copy = snapshotEntities.snapshot();
+      for(unsigned row : moved)
+        snapshotEntities.at<2>(row) += offset;
+
+      benchmark::DoNotOptimize(copy.data<2>());
+    }
+    else
+    {
+      EntityArrays copy(entities);
+      for(unsigned row : moved)
+        entities.at<2>(row) += offset;
+
+      benchmark::DoNotOptimize(copy.data<2>());
+    }
+  }    
+
+  state.SetItemsProcessed(state.iterations() * num);
+}
+
+BENCHMARK_TEMPLATE(BM_SnapshotUpdate, false)->Range(1<<10, 1<<20);
+BENCHMARK_TEMPLATE(BM_SnapshotUpdate, true)->Range(1<<10, 1<<20);
 
 bool verify()
 {
@@ -41,11 +1002,96 @@ bool verify()
   update(entityArrays);
   update(entityArrays2);
 
+  EntityArrays parallelArrays;
+  setup(num, active, parallelArrays);
+  johl::ThreadPool pool(4);
+  parallelUpdate(parallelArrays, pool);
+
+  EntityArrays kernelArrays;
+  setup(num, active, kernelArrays);
+  updateKernels(kernelArrays);
+
+  EntityArrays selectedArrays;
+  setup(num, active, selectedArrays);
+  updateSelected(selectedArrays, johl::select<0>(selectedArrays));
+
+  EntityChunkedArrays chunkedArrays;
+  setup(num, active, chunkedArrays);
+  update(chunkedArrays);
+
+  EntityTiledArrays<8> tiledArrays;
+  setup(num, active, tiledArrays);
+  update(tiledArrays);
+
+  EntityColdArrays coldArrays;
+  setup(num, active, coldArrays);
+  update(coldArrays);
+
+  EntityBitsArrays bitsArrays;
+  setup(num, active, bitsArrays);
+  update(bitsArrays);
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+  {
+    writeEntityFiles(num);
+    EntityArraysView view(entitiesBinaryPath);
+    std::remove(entitiesBinaryPath);
+    std::remove(entitiesTextPath);
+
+    if(view.size() != entityArrays.size())
+      return false;
+
+    EntityArrays loaded;
+    setup(num, active, loaded);
+    for(int i=0; i<num; ++i)
+    {
+      if(view.at<0>(i) != loaded.at<0>(i) || view.at<1>(i) != loaded.at<1>(i) || view.at<2>(i).x != loaded.at<2>(i).x)
+        return false;
+    }
+  }
+#endif
+
+  EntityHandleArrays handleArrays;
+  setup(num, active, handleArrays);
+  update(handleArrays);
+
   for(int i=0; i<num; ++i)
   {
     Vec4 posVector = entityVector[i].position;
     Vec4 posArrays = entityArrays.data<2>()[i];
     Vec4 posArrays2 = entityArrays2.data<2>()[i].position;
+    Vec4 posParallel = parallelArrays.data<2>()[i];
+
+    if(posArrays.x != posParallel.x || posArrays.y != posParallel.y || posArrays.z != posParallel.z)
+      return false;
+
+    Vec4 posKernel = kernelArrays.data<2>()[i];
+    if(posArrays.x != posKernel.x || posArrays.y != posKernel.y || posArrays.z != posKernel.z)
+      return false;
+
+    Vec4 posSelected = selectedArrays.at<2>(i);
+    if(posArrays.x != posSelected.x || posArrays.y != posSelected.y || posArrays.z != posSelected.z)
+      return false;
+
+    Vec4 posChunked = chunkedArrays.at<2>(i);
+    if(posArrays.x != posChunked.x || posArrays.y != posChunked.y || posArrays.z != posChunked.z)
+      return false;
+
+    Vec4 posTiled = tiledArrays.at<2>(i);
+    if(posArrays.x != posTiled.x || posArrays.y != posTiled.y || posArrays.z != posTiled.z)
+      return false;
+
+    Vec4 posCold = coldArrays.at<2>(i);
+    if(posArrays.x != posCold.x || posArrays.y != posCold.y || posArrays.z != posCold.z)
+      return false;
+
+    Vec4 posBits = bitsArrays.at<2>(i);
+    if(posArrays.x != posBits.x || posArrays.y != posBits.y || posArrays.z != posBits.z)
+      return false;
+
+    Vec4 posHandle = handleArrays.at<2>(i);
+    if(posArrays.x != posHandle.x || posArrays.y != posHandle.y || posArrays.z != posHandle.z)
+      return false;
 
     if(abs(posVector.x - posArrays.x) > 0.001)
       return false;
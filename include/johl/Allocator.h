@@ -1,5 +1,9 @@
 #pragma  once
 #include <stdlib.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <johl/detail/Arrays.h>
 
 namespace johl
 {
@@ -12,9 +16,37 @@ namespace johl
     Allocator(const Allocator&) = delete;
     Allocator& operator=(const Allocator&) = delete;
 
+    //returns memory aligned to at least alignof(std::max_align_t) (like malloc)
     virtual void* allocate(size_t size) = 0;
     virtual void deallocate(void* p) = 0;
 
+    //returns memory aligned to alignment (power of two), must be released
+    //with deallocateSized (same size and alignment).
+    //The default implementations are based on allocate/deallocate.
+    virtual void* allocateAligned(size_t size, size_t alignment);
+    virtual void deallocateSized(void* p, size_t size, size_t alignment);
+
+    //same as allocateAligned, but the allocator may hand out a larger block
+    //(e.g. a rounded size class or a whole reserved address range). 
+    //allocatedSize is set to the usable size, any size between the requested
+    //and the usable size may be passed to deallocateSized/tryExpand/reallocate.
+    virtual void* allocateAtLeast(size_t size, size_t alignment, size_t& allocatedSize);
+
+    //grow a block from allocateAligned from oldSize to newSize bytes without 
+    //moving it. returns false if that is not possible (default).
+    virtual bool tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment);
+
+    //resize a block from allocateAligned (p may be nullptr). The first 
+    //min(oldSize, newSize) bytes are kept, they are copied bytewise if the
+    //block has to be moved.
+    virtual void* reallocate(void* p, size_t oldSize, size_t newSize, size_t alignment);
+
+    //hint: the contents of [p, p + size) inside of an allocated block are no
+    //longer needed. The allocator may return whole pages in that range to 
+    //the operating system, they stay usable but their contents are lost. 
+    //Does nothing by default.
+    virtual void decommit(void* p, size_t size);
+
     static Allocator* defaultAllocator();
   };
 
@@ -34,11 +66,78 @@ namespace johl
     {
       ::free(p);
     }
+
+    //realloc extends the block in place if possible
+    virtual void* reallocate(void* p, size_t oldSize, size_t newSize, size_t alignment) override
+    {
+      if (alignment <= alignof(std::max_align_t))
+        return ::realloc(p, newSize);
+
+      return Allocator::reallocate(p, oldSize, newSize, alignment);
+    }
   };
 
+  //stricter alignments than malloc's: allocate alignment extra bytes and 
+  //store the pointer returned by allocate in front of the aligned block
+  inline void* Allocator::allocateAligned(size_t size, size_t alignment)
+  {
+    if (alignment <= alignof(std::max_align_t))
+      return allocate(size);
+
+    char* p = static_cast<char*>(allocate(size + alignment));
+    void** aligned = reinterpret_cast<void**>(detail::alignUp((std::uintptr_t)p + sizeof(void*), alignment));
+    aligned[-1] = p;
+    return aligned;
+  }
+
+  inline void Allocator::deallocateSized(void* p, size_t size, size_t alignment)
+  {
+    detail::unused(size);
+
+    if (!p)
+      return;
+
+    if (alignment <= alignof(std::max_align_t))
+      deallocate(p);
+    else
+      deallocate(static_cast<void**>(p)[-1]);
+  }
+
+  inline void* Allocator::allocateAtLeast(size_t size, size_t alignment, size_t& allocatedSize)
+  {
+    allocatedSize = size;
+    return allocateAligned(size, alignment);
+  }
+
+  inline bool Allocator::tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    detail::unused(p, oldSize, newSize, alignment);
+    return false;
+  }
+
+  inline void* Allocator::reallocate(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    if (p && tryExpand(p, oldSize, newSize, alignment))
+      return p;
+
+    void* q = allocateAligned(newSize, alignment);
+    if (p)
+    {
+      memcpy(q, p, oldSize < newSize ? oldSize : newSize);
+      deallocateSized(p, oldSize, alignment);
+    }
+
+    return q;
+  }
+
   inline Allocator* Allocator::defaultAllocator()
   {
     static MallocAllocator a; //threadsafe since C+11, thanks to 'magic statics'
     return &a;
   }
+
+  inline void Allocator::decommit(void* p, size_t size)
+  {
+    detail::unused(p, size);
+  }
 }
\ No newline at end of file
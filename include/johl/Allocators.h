@@ -0,0 +1,563 @@
+#pragma once
+#include <johl/Allocator.h>
+#include <johl/detail/Arrays.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace johl
+{
+  namespace detail
+  {
+  namespace allocators
+  {
+    //every block starts with a header that stores its size class, the header
+    //size keeps the returned pointers aligned to alignof(max_align_t)
+    static const size_t headerSize = alignof(std::max_align_t);
+    static const size_t minClassShift = 5;
+    static const size_t numClasses = 12;
+    static const size_t largeClass = numClasses;
+
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    //size class of an allocation, largeClass if it exceeds the largest class
+    inline size_t sizeClass(size_t size)
+    {
+      size_t c = 0;
+      while (c < numClasses && ((size_t)1 << (minClassShift + c)) < size)
+        ++c;
+
+      return c;
+    }
+
+    inline size_t classSize(size_t sizeClass)
+    {
+      return (size_t)1 << (minClassShift + sizeClass);
+    }
+
+    inline void* writeHeader(void* block, size_t sizeClass)
+    {
+      *static_cast<size_t*>(block) = sizeClass;
+      return static_cast<char*>(block) + headerSize;
+    }
+
+    inline void* blockOf(void* p)
+    {
+      return static_cast<char*>(p) - headerSize;
+    }
+
+    inline size_t readHeader(void* p)
+    {
+      return *static_cast<size_t*>(blockOf(p));
+    }
+
+    //blocks are rounded up to their size class, so they can grow up to the 
+    //size of the class without moving
+    inline bool fitsInBlock(void* p, size_t newSize, size_t alignment)
+    {
+      if (alignment > alignof(std::max_align_t))
+        return false; //p is not the begin of the block (see Allocator::allocateAligned)
+
+      const size_t c = readHeader(p);
+      return c != largeClass && newSize <= classSize(c);
+    }
+
+    inline void push(void*& list, void* block)
+    {
+      static_cast<FreeBlock*>(block)->next = static_cast<FreeBlock*>(list);
+      list = block;
+    }
+
+    inline void* pop(void*& list)
+    {
+      FreeBlock* block = static_cast<FreeBlock*>(list);
+      list = block->next;
+      return block;
+    }
+  }
+  }
+
+  /**
+   * Bump allocator: allocate moves a pointer forward in a block of memory,
+   * deallocate does nothing (except for the most recent allocation, which is
+   * rolled back). The most recent allocation can be expanded in place as long
+   * as the current block has room for it. reset() releases all allocations at
+   * once in O(1) and keeps the blocks for reuse.
+   * Blocks of (at least) blockSize bytes are requested from upstream on
+   * demand and returned in the destructor.
+   * Not threadsafe.
+   */
+  class LinearArenaAllocator final : public Allocator
+  {
+  public:
+    explicit LinearArenaAllocator(size_t blockSize = 1 << 16, Allocator* upstream = Allocator::defaultAllocator());
+    virtual ~LinearArenaAllocator();
+
+    virtual void* allocate(size_t size) override;
+    virtual void deallocate(void* p) override;
+    virtual void* allocateAligned(size_t size, size_t alignment) override;
+    virtual void deallocateSized(void* p, size_t size, size_t alignment) override;
+    virtual bool tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment) override;
+
+    //all memory allocated so far becomes invalid
+    void reset();
+
+    //sum of the sizes of all blocks
+    size_t capacity() const;
+
+  private:
+    struct Block
+    {
+      Block* next;
+      size_t size;
+    };
+
+    static size_t blockHeader();
+    static char* begin(Block* block);
+    void nextBlock(size_t size);
+
+    Allocator* m_upstream;
+    size_t m_blockSize;
+    Block* m_first;
+    Block* m_current;
+    char* m_pos;
+    char* m_end;
+    void* m_last;
+  };
+
+  /**
+   * Pool allocator for many small allocations. Sizes are rounded up to size
+   * classes (powers of two from 32 bytes to 64 KiB), each size class has its
+   * own free list. Free lists are refilled by carving blocks from slabs of
+   * (at least) slabSize bytes that are requested from upstream. Larger
+   * allocations are passed through to upstream.
+   * Slabs are returned to upstream in the destructor.
+   * Not threadsafe.
+   */
+  class FreeListPoolAllocator final : public Allocator
+  {
+  public:
+    explicit FreeListPoolAllocator(size_t slabSize = 1 << 16, Allocator* upstream = Allocator::defaultAllocator());
+    virtual ~FreeListPoolAllocator();
+
+    virtual void* allocate(size_t size) override;
+    virtual void deallocate(void* p) override;
+    virtual bool tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment) override;
+
+  private:
+    void refill(size_t sizeClass);
+
+    Allocator* m_upstream;
+    size_t m_slabSize;
+    void* m_slabs;
+    void* m_free[detail::allocators::numClasses];
+  };
+
+  /**
+   * Adds a small per thread cache of freed blocks (per size class, see
+   * FreeListPoolAllocator) in front of a threadsafe upstream allocator.
+   * allocate and deallocate only touch the cache of the calling thread and
+   * do not lock, unless the cache is empty/full and upstream is called.
+   * A block may be deallocated by another thread than the one that allocated
+   * it.
+   * Cached blocks are returned to upstream when a thread exits and in the
+   * destructor. The allocator must not be destroyed while other threads
+   * still use it.
+   */
+  class ThreadLocalCachingAllocator final : public Allocator
+  {
+  public:
+    explicit ThreadLocalCachingAllocator(Allocator* upstream = Allocator::defaultAllocator(), size_t maxCachedBlocks = 32);
+    virtual ~ThreadLocalCachingAllocator();
+
+    virtual void* allocate(size_t size) override;
+    virtual void deallocate(void* p) override;
+    virtual bool tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment) override;
+
+  private:
+    struct Cache
+    {
+      size_t owner;        //id of the allocator, never changes
+      Allocator* upstream; //nullptr after the allocator was destroyed
+      bool threadExited;   //set when the owning thread exited
+      void* blocks[detail::allocators::numClasses];
+      size_t counts[detail::allocators::numClasses];
+    };
+
+    using CacheList = std::vector<std::shared_ptr<Cache>>;
+
+    struct ThreadCaches
+    {
+      CacheList caches;
+      ~ThreadCaches();
+    };
+
+    static std::mutex& registryMutex();
+    static ThreadCaches& threadCaches();
+    static void release(Cache& cache);
+
+    Cache& cache();
+
+    Allocator* m_upstream;
+    size_t m_maxCachedBlocks;
+    size_t m_id;
+    CacheList m_caches;
+  };
+
+  //============================================================================
+
+  inline LinearArenaAllocator::LinearArenaAllocator(size_t blockSize, Allocator* upstream)
+    : m_upstream(upstream)
+    , m_blockSize(blockSize)
+    , m_first(nullptr)
+    , m_current(nullptr)
+    , m_pos(nullptr)
+    , m_end(nullptr)
+    , m_last(nullptr)
+  {
+    assert(m_upstream && "upstream allocator must not be null");
+  }
+
+  inline LinearArenaAllocator::~LinearArenaAllocator()
+  {
+    Block* block = m_first;
+    while (block)
+    {
+      Block* next = block->next;
+      m_upstream->deallocate(block);
+      block = next;
+    }
+  }
+
+  inline size_t LinearArenaAllocator::blockHeader()
+  {
+    return detail::alignUp(sizeof(Block), alignof(std::max_align_t));
+  }
+
+  inline char* LinearArenaAllocator::begin(Block* block)
+  {
+    return reinterpret_cast<char*>(block) + blockHeader();
+  }
+
+  inline void* LinearArenaAllocator::allocate(size_t size)
+  {
+    return allocateAligned(size, alignof(std::max_align_t));
+  }
+
+  inline void* LinearArenaAllocator::allocateAligned(size_t size, size_t alignment)
+  {
+    if (alignment < alignof(std::max_align_t))
+      alignment = alignof(std::max_align_t);
+
+    size = detail::alignUp(size > 0 ? size : 1, alignof(std::max_align_t));
+
+    size_t padding = detail::alignUp((std::uintptr_t)m_pos, alignment) - (std::uintptr_t)m_pos;
+    if (padding + size > (size_t)(m_end - m_pos))
+    {
+      //blocks begin at alignof(max_align_t)
+      nextBlock(size + alignment - alignof(std::max_align_t));
+      padding = detail::alignUp((std::uintptr_t)m_pos, alignment) - (std::uintptr_t)m_pos;
+    }
+
+    char* p = m_pos + padding;
+    m_pos = p + size;
+    m_last = p;
+    return p;
+  }
+
+  inline void LinearArenaAllocator::deallocateSized(void* p, size_t size, size_t alignment)
+  {
+    detail::unused(size, alignment);
+    deallocate(p);
+  }
+
+  inline bool LinearArenaAllocator::tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    detail::unused(oldSize, alignment);
+
+    if (!p || p != m_last)
+      return false;
+
+    newSize = detail::alignUp(newSize > 0 ? newSize : 1, alignof(std::max_align_t));
+    if (newSize > (size_t)(m_end - static_cast<char*>(p)))
+      return false;
+
+    m_pos = static_cast<char*>(p) + newSize;
+    return true;
+  }
+
+  inline void LinearArenaAllocator::deallocate(void* p)
+  {
+    //only the most recent allocation can be given back
+    if (p && p == m_last)
+    {
+      m_pos = static_cast<char*>(p);
+      m_last = nullptr;
+    }
+  }
+
+  inline void LinearArenaAllocator::reset()
+  {
+    m_current = m_first;
+    m_pos = m_first ? begin(m_first) : nullptr;
+    m_end = m_first ? m_pos + m_first->size : nullptr;
+    m_last = nullptr;
+  }
+
+  inline size_t LinearArenaAllocator::capacity() const
+  {
+    size_t sum = 0;
+    for (Block* block = m_first; block; block = block->next)
+      sum += block->size;
+
+    return sum;
+  }
+
+  //continue with the next block, blocks that are kept from before the last
+  //reset are reused if they are large enough, otherwise they are replaced
+  inline void LinearArenaAllocator::nextBlock(size_t size)
+  {
+    Block* next = m_current ? m_current->next : m_first;
+
+    while (next && next->size < size)
+    {
+      Block* tooSmall = next;
+      next = next->next;
+      m_upstream->deallocate(tooSmall);
+    }
+
+    if (!next)
+    {
+      const size_t blockSize = size > m_blockSize ? size : m_blockSize;
+      next = static_cast<Block*>(m_upstream->allocate(blockHeader() + blockSize));
+      next->size = blockSize;
+      next->next = nullptr;
+    }
+
+    if (m_current)
+      m_current->next = next;
+    else
+      m_first = next;
+
+    m_current = next;
+    m_pos = begin(next);
+    m_end = m_pos + next->size;
+  }
+
+  //============================================================================
+
+  inline FreeListPoolAllocator::FreeListPoolAllocator(size_t slabSize, Allocator* upstream)
+    : m_upstream(upstream)
+    , m_slabSize(slabSize)
+    , m_slabs(nullptr)
+  {
+    assert(m_upstream && "upstream allocator must not be null");
+    memset(m_free, 0, sizeof(m_free));
+  }
+
+  inline FreeListPoolAllocator::~FreeListPoolAllocator()
+  {
+    while (m_slabs)
+      m_upstream->deallocate(detail::allocators::pop(m_slabs));
+  }
+
+  inline void* FreeListPoolAllocator::allocate(size_t size)
+  {
+    using namespace detail::allocators;
+
+    const size_t c = sizeClass(size);
+    if (c == largeClass)
+      return writeHeader(m_upstream->allocate(headerSize + size), c);
+
+    if (!m_free[c])
+      refill(c);
+
+    return writeHeader(pop(m_free[c]), c);
+  }
+
+  inline void FreeListPoolAllocator::deallocate(void* p)
+  {
+    using namespace detail::allocators;
+
+    if (!p)
+      return;
+
+    const size_t c = readHeader(p);
+    if (c == largeClass)
+      m_upstream->deallocate(blockOf(p));
+    else
+      push(m_free[c], blockOf(p));
+  }
+
+  inline bool FreeListPoolAllocator::tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    detail::unused(oldSize);
+    return p && detail::allocators::fitsInBlock(p, newSize, alignment);
+  }
+
+  //carve a new slab into blocks of the given size class
+  inline void FreeListPoolAllocator::refill(size_t sizeClass)
+  {
+    using namespace detail::allocators;
+
+    const size_t stride = headerSize + classSize(sizeClass);
+    const size_t available = m_slabSize > headerSize ? m_slabSize - headerSize : 0;
+    const size_t count = available / stride > 0 ? available / stride : 1;
+
+    //the first headerSize bytes of a slab link it into the list of slabs
+    char* slab = static_cast<char*>(m_upstream->allocate(headerSize + count * stride));
+    push(m_slabs, slab);
+
+    for (size_t i = count; i > 0; --i)
+      push(m_free[sizeClass], &slab[headerSize + (i - 1) * stride]);
+  }
+
+  //============================================================================
+
+  inline ThreadLocalCachingAllocator::ThreadLocalCachingAllocator(Allocator* upstream, size_t maxCachedBlocks)
+    : m_upstream(upstream)
+    , m_maxCachedBlocks(maxCachedBlocks)
+    , m_id(0)
+    , m_caches()
+  {
+    assert(m_upstream && "upstream allocator must not be null");
+
+    //ids are never reused, so a thread never mistakes the cache of a destroyed
+    //allocator for the cache of a new allocator at the same address
+    static size_t lastId = 0;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    m_id = ++lastId;
+  }
+
+  inline ThreadLocalCachingAllocator::~ThreadLocalCachingAllocator()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto& cache : m_caches)
+    {
+      release(*cache);
+      cache->upstream = nullptr;
+    }
+  }
+
+  inline ThreadLocalCachingAllocator::ThreadCaches::~ThreadCaches()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto& cache : caches)
+    {
+      if (cache->upstream)
+        release(*cache);
+
+      cache->threadExited = true;
+    }
+  }
+
+  inline std::mutex& ThreadLocalCachingAllocator::registryMutex()
+  {
+    static std::mutex mutex; //threadsafe since C+11, thanks to 'magic statics'
+    return mutex;
+  }
+
+  inline ThreadLocalCachingAllocator::ThreadCaches& ThreadLocalCachingAllocator::threadCaches()
+  {
+    static thread_local ThreadCaches caches;
+    return caches;
+  }
+
+  //return all cached blocks to upstream, registryMutex must be locked
+  inline void ThreadLocalCachingAllocator::release(Cache& cache)
+  {
+    using namespace detail::allocators;
+
+    for (size_t c = 0; c < numClasses; ++c)
+    {
+      while (cache.blocks[c])
+        cache.upstream->deallocate(pop(cache.blocks[c]));
+
+      cache.counts[c] = 0;
+    }
+  }
+
+  //cache of the calling thread, created on first use
+  inline ThreadLocalCachingAllocator::Cache& ThreadLocalCachingAllocator::cache()
+  {
+    CacheList& caches = threadCaches().caches;
+    for (auto& cache : caches)
+    {
+      if (cache->owner == m_id)
+        return *cache;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+
+    //drop caches of destroyed allocators and of exited threads
+    auto destroyed = [](const std::shared_ptr<Cache>& cache) { return cache->upstream == nullptr; };
+    caches.erase(std::remove_if(caches.begin(), caches.end(), destroyed), caches.end());
+
+    auto exited = [](const std::shared_ptr<Cache>& cache) { return cache->threadExited; };
+    m_caches.erase(std::remove_if(m_caches.begin(), m_caches.end(), exited), m_caches.end());
+
+    std::shared_ptr<Cache> cache = std::make_shared<Cache>();
+    cache->owner = m_id;
+    cache->upstream = m_upstream;
+    cache->threadExited = false;
+    memset(cache->blocks, 0, sizeof(cache->blocks));
+    memset(cache->counts, 0, sizeof(cache->counts));
+
+    caches.push_back(cache);
+    m_caches.push_back(cache);
+    return *cache;
+  }
+
+  inline void* ThreadLocalCachingAllocator::allocate(size_t size)
+  {
+    using namespace detail::allocators;
+
+    const size_t c = sizeClass(size);
+    if (c == largeClass)
+      return writeHeader(m_upstream->allocate(headerSize + size), c);
+
+    Cache& cache = this->cache();
+    if (cache.blocks[c])
+    {
+      --cache.counts[c];
+      return writeHeader(pop(cache.blocks[c]), c);
+    }
+
+    return writeHeader(m_upstream->allocate(headerSize + classSize(c)), c);
+  }
+
+  inline void ThreadLocalCachingAllocator::deallocate(void* p)
+  {
+    using namespace detail::allocators;
+
+    if (!p)
+      return;
+
+    const size_t c = readHeader(p);
+    if (c != largeClass)
+    {
+      Cache& cache = this->cache();
+      if (cache.counts[c] < m_maxCachedBlocks)
+      {
+        ++cache.counts[c];
+        push(cache.blocks[c], blockOf(p));
+        return;
+      }
+    }
+
+    m_upstream->deallocate(blockOf(p));
+  }
+
+  inline bool ThreadLocalCachingAllocator::tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    detail::unused(oldSize);
+    return p && detail::allocators::fitsInBlock(p, newSize, alignment);
+  }
+}
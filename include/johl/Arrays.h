@@ -1,7 +1,9 @@
 #pragma once
 #include <johl/ArrayRef.h>
 #include <johl/detail/Arrays.h>
+#include <johl/detail/Sort.h>
 #include <johl/Allocator.h>
+#include <johl/ThreadPool.h>
 #include <cassert>
 #include <cstring>
 
@@ -20,12 +22,127 @@ namespace johl
     static const size_t align = TAlign;
   };
 
+  /**
+   * Tag type that assigns an array to a group (see BasicArrays). Can be 
+   * combined with the 'aligned' tag type: group<aligned<T, 16>, 1>.
+   */
+  template<typename TType, size_t TGroup>
+  struct group final
+  {
+    group() = delete;
+
+    using Type = TType;
+    static const size_t index = TGroup;
+  };
+
+  /**
+   * Marks a rarely used array, cold arrays are stored in their own block of
+   * memory (group 1).
+   */
+  template<typename TType>
+  using cold = group<TType, 1>;
+
+  /**
+   * Tag type for a bool array that stores one bit per row, packed into 64 bit
+   * words (bit i is bit i % 64 of word i / 64). data() returns the words, 
+   * single rows are accessed with testBit and setBit (not with at or array).
+   * Can be combined with the 'group' tag type, but not with 'aligned'.
+   */
+  struct bits final
+  {
+    bits() = delete;
+  };
+
+  bool testBit(const std::uint64_t* words, size_t i);
+  void setBit(std::uint64_t* words, size_t i, bool value = true);
+  size_t countBits(const std::uint64_t* words, size_t begin, size_t end);
+
+  template<typename TFunction>
+  void forEachSetBit(const std::uint64_t* words, size_t begin, size_t end, TFunction fn);
+
+  /**
+   * Compile time description of the memory layout of Arrays<TArrays...>.
+   * All arrays share one block of memory. Arrays are placed in order of 
+   * descending alignment (arrays with equal alignment keep their relative 
+   * order), so there is no padding between arrays of naturally aligned types.
+   * The index of an array (data<Index>) does not depend on its position.
+   *
+   *   - bytesPerRow, maxAlignment
+   *   - arraySize(index), arrayAlignment(index)
+   *   - position(index), arrayAt(position)
+   *   - offset(index, numRows), bytes(numRows), padding(numRows)
+   *
+   * All members are constexpr.
+   * ArraysLayout ignores the groups of the arrays (all arrays in one block), 
+   * ArraysGroupLayout is the layout of the block of a single group, the other
+   * arrays have size 0 (see contains(index)).
+   */
+  template<typename... TArrays>
+  using ArraysLayout = detail::Layout<typename detail::MakeIndexSequence<sizeof...(TArrays)>::Type, detail::allGroups, TArrays...>;
+
+  template<size_t TGroup, typename... TArrays>
+  using ArraysGroupLayout = detail::Layout<typename detail::MakeIndexSequence<sizeof...(TArrays)>::Type, TGroup, TArrays...>;
+
+  /**
+   * Growth policy: grow to exactly the number of required rows.
+   * Filling a container row by row without calling reserve is O(n^2).
+   */
+  struct exact_growth final
+  {
+    exact_growth() = delete;
+
+    static size_t capacity(size_t current, size_t required)
+    {
+      detail::unused(current);
+      return required;
+    }
+  };
+
+  /**
+   * Growth policy: grow by a fixed number of rows (TRows).
+   */
+  template<size_t TRows>
+  struct block_growth final
+  {
+    static_assert(TRows > 0, "TRows must be greater than zero");
+    block_growth() = delete;
+
+    static size_t capacity(size_t current, size_t required)
+    {
+      detail::unused(current);
+      return ((required + TRows - 1) / TRows) * TRows;
+    }
+  };
+
+  /**
+   * Growth policy: grow by a constant factor (TNumerator/TDenominator).
+   * The default factor is 1.5.
+   */
+  template<size_t TNumerator = 3, size_t TDenominator = 2>
+  struct geometric_growth final
+  {
+    static_assert(TDenominator > 0, "TDenominator must be greater than zero");
+    static_assert(TNumerator > TDenominator, "growth factor must be greater than one");
+    geometric_growth() = delete;
+
+    static size_t capacity(size_t current, size_t required)
+    {
+      const size_t grown = current + (current * (TNumerator - TDenominator)) / TDenominator;
+      return grown > required ? grown : required;
+    }
+  };
+
   /**
    * 'struct-of-arrays like' container. Maintains multiple arrays that are all
    * equally sized. 
+   * TGrowth is the growth policy that is applied if append or insertAt run 
+   * out of capacity (see exact_growth, block_growth and geometric_growth).
+   * Arrays tagged with 'group' (e.g. cold<T>) are stored in a separate block
+   * of memory per group, all other arrays are in group 0. Each block has its
+   * own capacity and is only reallocated when it runs out of capacity.
    */
-  template<typename... TArrays>
-  class Arrays final  
+  template<typename TGrowth, typename... TArrays>
+  class BasicArrays final  
   {
   private:
     //This type implements the actual template meta program.
@@ -37,18 +154,48 @@ namespace johl
     template<size_t Index>
     using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
 
+    //layouts of the blocks of all groups, selected by the group at runtime
+    using Groups = detail::GroupLayouts<typename detail::MakeIndexSequence<detail::NumGroups<TArrays...>::value>::Type, TArrays...>;
+
+    //sizes and alignments of all arrays, regardless of their group
+    using AllLayout = ArraysLayout<TArrays...>;
+
   public: 
-    explicit Arrays(Allocator* allocator = Allocator::defaultAllocator());
+    using GrowthPolicy = TGrowth;
+
+    static const size_t numGroups = Groups::numGroups;
+
+    template<size_t TGroup>
+    using GroupLayout = ArraysGroupLayout<TGroup, TArrays...>;
+
+    //layout of the block of group 0 (all arrays, if no group tags are used)
+    using Layout = GroupLayout<0>;
+
+    //true if array Index is a bit array ('bits' tag type)
+    template<size_t Index>
+    using IsBitArray = detail::IsBitArray<typename detail::Get<Index, TArrays...>::Type>;
+
+    explicit BasicArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    BasicArrays(const BasicArrays& other);
+    BasicArrays& operator=(const BasicArrays& other);
+
+    BasicArrays(BasicArrays&& other) noexcept;
+    BasicArrays& operator=(BasicArrays&& other) noexcept;
 
-    Arrays(const Arrays&) = delete;
-    Arrays& operator=(const Arrays&) = delete;
+    ~BasicArrays();
 
-    ~Arrays();
+    void swap(BasicArrays& other) noexcept;
+
+    BasicArrays clone(Allocator* allocator) const;
+    void assign(const BasicArrays& other);
 
     size_t size() const;
     size_t capacity() const;
+    size_t groupCapacity(size_t group) const;
     void clear();
     void reserve(size_t n);
+    void releaseUnused();
 
     template<size_t Index>
     ArrayRef<Type<Index>> array();
@@ -63,164 +210,723 @@ namespace johl
     const Type<Index>* data() const;
 
     template<size_t Index>
-    auto at(size_t i) -> typename detail::Get<Index, TArrays...>::Type&;
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    bool testBit(size_t i) const;
+
+    template<size_t Index>
+    void setBit(size_t i, bool value = true);
 
     template<size_t Index>
-    auto at(size_t i) const -> const typename detail::Get<Index, TArrays...>::Type&;
+    size_t countBits() const;
+
+    template<size_t Index, typename TFunction>
+    void forEachSetBit(TFunction fn) const;
 
     template<typename... TArgs>
     void append(TArgs... args);
 
+    template<typename... TArgs>
+    auto emplaceBack(TArgs&&... args)
+      -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type;
+
+    template<typename... TTuples>
+    auto emplaceBack(std::piecewise_construct_t, TTuples... args)
+      -> typename std::enable_if<sizeof...(TTuples) == sizeof...(TArrays), void>::type;
+
+    void appendRange(size_t n, const typename detail::AlignedType<TArrays>::Type*... arrays);
+
     void removeAt(size_t index);
+    void removeAtUnordered(size_t index);
+    void removeRange(size_t from, size_t count);
+
+    template<typename TPredicate>
+    size_t removeIf(TPredicate pred);
 
     template<typename... TArgs>
     void insertAt(size_t index, TArgs... args);
 
+    template<typename... TArgs>
+    auto emplaceAt(size_t index, TArgs&&... args)
+      -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type;
+
+    template<typename... TTuples>
+    auto emplaceAt(size_t index, std::piecewise_construct_t, TTuples... args)
+      -> typename std::enable_if<sizeof...(TTuples) == sizeof...(TArrays), void>::type;
+
+    void insertRange(size_t index, size_t n, const typename detail::AlignedType<TArrays>::Type*... arrays);
+
     void swapAt(size_t a,  size_t b);
 
+    template<size_t Index>
+    void sortBy();
+
+    template<size_t Index, typename TCompare>
+    void sortBy(TCompare cmp);
+
+    template<size_t Index>
+    void stableSortBy();
+
+    template<size_t Index, typename TCompare>
+    void stableSortBy(TCompare cmp);
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(TFunction fn, size_t grainSize = 4096);
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(ThreadPool& pool, TFunction fn, size_t grainSize = 4096);
+
   private:
+    void grow(size_t required);
+    void reserveGroup(size_t group, size_t n);
+    void* allocateArrays(size_t group, size_t& n, void** arrays);
+    void deallocateArrays(size_t group, void* data, size_t n);
+    bool expandInPlace(size_t group, size_t n);
+
+    static void initArrayPointers(size_t group, void* data, size_t n, void** arrays);
+    void applyPermutation(size_t* perm);
+
+    template<size_t Index, typename TCompare>
+    void sortWith(TCompare cmp, bool stable);
+
+    template<size_t Index>
+    void sortAscending(bool stable);
+
     size_t m_numUsed;
-    size_t m_numAllocated;
+    size_t m_numAllocated[numGroups];
     Allocator* m_allocator;
-    void*  m_data;  
+    void*  m_data[numGroups];
     void*  m_arrays[sizeof...(TArrays)];
   };
 
+  template<typename TGrowth, typename... TArrays>
+  void swap(BasicArrays<TGrowth, TArrays...>& a, BasicArrays<TGrowth, TArrays...>& b) noexcept;
+
+  /**
+   * Arrays with the default growth policy.
+   */
+  template<typename... TArrays>
+  using Arrays = BasicArrays<geometric_growth<>, TArrays...>;
+
   //============================================================================
 
   namespace detail
   {
     //specialize helper type AlignedType for the 'align' tag type.
     //AlignedType::Type is always the actual type.
-    //AlignedType::align is TAlign for align types, otherwise its a constant 
-    // default value (see details header)
+    //AlignedType::align is TAlign for align types (but never less than the 
+    // natural alignment of T), otherwise its the natural alignment (see 
+    // details header)
     template<typename T, size_t TAlign>
     struct AlignedType<aligned<T, TAlign>> final
     {
       AlignedType() = delete;
 
       using Type = T;
-      static const size_t align = TAlign;
+      static const size_t align = TAlign > alignof(T) ? TAlign : alignof(T);
+    };
+
+    template<typename T, size_t TGroup>
+    struct AlignedType<group<T, TGroup>> final
+    {
+      AlignedType() = delete;
+
+      using Type = typename AlignedType<T>::Type;
+      static const size_t align = AlignedType<T>::align;
+    };
+
+    template<typename T, size_t TGroup>
+    struct ColumnGroup<group<T, TGroup>> final
+    {
+      ColumnGroup() = delete;
+      static const size_t value = TGroup;
+    };
+
+    //bit arrays are stored as words
+    template<>
+    struct AlignedType<bits> final
+    {
+      AlignedType() = delete;
+
+      using Type = std::uint64_t;
+      static const size_t align = alignof(std::uint64_t);
+    };
+
+    template<>
+    struct IsBitArray<bits> final
+    {
+      IsBitArray() = delete;
+      static const bool value = true;
+    };
+
+    template<typename T, size_t TGroup>
+    struct IsBitArray<group<T, TGroup>> final
+    {
+      IsBitArray() = delete;
+      static const bool value = IsBitArray<T>::value;
+    };
+
+    /**
+     * True if array Index of a container is a bit array (BasicArrays::IsBitArray),
+     * false for containers without IsBitArray.
+     */
+    template<size_t Index, typename TContainer>
+    struct IsBitArrayOf final
+    {
+      IsBitArrayOf() = delete;
+
+      template<typename T>
+      static constexpr bool test(decltype(&T::template IsBitArray<Index>::value))
+      {
+        return T::template IsBitArray<Index>::value;
+      }
+
+      template<typename T>
+      static constexpr bool test(...)
+      {
+        return false;
+      }
+
+      static const bool value = test<typename std::remove_cv<TContainer>::type>(nullptr);
     };
   }
 
-  template<typename... TArrays>
-  Arrays<TArrays...>::Arrays(Allocator* allocator)
+  inline bool testBit(const std::uint64_t* words, size_t i)
+  {
+    return detail::bitarray::test(words, i);
+  }
+
+  inline void setBit(std::uint64_t* words, size_t i, bool value)
+  {
+    detail::bitarray::set(words, i, value);
+  }
+
+  /**
+   * Number of set bits in the rows [begin, end) of a bit array.
+   */
+  inline size_t countBits(const std::uint64_t* words, size_t begin, size_t end)
+  {
+    return detail::bitarray::count(words, begin, end);
+  }
+
+  /**
+   * Calls fn(i) for each set bit i in the rows [begin, end) of a bit array,
+   * in ascending order. Skips 64 cleared rows at a time, each set bit is 
+   * found with a count-trailing-zeros instruction. Rows can be visited
+   * selectively this way, e.g. only the active rows in a parallelForEach
+   * chunk.
+   */
+  template<typename TFunction>
+  void forEachSetBit(const std::uint64_t* words, size_t begin, size_t end, TFunction fn)
+  {
+    detail::bitarray::forEachSet(words, begin, end, fn);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  BasicArrays<TGrowth, TArrays...>::BasicArrays(Allocator* allocator)
     : m_numUsed(0)
-    , m_numAllocated(0)
     , m_allocator(allocator)
-    , m_data(nullptr)
   {
     assert(m_allocator && "allocator must not be null");
+    memset(&m_numAllocated[0], 0, sizeof(m_numAllocated));
+    memset(&m_data[0], 0, sizeof(m_data));
     memset(&m_arrays[0], 0, sizeof(m_arrays));
   }
 
-  template<typename... TArrays>
-  Arrays<TArrays...>::~Arrays()
+  /**
+   * Deep copy, uses the same allocator as other. See clone.
+   */
+  template<typename TGrowth, typename... TArrays>
+  BasicArrays<TGrowth, TArrays...>::BasicArrays(const BasicArrays& other)
+    : BasicArrays(other.m_allocator)
+  {
+    assign(other);
+  }
+
+  /**
+   * Deep copy, keeps the allocator of this object. See assign.
+   */
+  template<typename TGrowth, typename... TArrays>
+  auto BasicArrays<TGrowth, TArrays...>::operator=(const BasicArrays& other) -> BasicArrays&
+  {
+    assign(other);
+    return *this;
+  }
+
+  /**
+   * Takes over the memory of other in O(1), no elements are moved or copied.
+   * The allocator is passed on with the memory it allocated, so this object
+   * uses other's allocator from now on. other is left empty, but keeps its
+   * allocator and can be reused.
+   */
+  template<typename TGrowth, typename... TArrays>
+  BasicArrays<TGrowth, TArrays...>::BasicArrays(BasicArrays&& other) noexcept
+    : m_numUsed(other.m_numUsed)
+    , m_allocator(other.m_allocator)
+  {
+    memcpy(&m_numAllocated[0], &other.m_numAllocated[0], sizeof(m_numAllocated));
+    memcpy(&m_data[0], &other.m_data[0], sizeof(m_data));
+    memcpy(&m_arrays[0], &other.m_arrays[0], sizeof(m_arrays));
+
+    other.m_numUsed = 0;
+    memset(&other.m_numAllocated[0], 0, sizeof(other.m_numAllocated));
+    memset(&other.m_data[0], 0, sizeof(other.m_data));
+    memset(&other.m_arrays[0], 0, sizeof(other.m_arrays));
+  }
+
+  /**
+   * Destroys all elements of this object and takes over the memory (and the
+   * allocator) of other in O(1), see move constructor.
+   */
+  template<typename TGrowth, typename... TArrays>
+  auto BasicArrays<TGrowth, TArrays...>::operator=(BasicArrays&& other) noexcept -> BasicArrays&
+  {
+    if (this != &other)
+    {
+      BasicArrays tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  BasicArrays<TGrowth, TArrays...>::~BasicArrays()
+  {
+    ForEachArray::destructRange(m_arrays, 0, m_numUsed);
+
+    for (size_t group = 0; group < numGroups; ++group)
+      deallocateArrays(group, m_data[group], m_numAllocated[group]);
+  }
+
+  /**
+   * Exchanges the contents of two objects in O(1), no elements are moved or
+   * copied. The allocators are exchanged as well, each memory block stays 
+   * with the allocator that allocated it.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::swap(BasicArrays& other) noexcept
+  {
+    std::swap(m_numUsed, other.m_numUsed);
+    std::swap(m_allocator, other.m_allocator);
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+      std::swap(m_numAllocated[group], other.m_numAllocated[group]);
+      std::swap(m_data[group], other.m_data[group]);
+    }
+
+    for (size_t i = 0; i < sizeof...(TArrays); ++i)
+      std::swap(m_arrays[i], other.m_arrays[i]);
+  }
+
+  /**
+   * Deep copy that uses the given allocator. Allocates exactly one block (per
+   * group) for size() rows, trivially copyable arrays are copied with one memcpy each,
+   * only non-trivial elements are copy-constructed.
+   */
+  template<typename TGrowth, typename... TArrays>
+  auto BasicArrays<TGrowth, TArrays...>::clone(Allocator* allocator) const -> BasicArrays
   {
+    BasicArrays copy(allocator);
+    copy.assign(*this);
+    return copy;
+  }
+
+  /**
+   * Replace all rows by copies of the rows of other. Reuses the memory of 
+   * this object if its capacity is large enough, otherwise allocates exactly
+   * other.size() rows. 
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::assign(const BasicArrays& other)
+  {
+    if (this == &other)
+      return;
+
     clear();
-    m_allocator->deallocate(m_data);
+    reserve(other.m_numUsed);
+
+    ForEachArray::copyArrays(other.m_arrays, m_arrays, other.m_numUsed);
+    m_numUsed = other.m_numUsed;
   }
 
-  template<typename... TArrays>
-  size_t Arrays<TArrays...>::size() const
+  template<typename TGrowth, typename... TArrays>
+  void swap(BasicArrays<TGrowth, TArrays...>& a, BasicArrays<TGrowth, TArrays...>& b) noexcept
+  {
+    a.swap(b);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicArrays<TGrowth, TArrays...>::size() const
   {
     return m_numUsed;
   }
 
-  template<typename... TArrays>
-  size_t Arrays<TArrays...>::capacity() const
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicArrays<TGrowth, TArrays...>::capacity() const
   {
-    return m_numAllocated;
+    size_t capacity = m_numAllocated[0];
+    for (size_t group = 1; group < numGroups; ++group)
+      capacity = m_numAllocated[group] < capacity ? m_numAllocated[group] : capacity;
+
+    return capacity;
   }
 
-  template<typename... TArrays>
-  void Arrays<TArrays...>::clear()
+  /**
+   * Capacity of the block of the given group, capacity() is the minimum of 
+   * all groups.
+   */
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicArrays<TGrowth, TArrays...>::groupCapacity(size_t group) const
+  {
+    assert(group < numGroups && "group out of range");
+    return m_numAllocated[group];
+  }
+
+  /**
+   * Destroys all rows, the capacity does not change. The memory of the rows
+   * is handed back to the allocator with Allocator::decommit (e.g. 
+   * MmapAllocator returns the pages to the operating system).
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::clear()
   {
     ForEachArray::destructRange(m_arrays, 0, m_numUsed);
+
+    if (m_numUsed > 0)
+    {
+      for (size_t i = 0; i < sizeof...(TArrays); ++i)
+        m_allocator->decommit(m_arrays[i], AllLayout::arrayBytes(i, m_numUsed));
+    }
+
     m_numUsed = 0;
   }
 
-  template<typename... TArrays>
-  void Arrays<TArrays...>::reserve(size_t n)
+  /**
+   * Hands the memory of the unused capacity of every array back to the 
+   * allocator (see clear). No rows are moved and the capacity does not 
+   * change, so appending rows later does not reallocate either.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::releaseUnused()
+  {
+    for (size_t i = 0; i < sizeof...(TArrays); ++i)
+    {
+      const size_t numAllocated = m_numAllocated[Groups::groups[i]];
+      if (m_numUsed == numAllocated)
+        continue;
+
+      char* begin = static_cast<char*>(m_arrays[i]);
+      const size_t used = AllLayout::arrayBytes(i, m_numUsed);
+      m_allocator->decommit(begin + used, AllLayout::arrayBytes(i, numAllocated) - used);
+    }
+  }
+
+  /**
+   * Grows each group that has less than required rows by the growth policy,
+   * groups with enough capacity are not touched.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::grow(size_t required)
   {
-    if (m_numAllocated >= n)
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+      if (m_numAllocated[group] < required)
+        reserveGroup(group, TGrowth::capacity(m_numAllocated[group], required));
+    }
+  }
+
+  /**
+   * set the array pointers of the given group for a block of n rows at data 
+   * (aligned to the maxAlignment of the group), the pointers of all other
+   * arrays are not changed.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::initArrayPointers(size_t group, void* data, size_t n, void** arrays)
+  {
+    char* begin = static_cast<char*>(data);
+    size_t offset = 0;
+    for (size_t position = 0; position < sizeof...(TArrays); ++position)
+    {
+      const size_t index = Groups::arrayAt(group, position);
+      if (Groups::groups[index] != group)
+        continue;
+
+      offset = detail::alignUp(offset, AllLayout::arrayAlignment(index));
+      arrays[index] = begin + offset;
+      offset += AllLayout::arrayBytes(index, n);
+    }
+  }
+
+  /**
+   * allocate a block of the given group for at least n rows and init the 
+   * array pointers. If the allocator hands out a larger block (see 
+   * Allocator::allocateAtLeast), n is increased to the number of rows that
+   * fit into it. Groups without arrays are never allocated.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void* BasicArrays<TGrowth, TArrays...>::allocateArrays(size_t group, size_t& n, void** arrays)
+  {
+    if (Groups::bitsPerRow[group] == 0)
+      return nullptr;
+
+    const size_t bytes = Groups::bytes(group, n);
+
+    size_t allocatedSize;
+    void* data = m_allocator->allocateAtLeast(bytes, Groups::maxAlignment[group], allocatedSize);
+    assert(data && "allocation failed");
+
+    if (allocatedSize > bytes)
+    {
+      size_t rows = allocatedSize * 8 / Groups::bitsPerRow[group];
+      while (rows > n && Groups::bytes(group, rows) > allocatedSize)
+        --rows;
+
+      n = rows;
+    }
+
+    initArrayPointers(group, data, n, arrays);
+    return data;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::deallocateArrays(size_t group, void* data, size_t n)
+  {
+    if (data)
+      m_allocator->deallocateSized(data, Groups::bytes(group, n), Groups::maxAlignment[group]);
+  }
+
+  /**
+   * Grow the block of the given group in place to n rows, only if all arrays
+   * of the group are trivially relocatable. The arrays are shifted to their
+   * new offsets from back to front (an array never moves towards the begin
+   * of the block, so it can only overlap arrays that have been shifted 
+   * already).
+   * Returns false if the allocator can not expand the block.
+   */
+  template<typename TGrowth, typename... TArrays>
+  bool BasicArrays<TGrowth, TArrays...>::expandInPlace(size_t group, size_t n)
+  {
+    if (!Groups::triviallyRelocatable[group] || !m_data[group])
+      return false;
+
+    if (!m_allocator->tryExpand(m_data[group], Groups::bytes(group, m_numAllocated[group]), Groups::bytes(group, n), Groups::maxAlignment[group]))
+      return false;
+
+    void* arrays[sizeof...(TArrays)];
+    memcpy(&arrays[0], &m_arrays[0], sizeof(m_arrays));
+    initArrayPointers(group, m_data[group], n, arrays);
+
+    for (size_t position = sizeof...(TArrays); position > 0; --position)
+    {
+      const size_t index = Groups::arrayAt(group, position - 1);
+      if (Groups::groups[index] == group)
+        memmove(arrays[index], m_arrays[index], AllLayout::arrayBytes(index, m_numUsed));
+    }
+
+    memcpy(&m_arrays[0], &arrays[0], sizeof(m_arrays));
+    m_numAllocated[group] = n;
+    return true;
+  }
+
+  /**
+   * Make room for at least n rows (exactly n rows, if it has to grow and the
+   * allocator does not hand out a larger block, see allocateArrays).
+   * Only groups with less than n rows are reallocated.
+   * Groups with only trivially relocatable arrays are grown in place if 
+   * the allocator supports it (see Allocator::tryExpand).
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::reserve(size_t n)
+  {
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+      if (m_numAllocated[group] < n)
+        reserveGroup(group, n);
+    }
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::reserveGroup(size_t group, size_t n)
+  {
+    if (expandInPlace(group, n))
       return;
 
-    const size_t bytes = (detail::SumSize<TArrays...>::value * n) + detail::SumAlignment<TArrays...>::value;
-    void* data = m_allocator->allocate(bytes);
     void* arrays[sizeof...(TArrays)];
+    memcpy(&arrays[0], &m_arrays[0], sizeof(m_arrays));
+    void* data = allocateArrays(group, n, arrays);
 
-    ForEachArray::initArrayPointer(arrays, data, n);
-    ForEachArray::moveRange(m_arrays, 0, arrays, 0, m_numUsed);
+    ForEachArray::moveGroupRange(group, m_arrays, 0, arrays, 0, m_numUsed);
 
-    m_allocator->deallocate(m_data);
+    deallocateArrays(group, m_data[group], m_numAllocated[group]);
 
-    m_data = data;
+    m_data[group] = data;
     memcpy(&m_arrays[0], &arrays[0], sizeof(m_arrays));
 
-    m_numAllocated = n;
+    m_numAllocated[group] = n;
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto Arrays<TArrays...>::array() -> ArrayRef<Type<Index>>
+  auto BasicArrays<TGrowth, TArrays...>::array() -> ArrayRef<Type<Index>>
   {
+    static_assert(!IsBitArray<Index>::value, "bit arrays have no ArrayRef, use data<Index>() to get the words");
     return ArrayRef<Type<Index>>(data<Index>(), m_numUsed);
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto  Arrays<TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  auto  BasicArrays<TGrowth, TArrays...>::array() const -> ArrayRef<const Type<Index>>
   {
+    static_assert(!IsBitArray<Index>::value, "bit arrays have no ArrayRef, use data<Index>() to get the words");
     return ArrayRef<const Type<Index>>(data<Index>(), m_numUsed);
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto Arrays<TArrays...>::data() -> Type<Index>*
+  auto BasicArrays<TGrowth, TArrays...>::data() -> Type<Index>*
   {
     return static_cast<Type<Index>*>(m_arrays[Index]);
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto Arrays<TArrays...>::data() const -> const Type<Index>*
+  auto BasicArrays<TGrowth, TArrays...>::data() const -> const Type<Index>*
   {
     return static_cast<Type<Index>*>(m_arrays[Index]);
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto Arrays<TArrays...>::at(size_t i) -> typename detail::Get<Index, TArrays...>::Type&
+  auto BasicArrays<TGrowth, TArrays...>::at(size_t i) -> Type<Index>&
   {
+    static_assert(!IsBitArray<Index>::value, "use testBit/setBit for bit arrays");
     assert(i < m_numUsed && "index i out of range");
     return data<Index>()[i];
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<size_t Index>
-  auto Arrays<TArrays...>::at(size_t i) const -> const typename detail::Get<Index, TArrays...>::Type&
+  auto BasicArrays<TGrowth, TArrays...>::at(size_t i) const -> const Type<Index>&
   {
+    static_assert(!IsBitArray<Index>::value, "use testBit/setBit for bit arrays");
     assert(i < m_numUsed && "index i out of range");
     return data<Index>()[i];
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  bool BasicArrays<TGrowth, TArrays...>::testBit(size_t i) const
+  {
+    static_assert(IsBitArray<Index>::value, "testBit requires a bit array");
+    assert(i < m_numUsed && "index i out of range");
+    return johl::testBit(data<Index>(), i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  void BasicArrays<TGrowth, TArrays...>::setBit(size_t i, bool value)
+  {
+    static_assert(IsBitArray<Index>::value, "setBit requires a bit array");
+    assert(i < m_numUsed && "index i out of range");
+    johl::setBit(data<Index>(), i, value);
+  }
+
+  /**
+   * Number of set bits (popcount) of bit array Index.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  size_t BasicArrays<TGrowth, TArrays...>::countBits() const
+  {
+    static_assert(IsBitArray<Index>::value, "countBits requires a bit array");
+    return johl::countBits(data<Index>(), 0, m_numUsed);
+  }
+
+  /**
+   * Calls fn(i) for each row i with a set bit in bit array Index, see 
+   * johl::forEachSetBit.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index, typename TFunction>
+  void BasicArrays<TGrowth, TArrays...>::forEachSetBit(TFunction fn) const
+  {
+    static_assert(IsBitArray<Index>::value, "forEachSetBit requires a bit array");
+    johl::forEachSetBit(data<Index>(), 0, m_numUsed, fn);
+  }
+
+  /**
+   * Append a row. The arguments are taken by value, so unlike emplaceBack 
+   * they may refer to elements of this container.
+   */
+  template<typename TGrowth, typename... TArrays>
   template<typename... TArgs>
-  void Arrays<TArrays...>::append(TArgs... args)
+  void BasicArrays<TGrowth, TArrays...>::append(TArgs... args)
   {
     static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
 
-    reserve(m_numUsed + 1);
+    grow(m_numUsed + 1);
 
     ForEachArray::constructAt(m_arrays, m_numUsed, std::forward<TArgs>(args)...);
 
     ++m_numUsed;
   }
 
-  template<typename... TArrays>
-  void Arrays<TArrays...>::removeAt(size_t index)
+  /**
+   * Append a row, constructs each element in place from the perfectly 
+   * forwarded argument for its column.
+   * The arguments must not refer to elements of this container.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TArgs>
+  auto BasicArrays<TGrowth, TArrays...>::emplaceBack(TArgs&&... args)
+    -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type
+  {
+    grow(m_numUsed + 1);
+
+    ForEachArray::constructAt(m_arrays, m_numUsed, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Append a row, constructs each element in place from a tuple of 
+   * constructor arguments (one tuple per column, see std::forward_as_tuple).
+   * The arguments must not refer to elements of this container.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TTuples>
+  auto BasicArrays<TGrowth, TArrays...>::emplaceBack(std::piecewise_construct_t, TTuples... args)
+    -> typename std::enable_if<sizeof...(TTuples) == sizeof...(TArrays), void>::type
+  {
+    grow(m_numUsed + 1);
+
+    ForEachArray::constructPiecewiseAt(m_arrays, m_numUsed, args...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Append n rows, copied from one source array per column.
+   * The source arrays must not point into this container.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::appendRange(size_t n, const typename detail::AlignedType<TArrays>::Type*... arrays)
+  {
+    grow(m_numUsed + n);
+
+    ForEachArray::copyRange(m_arrays, m_numUsed, n, arrays...);
+
+    m_numUsed += n;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::removeAt(size_t index)
   {
     assert(index < m_numUsed && "index out of range");
 
@@ -229,9 +935,9 @@ namespace johl
     --m_numUsed;
   }
 
-  template<typename... TArrays>
+  template<typename TGrowth, typename... TArrays>
   template<typename... TArgs>
-  void Arrays<TArrays...>::insertAt(size_t index, TArgs... args)
+  void BasicArrays<TGrowth, TArrays...>::insertAt(size_t index, TArgs... args)
   {
     static_assert(sizeof...(TArgs) == sizeof...(TArrays),
       "number of arguments does not match number of arrays");
@@ -240,15 +946,151 @@ namespace johl
 
     // reserve space for one extra element, move all elements after index one
     // slot up, construct new element at free slot
-    reserve(m_numUsed + 1);
+    grow(m_numUsed + 1);
     ForEachArray::moveRange(m_arrays, index, m_arrays, index + 1, m_numUsed - index);
     ForEachArray::constructAt(m_arrays, index, std::forward<TArgs>(args)...);
 
     ++m_numUsed;
   }
 
-  template<typename... TArrays>
-  void Arrays<TArrays...>::swapAt(size_t a, size_t b)
+  /**
+   * Remove the row at index by moving the last row into its place. 
+   * O(1), but does not preserve the order of the rows.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::removeAtUnordered(size_t index)
+  {
+    assert(index < m_numUsed && "index out of range");
+
+    const size_t last = m_numUsed - 1;
+
+    ForEachArray::destructRange(m_arrays, index, 1);
+    if (index != last)
+      ForEachArray::moveRange(m_arrays, last, m_arrays, index, 1);
+
+    --m_numUsed;
+  }
+
+  /**
+   * Remove count rows starting at from. All following rows are moved only 
+   * once.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::removeRange(size_t from, size_t count)
+  {
+    assert(from <= m_numUsed && count <= m_numUsed - from && "range out of range");
+
+    if (count == 0)
+      return;
+
+    ForEachArray::destructRange(m_arrays, from, count);
+    ForEachArray::moveRange(m_arrays, from + count, m_arrays, from, m_numUsed - from - count);
+    m_numUsed -= count;
+  }
+
+  /**
+   * Remove all rows for which pred(index) returns true, preserves the order
+   * of the remaining rows. 
+   * Compacts all arrays in a single pass: pred is called exactly once per row
+   * in ascending order, consecutive rows that are kept are moved together.
+   * pred may read any array, but only at the given index (rows before index
+   * may already have been moved).
+   * Returns the number of removed rows.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename TPredicate>
+  size_t BasicArrays<TGrowth, TArrays...>::removeIf(TPredicate pred)
+  {
+    const size_t num = m_numUsed;
+    size_t write = 0;
+    size_t runStart = 0;
+    bool runRemoved = false;
+
+    //flushes the run of rows [runStart, end) that are either all kept or all removed
+    auto flush = [&](size_t end)
+    {
+      if (runRemoved)
+      {
+        ForEachArray::destructRange(m_arrays, runStart, end - runStart);
+      }
+      else
+      {
+        if (write != runStart)
+          ForEachArray::moveRange(m_arrays, runStart, m_arrays, write, end - runStart);
+        write += end - runStart;
+      }
+      runStart = end;
+    };
+
+    for (size_t i = 0; i < num; ++i)
+    {
+      const bool remove = pred(i) ? true : false;
+      if (remove != runRemoved)
+      {
+        flush(i);
+        runRemoved = remove;
+      }
+    }
+    flush(num);
+
+    m_numUsed = write;
+    return num - write;
+  }
+
+  /**
+   * Insert a row at index, see emplaceBack.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TArgs>
+  auto BasicArrays<TGrowth, TArrays...>::emplaceAt(size_t index, TArgs&&... args)
+    -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type
+  {
+    assert(index <= m_numUsed && "index out of range");
+
+    grow(m_numUsed + 1);
+    ForEachArray::moveRange(m_arrays, index, m_arrays, index + 1, m_numUsed - index);
+    ForEachArray::constructAt(m_arrays, index, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Insert a row at index, see piecewise emplaceBack.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TTuples>
+  auto BasicArrays<TGrowth, TArrays...>::emplaceAt(size_t index, std::piecewise_construct_t, TTuples... args)
+    -> typename std::enable_if<sizeof...(TTuples) == sizeof...(TArrays), void>::type
+  {
+    assert(index <= m_numUsed && "index out of range");
+
+    grow(m_numUsed + 1);
+    ForEachArray::moveRange(m_arrays, index, m_arrays, index + 1, m_numUsed - index);
+    ForEachArray::constructPiecewiseAt(m_arrays, index, args...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Insert n rows at index, copied from one source array per column.
+   * The source arrays must not point into this container.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::insertRange(size_t index, size_t n, const typename detail::AlignedType<TArrays>::Type*... arrays)
+  {
+    assert(index <= m_numUsed && "index out of range");
+
+    // reserve space for n extra elements, move all elements after index n
+    // slots up, copy new elements to the free slots
+    grow(m_numUsed + n);
+    ForEachArray::moveRange(m_arrays, index, m_arrays, index + n, m_numUsed - index);
+    ForEachArray::copyRange(m_arrays, index, n, arrays...);
+
+    m_numUsed += n;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::swapAt(size_t a, size_t b)
   {
     assert(a < m_numUsed && "index a out of range");
     assert(b < m_numUsed && "index b out of range");
@@ -256,4 +1098,148 @@ namespace johl
     if (a != b)
       ForEachArray::swap(m_arrays, a, b);
   }
+
+  /**
+   * Sort all rows by the elements of array Index in ascending order.
+   * The permutation is computed from array Index only and then applied to 
+   * each array in one pass (see applyPermutation).
+   * Integral and floating point keys are sorted with a radix sort.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  void BasicArrays<TGrowth, TArrays...>::sortBy()
+  {
+    sortAscending<Index>(false);
+  }
+
+  /**
+   * Sort all rows by the elements of array Index, cmp(a, b) returns true if 
+   * key a is ordered before key b. Not stable.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index, typename TCompare>
+  void BasicArrays<TGrowth, TArrays...>::sortBy(TCompare cmp)
+  {
+    sortWith<Index>(cmp, false);
+  }
+
+  /**
+   * Like sortBy, but preserves the order of rows with equal keys.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  void BasicArrays<TGrowth, TArrays...>::stableSortBy()
+  {
+    sortAscending<Index>(true);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index, typename TCompare>
+  void BasicArrays<TGrowth, TArrays...>::stableSortBy(TCompare cmp)
+  {
+    sortWith<Index>(cmp, true);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index, typename TCompare>
+  void BasicArrays<TGrowth, TArrays...>::sortWith(TCompare cmp, bool stable)
+  {
+    static_assert(!IsBitArray<Index>::value, "can not sort by a bit array");
+    if (m_numUsed < 2)
+      return;
+
+    size_t* perm = static_cast<size_t*>(m_allocator->allocate(sizeof(size_t) * m_numUsed));
+    for (size_t i = 0; i < m_numUsed; ++i)
+      perm[i] = i;
+
+    detail::sort::compareSort(data<Index>(), perm, m_numUsed, cmp, stable);
+    applyPermutation(perm);
+
+    m_allocator->deallocate(perm);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  void BasicArrays<TGrowth, TArrays...>::sortAscending(bool stable)
+  {
+    static_assert(!IsBitArray<Index>::value, "can not sort by a bit array");
+    if (m_numUsed < 2)
+      return;
+
+    size_t* perm = static_cast<size_t*>(m_allocator->allocate(sizeof(size_t) * m_numUsed));
+    for (size_t i = 0; i < m_numUsed; ++i)
+      perm[i] = i;
+
+    detail::sort::sortAscending(data<Index>(), perm, m_numUsed, stable, m_allocator);
+    applyPermutation(perm);
+
+    m_allocator->deallocate(perm);
+  }
+
+  /**
+   * Reorder all rows, row i is moved to the old row perm[i].
+   * Gathers each array into a new block, so every element is moved exactly once.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicArrays<TGrowth, TArrays...>::applyPermutation(size_t* perm)
+  {
+    void* arrays[sizeof...(TArrays)];
+    void* data[numGroups];
+    size_t n[numGroups];
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+      n[group] = m_numAllocated[group];
+      data[group] = allocateArrays(group, n[group], arrays);
+    }
+
+    ForEachArray::gatherArrays(m_arrays, arrays, perm, m_numUsed);
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+      deallocateArrays(group, m_data[group], m_numAllocated[group]);
+
+      m_data[group] = data[group];
+      m_numAllocated[group] = n[group];
+    }
+
+    memcpy(&m_arrays[0], &arrays[0], sizeof(m_arrays));
+  }
+
+  /**
+   * Process all rows in parallel on the default thread pool, see below.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicArrays<TGrowth, TArrays...>::parallelForEach(TFunction fn, size_t grainSize)
+  {
+    parallelForEach<Indices...>(ThreadPool::defaultPool(), fn, grainSize);
+  }
+
+  /**
+   * Process all rows in parallel. [0, size()) is split into chunks of 
+   * grainSize rows (rounded up to a multiple of 64 rows, so every chunk spans
+   * whole cache lines of each array and no two threads write to the same
+   * cache line, the words of a bit array are not shared either). For each chunk
+   *   fn(begin, end, data<Indices>()...)
+   * is called, fn has to process the rows [begin, end) of the given arrays.
+   * Chunks are executed by the threads of pool (including the calling thread).
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicArrays<TGrowth, TArrays...>::parallelForEach(ThreadPool& pool, TFunction fn, size_t grainSize)
+  {
+    static const size_t chunkAlignment = 64;
+
+    const size_t num = m_numUsed;
+    const size_t chunkSize = grainSize > chunkAlignment ? ((grainSize + chunkAlignment - 1) / chunkAlignment) * chunkAlignment : chunkAlignment;
+    const size_t numChunks = (num + chunkSize - 1) / chunkSize;
+
+    pool.parallelFor(numChunks, [&](size_t chunk)
+    {
+      const size_t begin = chunk * chunkSize;
+      const size_t end = begin + chunkSize < num ? begin + chunkSize : num;
+      fn(begin, end, this->template data<Indices>()...);
+    });
+  }
 }
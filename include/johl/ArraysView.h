@@ -0,0 +1,448 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <johl/MmapAllocator.h>
+#include <cstdint>
+#include <ostream>
+#include <fstream>
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace johl
+{
+  namespace detail
+  {
+    /**
+     * Binary file format of save/ArraysView, native byte order:
+     *   FileHeader
+     *   FileColumn for each array
+     *   the elements of each array as one raw blob, at FileColumn::offset
+     *   (a multiple of fileAlignment and of the alignment of the array)
+     */
+    struct FileHeader
+    {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byteOrder;
+      std::uint64_t signature;
+      std::uint64_t numArrays;
+      std::uint64_t numRows;
+    };
+
+    struct FileColumn
+    {
+      std::uint64_t offset;
+      std::uint64_t elementSize;
+      std::uint64_t alignment;
+      std::uint64_t signature;
+    };
+
+    static const char fileMagic[8] = { 'j', 'o', 'h', 'l', 'a', 'r', 'r', 0 };
+    static const std::uint32_t fileVersion = 1;
+    static const std::uint32_t fileByteOrder = 0x01020304;
+    static const size_t fileAlignment = 64;
+
+    /**
+     * Signature of the type of an array: size, alignment and the kind of the
+     * type (bool, unsigned, signed, floating point, other, bits).
+     */
+    template<typename T>
+    struct ColumnSignature final
+    {
+      ColumnSignature() = delete;
+
+      using Type = typename AlignedType<T>::Type;
+
+      static const std::uint64_t kind = IsBitArray<T>::value ? 6
+        : std::is_same<Type, bool>::value ? 1
+        : std::is_floating_point<Type>::value ? 2
+        : std::is_integral<Type>::value && std::is_signed<Type>::value ? 3
+        : std::is_integral<Type>::value ? 4 : 5;
+
+      static const std::uint64_t value = (std::uint64_t)sizeof(Type) | ((std::uint64_t)AlignedType<T>::align << 24) | (kind << 56);
+    };
+
+    //FNV-1a of the signatures of all arrays
+    constexpr std::uint64_t hashSignatures(const std::uint64_t* signatures, size_t num, std::uint64_t hash = 14695981039346656037ull)
+    {
+      return num == 0 ? hash : hashSignatures(signatures + 1, num - 1, (hash ^ *signatures) * 1099511628211ull);
+    }
+
+    template<typename... TArrays>
+    struct FileSignature final
+    {
+      FileSignature() = delete;
+
+      static constexpr std::uint64_t columns[] = { ColumnSignature<TArrays>::value... };
+      static constexpr std::uint64_t value = hashSignatures(columns, sizeof...(TArrays));
+    };
+
+    template<typename... TArrays>
+    constexpr std::uint64_t FileSignature<TArrays...>::columns[];
+
+    //data() pointers of all arrays, in order
+    template<typename TArrays, size_t... Indices>
+    void arrayPointers(const TArrays& arrays, IndexSequence<Indices...>, const void** pointers)
+    {
+      const void* values[] = { arrays.template data<Indices>()... };
+      memcpy(pointers, values, sizeof(values));
+    }
+
+    //offset of the blob of array 'index' in a file with numRows rows
+    template<typename... TArrays>
+    size_t fileOffset(size_t index, size_t numRows)
+    {
+      using Layout = ArraysLayout<TArrays...>;
+
+      size_t offset = sizeof(FileHeader) + sizeof(FileColumn) * sizeof...(TArrays);
+      for (size_t i = 0; i <= index; ++i)
+      {
+        const size_t alignment = Layout::arrayAlignment(i) > fileAlignment ? Layout::arrayAlignment(i) : fileAlignment;
+        offset = alignUp(offset, alignment);
+        if (i < index)
+          offset += Layout::arrayBytes(i, numRows);
+      }
+
+      return offset;
+    }
+  }
+
+  /**
+   * Write all rows to a binary file (see ArraysView). Each array is written
+   * as one raw blob, so all arrays have to be trivially copyable.
+   * Returns false if writing failed.
+   */
+  template<typename TGrowth, typename... TArrays>
+  bool save(const BasicArrays<TGrowth, TArrays...>& arrays, std::ostream& out);
+
+  template<typename TGrowth, typename... TArrays>
+  bool save(const BasicArrays<TGrowth, TArrays...>& arrays, const char* path);
+
+  /**
+   * Read-only view of the rows of a file written by save. The file is
+   * mapped into memory (POSIX), the arrays point directly into the mapping,
+   * so opening a file is O(1) in the number of rows and pages are only read
+   * when they are first touched. Without mmap the file is read into memory.
+   * TArrays has to match the arrays of the saved object (including the
+   * alignment), open fails otherwise.
+   */
+  template<typename... TArrays>
+  class ArraysView final
+  {
+  private:
+    static_assert(detail::IsTriviallyRelocatable<TArrays...>::value, "ArraysView requires trivially copyable arrays");
+
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+  public:
+    ArraysView();
+    explicit ArraysView(const char* path);
+
+    ArraysView(const ArraysView& other) = delete;
+    ArraysView& operator=(const ArraysView& other) = delete;
+
+    ArraysView(ArraysView&& other) noexcept;
+    ArraysView& operator=(ArraysView&& other) noexcept;
+
+    ~ArraysView();
+
+    void swap(ArraysView& other) noexcept;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+
+    size_t size() const;
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+  private:
+    bool validate(size_t fileSize);
+
+    void*  m_file;
+    size_t m_fileSize;
+    size_t m_numRows;
+    const void* m_arrays[sizeof...(TArrays)];
+  };
+
+  //============================================================================
+
+  template<typename TGrowth, typename... TArrays>
+  bool save(const BasicArrays<TGrowth, TArrays...>& arrays, std::ostream& out)
+  {
+    static_assert(detail::IsTriviallyRelocatable<TArrays...>::value, "save requires trivially copyable arrays");
+
+    using Layout = ArraysLayout<TArrays...>;
+    using Signature = detail::FileSignature<TArrays...>;
+
+    const size_t numArrays = sizeof...(TArrays);
+    const size_t numRows = arrays.size();
+
+    detail::FileHeader header;
+    memcpy(header.magic, detail::fileMagic, sizeof(header.magic));
+    header.version = detail::fileVersion;
+    header.byteOrder = detail::fileByteOrder;
+    header.signature = Signature::value;
+    header.numArrays = numArrays;
+    header.numRows = numRows;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (size_t i = 0; i < numArrays; ++i)
+    {
+      detail::FileColumn column;
+      column.offset = detail::fileOffset<TArrays...>(i, numRows);
+      column.elementSize = Layout::arraySize(i);
+      column.alignment = Layout::arrayAlignment(i);
+      column.signature = Signature::columns[i];
+      out.write(reinterpret_cast<const char*>(&column), sizeof(column));
+    }
+
+    const void* data[numArrays];
+    detail::arrayPointers(arrays, typename detail::MakeIndexSequence<numArrays>::Type(), data);
+
+    static const char zeros[Layout::maxAlignment > detail::fileAlignment ? Layout::maxAlignment : detail::fileAlignment] = {};
+    size_t position = sizeof(header) + sizeof(detail::FileColumn) * numArrays;
+    for (size_t i = 0; i < numArrays; ++i)
+    {
+      const size_t offset = detail::fileOffset<TArrays...>(i, numRows);
+      out.write(zeros, offset - position); //padding is always less than the alignment of the array
+
+      out.write(static_cast<const char*>(data[i]), Layout::arrayBytes(i, numRows));
+      position = offset + Layout::arrayBytes(i, numRows);
+    }
+
+    return out.good();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  bool save(const BasicArrays<TGrowth, TArrays...>& arrays, const char* path)
+  {
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+
+    return save(arrays, out);
+  }
+
+  template<typename... TArrays>
+  ArraysView<TArrays...>::ArraysView()
+    : m_file(nullptr)
+    , m_fileSize(0)
+    , m_numRows(0)
+  {
+    memset(&m_arrays[0], 0, sizeof(m_arrays));
+  }
+
+  /**
+   * Opens path, check isOpen() for errors.
+   */
+  template<typename... TArrays>
+  ArraysView<TArrays...>::ArraysView(const char* path)
+    : ArraysView()
+  {
+    open(path);
+  }
+
+  template<typename... TArrays>
+  ArraysView<TArrays...>::ArraysView(ArraysView&& other) noexcept
+    : ArraysView()
+  {
+    swap(other);
+  }
+
+  template<typename... TArrays>
+  auto ArraysView<TArrays...>::operator=(ArraysView&& other) noexcept -> ArraysView&
+  {
+    if (this != &other)
+    {
+      ArraysView tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<typename... TArrays>
+  ArraysView<TArrays...>::~ArraysView()
+  {
+    close();
+  }
+
+  template<typename... TArrays>
+  void ArraysView<TArrays...>::swap(ArraysView& other) noexcept
+  {
+    std::swap(m_file, other.m_file);
+    std::swap(m_fileSize, other.m_fileSize);
+    std::swap(m_numRows, other.m_numRows);
+
+    for (size_t i = 0; i < sizeof...(TArrays); ++i)
+      std::swap(m_arrays[i], other.m_arrays[i]);
+  }
+
+  /**
+   * Maps the file at path, closes the current file first. Returns false if
+   * the file can not be read or was not written by save for the same
+   * arrays (the view is empty then).
+   */
+  template<typename... TArrays>
+  bool ArraysView<TArrays...>::open(const char* path)
+  {
+    close();
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(detail::FileHeader))
+    {
+      ::close(fd);
+      return false;
+    }
+
+    const size_t fileSize = (size_t)info.st_size;
+    void* file = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); //the mapping keeps the file open
+
+    if (file == MAP_FAILED)
+      return false;
+#else
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in)
+      return false;
+
+    in.seekg(0, std::ios::end);
+    const size_t fileSize = (size_t)in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (fileSize < sizeof(detail::FileHeader))
+      return false;
+
+    void* file = Allocator::defaultAllocator()->allocateAligned(fileSize, detail::fileAlignment);
+    if (!in.read(static_cast<char*>(file), fileSize))
+    {
+      Allocator::defaultAllocator()->deallocateSized(file, fileSize, detail::fileAlignment);
+      return false;
+    }
+#endif
+
+    m_file = file;
+    m_fileSize = fileSize;
+
+    if (!validate(fileSize))
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Checks the header and the columns and sets the array pointers.
+   */
+  template<typename... TArrays>
+  bool ArraysView<TArrays...>::validate(size_t fileSize)
+  {
+    using Layout = ArraysLayout<TArrays...>;
+    using Signature = detail::FileSignature<TArrays...>;
+
+    const size_t numArrays = sizeof...(TArrays);
+    const char* begin = static_cast<const char*>(m_file);
+
+    if (fileSize < sizeof(detail::FileHeader) + sizeof(detail::FileColumn) * numArrays)
+      return false;
+
+    detail::FileHeader header;
+    memcpy(&header, begin, sizeof(header));
+
+    if (memcmp(header.magic, detail::fileMagic, sizeof(header.magic)) != 0 || header.version != detail::fileVersion ||
+        header.byteOrder != detail::fileByteOrder || header.signature != Signature::value || header.numArrays != numArrays)
+      return false;
+
+    for (size_t i = 0; i < numArrays; ++i)
+    {
+      detail::FileColumn column;
+      memcpy(&column, begin + sizeof(header) + sizeof(column) * i, sizeof(column));
+
+      if (column.signature != Signature::columns[i] || column.elementSize != Layout::arraySize(i) || column.offset % Layout::arrayAlignment(i) != 0)
+        return false;
+
+      if (column.offset > fileSize)
+        return false;
+
+      const size_t available = fileSize - column.offset;
+      if (Layout::isBitArray(i) ? detail::bitarray::numWords(header.numRows) > available / sizeof(std::uint64_t) : header.numRows > available / column.elementSize)
+        return false;
+
+      m_arrays[i] = begin + column.offset;
+    }
+
+    m_numRows = (size_t)header.numRows;
+    return true;
+  }
+
+  template<typename... TArrays>
+  void ArraysView<TArrays...>::close()
+  {
+    if (!m_file)
+      return;
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+    munmap(m_file, m_fileSize);
+#else
+    Allocator::defaultAllocator()->deallocateSized(m_file, m_fileSize, detail::fileAlignment);
+#endif
+
+    m_file = nullptr;
+    m_fileSize = 0;
+    m_numRows = 0;
+    memset(&m_arrays[0], 0, sizeof(m_arrays));
+  }
+
+  template<typename... TArrays>
+  bool ArraysView<TArrays...>::isOpen() const
+  {
+    return m_file != nullptr;
+  }
+
+  template<typename... TArrays>
+  size_t ArraysView<TArrays...>::size() const
+  {
+    return m_numRows;
+  }
+
+  template<typename... TArrays>
+  template<size_t Index>
+  auto ArraysView<TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    static_assert(!detail::IsBitArray<typename detail::Get<Index, TArrays...>::Type>::value, "bit arrays have no ArrayRef, use data<Index>() to get the words");
+    return ArrayRef<const Type<Index>>(data<Index>(), m_numRows);
+  }
+
+  template<typename... TArrays>
+  template<size_t Index>
+  auto ArraysView<TArrays...>::data() const -> const Type<Index>*
+  {
+    return static_cast<const Type<Index>*>(m_arrays[Index]);
+  }
+
+  template<typename... TArrays>
+  template<size_t Index>
+  auto ArraysView<TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    static_assert(!detail::IsBitArray<typename detail::Get<Index, TArrays...>::Type>::value, "use testBit for bit arrays");
+    assert(i < m_numRows && "index i out of range");
+    return data<Index>()[i];
+  }
+}
@@ -0,0 +1,535 @@
+#pragma once
+#include <johl/Arrays.h>
+
+namespace johl
+{
+  namespace detail
+  {
+    //largest power of two number of rows (at least TRows) that fits into 
+    //64 KiB, so the chunks of small rows span whole pages
+    template<size_t TRowBytes, size_t TRows = 64, bool TGrow = (TRows * 2 * TRowBytes <= ((size_t)1 << 16))>
+    struct DefaultChunkRows final
+    {
+      DefaultChunkRows() = delete;
+      static const size_t value = DefaultChunkRows<TRowBytes, TRows * 2>::value;
+    };
+
+    template<size_t TRowBytes, size_t TRows>
+    struct DefaultChunkRows<TRowBytes, TRows, false> final
+    {
+      DefaultChunkRows() = delete;
+      static const size_t value = TRows;
+    };
+
+    //offsets of the arrays in a chunk of TRows rows, as a table (the 
+    //constexpr Layout::offset is too slow to be evaluated at runtime)
+    template<typename TLayout, size_t TRows, typename TSequence>
+    struct ChunkOffsets;
+
+    template<typename TLayout, size_t TRows, size_t... Indices>
+    struct ChunkOffsets<TLayout, TRows, IndexSequence<Indices...>> final
+    {
+      ChunkOffsets() = delete;
+      static constexpr size_t values[] = { TLayout::offset(Indices, TRows)... };
+    };
+
+    template<typename TLayout, size_t TRows, size_t... Indices>
+    constexpr size_t ChunkOffsets<TLayout, TRows, IndexSequence<Indices...>>::values[];
+  }
+
+  /**
+   * 'struct-of-arrays like' container that stores its rows in chunks of
+   * TChunkRows rows. Every chunk is one block of memory with the layout of
+   * Arrays<TArrays...> (see ArraysLayout), so the rows of a chunk can be
+   * processed with the same loops as the rows of an Arrays object.
+   * Growing allocates a new chunk, existing rows are never moved: pointers
+   * and references to elements stay valid until the row is removed (the
+   * last row is moved by removeAtUnordered).
+   * Row i is row (i % TChunkRows) of chunk (i / TChunkRows).
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  class BasicChunkedArrays final
+  {
+  private:
+    static_assert(TChunkRows > 0, "TChunkRows must be greater than zero");
+    static_assert(ArraysLayout<TArrays...>::bitsPerRow == ArraysLayout<TArrays...>::bytesPerRow * 8, "bit arrays are only supported by BasicArrays");
+
+    using ForEachArray = detail::arrays::ForEach<sizeof...(TArrays), 0, TArrays...>;
+
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+  public:
+    using Layout = ArraysLayout<TArrays...>;
+
+  private:
+    using Offsets = detail::ChunkOffsets<Layout, TChunkRows, typename detail::MakeIndexSequence<sizeof...(TArrays)>::Type>;
+
+  public:
+
+    static const size_t chunkRows = TChunkRows;
+
+    explicit BasicChunkedArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    BasicChunkedArrays(const BasicChunkedArrays& other);
+    BasicChunkedArrays& operator=(const BasicChunkedArrays& other);
+
+    BasicChunkedArrays(BasicChunkedArrays&& other) noexcept;
+    BasicChunkedArrays& operator=(BasicChunkedArrays&& other) noexcept;
+
+    ~BasicChunkedArrays();
+
+    void swap(BasicChunkedArrays& other) noexcept;
+
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+    void reserve(size_t n);
+    void releaseUnused();
+
+    size_t numChunks() const;
+    size_t chunkSize(size_t chunk) const;
+
+    template<size_t Index>
+    Type<Index>* chunkData(size_t chunk);
+
+    template<size_t Index>
+    const Type<Index>* chunkData(size_t chunk) const;
+
+    template<size_t Index>
+    ArrayRef<Type<Index>> chunkArray(size_t chunk);
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> chunkArray(size_t chunk) const;
+
+    template<size_t Index>
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<typename... TArgs>
+    void append(TArgs... args);
+
+    template<typename... TArgs>
+    auto emplaceBack(TArgs&&... args)
+      -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type;
+
+    void removeLast();
+    void removeAtUnordered(size_t index);
+
+    template<size_t... Indices, typename TFunction>
+    void forEachChunk(TFunction fn);
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(TFunction fn);
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(ThreadPool& pool, TFunction fn);
+
+  private:
+    void grow(size_t required);
+    void chunkArrays(size_t chunk, void** arrays) const;
+    void destructAll();
+    void deallocateChunks(size_t first);
+
+    size_t m_numUsed;
+    size_t m_numChunks;
+    size_t m_tableSize;
+    Allocator* m_allocator;
+    void** m_chunks;
+  };
+
+  template<size_t TChunkRows, typename... TArrays>
+  void swap(BasicChunkedArrays<TChunkRows, TArrays...>& a, BasicChunkedArrays<TChunkRows, TArrays...>& b) noexcept;
+
+  /**
+   * ChunkedArrays with chunks of (up to) 64 KiB.
+   */
+  template<typename... TArrays>
+  using ChunkedArrays = BasicChunkedArrays<detail::DefaultChunkRows<detail::SumSize<TArrays...>::value>::value, TArrays...>;
+
+  //============================================================================
+
+  template<size_t TChunkRows, typename... TArrays>
+  BasicChunkedArrays<TChunkRows, TArrays...>::BasicChunkedArrays(Allocator* allocator)
+    : m_numUsed(0)
+    , m_numChunks(0)
+    , m_tableSize(0)
+    , m_allocator(allocator)
+    , m_chunks(nullptr)
+  {
+    assert(m_allocator && "allocator must not be null");
+  }
+
+  /**
+   * Deep copy, uses the same allocator as other. Allocates only the chunks
+   * needed for other.size() rows.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  BasicChunkedArrays<TChunkRows, TArrays...>::BasicChunkedArrays(const BasicChunkedArrays& other)
+    : BasicChunkedArrays(other.m_allocator)
+  {
+    *this = other;
+  }
+
+  /**
+   * Deep copy, keeps the allocator (and the chunks) of this object.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::operator=(const BasicChunkedArrays& other) -> BasicChunkedArrays&
+  {
+    if (this == &other)
+      return *this;
+
+    clear();
+    reserve(other.m_numUsed);
+
+    for (size_t chunk = 0; chunk < other.numChunks(); ++chunk)
+    {
+      void* src[sizeof...(TArrays)];
+      void* dst[sizeof...(TArrays)];
+      other.chunkArrays(chunk, src);
+      chunkArrays(chunk, dst);
+      ForEachArray::copyArrays(src, dst, other.chunkSize(chunk));
+    }
+
+    m_numUsed = other.m_numUsed;
+    return *this;
+  }
+
+  /**
+   * Takes over the chunks (and the allocator) of other in O(1), see
+   * BasicArrays(BasicArrays&&).
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  BasicChunkedArrays<TChunkRows, TArrays...>::BasicChunkedArrays(BasicChunkedArrays&& other) noexcept
+    : m_numUsed(other.m_numUsed)
+    , m_numChunks(other.m_numChunks)
+    , m_tableSize(other.m_tableSize)
+    , m_allocator(other.m_allocator)
+    , m_chunks(other.m_chunks)
+  {
+    other.m_numUsed = 0;
+    other.m_numChunks = 0;
+    other.m_tableSize = 0;
+    other.m_chunks = nullptr;
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::operator=(BasicChunkedArrays&& other) noexcept -> BasicChunkedArrays&
+  {
+    if (this != &other)
+    {
+      BasicChunkedArrays tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  BasicChunkedArrays<TChunkRows, TArrays...>::~BasicChunkedArrays()
+  {
+    destructAll();
+    deallocateChunks(0);
+
+    if (m_chunks)
+      m_allocator->deallocate(m_chunks);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::swap(BasicChunkedArrays& other) noexcept
+  {
+    std::swap(m_numUsed, other.m_numUsed);
+    std::swap(m_numChunks, other.m_numChunks);
+    std::swap(m_tableSize, other.m_tableSize);
+    std::swap(m_allocator, other.m_allocator);
+    std::swap(m_chunks, other.m_chunks);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  void swap(BasicChunkedArrays<TChunkRows, TArrays...>& a, BasicChunkedArrays<TChunkRows, TArrays...>& b) noexcept
+  {
+    a.swap(b);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  size_t BasicChunkedArrays<TChunkRows, TArrays...>::size() const
+  {
+    return m_numUsed;
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  size_t BasicChunkedArrays<TChunkRows, TArrays...>::capacity() const
+  {
+    return m_numChunks * TChunkRows;
+  }
+
+  /**
+   * Destroys all rows, the chunks are kept for reuse (see releaseUnused).
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::clear()
+  {
+    destructAll();
+    m_numUsed = 0;
+  }
+
+  /**
+   * Allocate chunks until there is room for at least n rows. Never moves
+   * any rows, only the table of chunk pointers is reallocated.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::reserve(size_t n)
+  {
+    const size_t required = (n + TChunkRows - 1) / TChunkRows;
+    if (required <= m_numChunks)
+      return;
+
+    if (required > m_tableSize)
+    {
+      const size_t tableSize = required > m_tableSize * 2 ? required : m_tableSize * 2;
+      void** chunks = static_cast<void**>(m_allocator->allocate(sizeof(void*) * tableSize));
+      if (m_numChunks > 0)
+        memcpy(chunks, m_chunks, sizeof(void*) * m_numChunks);
+
+      if (m_chunks)
+        m_allocator->deallocate(m_chunks);
+      m_chunks = chunks;
+      m_tableSize = tableSize;
+    }
+
+    for (; m_numChunks < required; ++m_numChunks)
+      m_chunks[m_numChunks] = m_allocator->allocateAligned(Layout::bytes(TChunkRows), Layout::maxAlignment);
+  }
+
+  /**
+   * Returns the chunks that do not contain any rows to the allocator.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::releaseUnused()
+  {
+    deallocateChunks((m_numUsed + TChunkRows - 1) / TChunkRows);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  size_t BasicChunkedArrays<TChunkRows, TArrays...>::numChunks() const
+  {
+    return (m_numUsed + TChunkRows - 1) / TChunkRows;
+  }
+
+  /**
+   * Number of rows in the given chunk, TChunkRows for all but the last chunk.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  size_t BasicChunkedArrays<TChunkRows, TArrays...>::chunkSize(size_t chunk) const
+  {
+    assert(chunk < numChunks() && "chunk out of range");
+    const size_t begin = chunk * TChunkRows;
+    return m_numUsed - begin < TChunkRows ? m_numUsed - begin : TChunkRows;
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::chunkData(size_t chunk) -> Type<Index>*
+  {
+    return reinterpret_cast<Type<Index>*>(static_cast<char*>(m_chunks[chunk]) + Offsets::values[Index]);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::chunkData(size_t chunk) const -> const Type<Index>*
+  {
+    return reinterpret_cast<const Type<Index>*>(static_cast<const char*>(m_chunks[chunk]) + Offsets::values[Index]);
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::chunkArray(size_t chunk) -> ArrayRef<Type<Index>>
+  {
+    return ArrayRef<Type<Index>>(chunkData<Index>(chunk), chunkSize(chunk));
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::chunkArray(size_t chunk) const -> ArrayRef<const Type<Index>>
+  {
+    return ArrayRef<const Type<Index>>(chunkData<Index>(chunk), chunkSize(chunk));
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::at(size_t i) -> Type<Index>&
+  {
+    assert(i < m_numUsed && "index i out of range");
+    return chunkData<Index>(i / TChunkRows)[i % TChunkRows];
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    assert(i < m_numUsed && "index i out of range");
+    return chunkData<Index>(i / TChunkRows)[i % TChunkRows];
+  }
+
+  /**
+   * Append a row, see BasicArrays::append.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  template<typename... TArgs>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::append(TArgs... args)
+  {
+    static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
+
+    grow(m_numUsed + 1);
+
+    void* arrays[sizeof...(TArrays)];
+    chunkArrays(m_numUsed / TChunkRows, arrays);
+    ForEachArray::constructAt(arrays, m_numUsed % TChunkRows, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Append a row, see BasicArrays::emplaceBack.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  template<typename... TArgs>
+  auto BasicChunkedArrays<TChunkRows, TArrays...>::emplaceBack(TArgs&&... args)
+    -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type
+  {
+    grow(m_numUsed + 1);
+
+    void* arrays[sizeof...(TArrays)];
+    chunkArrays(m_numUsed / TChunkRows, arrays);
+    ForEachArray::constructAt(arrays, m_numUsed % TChunkRows, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::removeLast()
+  {
+    assert(m_numUsed > 0 && "container is empty");
+
+    --m_numUsed;
+
+    void* arrays[sizeof...(TArrays)];
+    chunkArrays(m_numUsed / TChunkRows, arrays);
+    ForEachArray::destructRange(arrays, m_numUsed % TChunkRows, 1);
+  }
+
+  /**
+   * Remove the row at index by moving the last row into its place, see
+   * BasicArrays::removeAtUnordered. The last row is the only row that moves.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::removeAtUnordered(size_t index)
+  {
+    assert(index < m_numUsed && "index out of range");
+
+    const size_t last = m_numUsed - 1;
+
+    void* arrays[sizeof...(TArrays)];
+    chunkArrays(index / TChunkRows, arrays);
+    ForEachArray::destructRange(arrays, index % TChunkRows, 1);
+
+    if (index != last)
+    {
+      void* lastArrays[sizeof...(TArrays)];
+      chunkArrays(last / TChunkRows, lastArrays);
+      ForEachArray::moveRange(lastArrays, last % TChunkRows, arrays, index % TChunkRows, 1);
+    }
+
+    --m_numUsed;
+  }
+
+  /**
+   * Process all rows chunk by chunk. For each chunk
+   *   fn(0, chunkSize(chunk), chunkData<Indices>(chunk)...)
+   * is called, so fn has the same signature as for BasicArrays::parallelForEach
+   * and can process the rows [begin, end) of the given arrays with the same
+   * tight loop.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::forEachChunk(TFunction fn)
+  {
+    const size_t num = numChunks();
+    for (size_t chunk = 0; chunk < num; ++chunk)
+      fn((size_t)0, chunkSize(chunk), chunkData<Indices>(chunk)...);
+  }
+
+  /**
+   * Process all rows in parallel on the default thread pool, see below.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::parallelForEach(TFunction fn)
+  {
+    parallelForEach<Indices...>(ThreadPool::defaultPool(), fn);
+  }
+
+  /**
+   * Same as forEachChunk, but the chunks are processed in parallel by the
+   * threads of pool (one task per chunk).
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::parallelForEach(ThreadPool& pool, TFunction fn)
+  {
+    pool.parallelFor(numChunks(), [&](size_t chunk)
+    {
+      fn((size_t)0, this->chunkSize(chunk), this->template chunkData<Indices>(chunk)...);
+    });
+  }
+
+  /**
+   * Grow by one chunk at a time, capacity is always a multiple of TChunkRows.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::grow(size_t required)
+  {
+    if (capacity() < required)
+      reserve(required);
+  }
+
+  /**
+   * set the array pointers of a chunk.
+   */
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::chunkArrays(size_t chunk, void** arrays) const
+  {
+    char* begin = static_cast<char*>(m_chunks[chunk]);
+    for (size_t i = 0; i < sizeof...(TArrays); ++i)
+      arrays[i] = begin + Offsets::values[i];
+  }
+
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::destructAll()
+  {
+    if (detail::IsTriviallyRelocatable<TArrays...>::value)
+      return;
+
+    const size_t num = numChunks();
+    for (size_t chunk = 0; chunk < num; ++chunk)
+    {
+      void* arrays[sizeof...(TArrays)];
+      chunkArrays(chunk, arrays);
+      ForEachArray::destructRange(arrays, 0, chunkSize(chunk));
+    }
+  }
+
+  //deallocate all chunks starting at first (must not contain any rows)
+  template<size_t TChunkRows, typename... TArrays>
+  void BasicChunkedArrays<TChunkRows, TArrays...>::deallocateChunks(size_t first)
+  {
+    for (size_t chunk = first; chunk < m_numChunks; ++chunk)
+      m_allocator->deallocateSized(m_chunks[chunk], Layout::bytes(TChunkRows), Layout::maxAlignment);
+
+    if (first < m_numChunks)
+      m_numChunks = first;
+  }
+}
@@ -0,0 +1,422 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <cstdint>
+
+namespace johl
+{
+  /**
+   * 32 bit handle of a row of a HandleArrays object: the index of a slot
+   * (lower indexBits bits) and the generation of the slot (upper bits).
+   * A default constructed handle is null and never refers to a row.
+   */
+  class Handle final
+  {
+  public:
+    static const unsigned indexBits = 24;
+    static const unsigned generationBits = 32 - indexBits;
+    static const std::uint32_t indexMask = ((std::uint32_t)1 << indexBits) - 1;
+    static const std::uint32_t generationMask = ~indexMask;
+
+    //the highest index is reserved for null handles
+    static const size_t maxSlots = indexMask;
+
+    Handle() : m_value(0xFFFFFFFF) {}
+    explicit Handle(std::uint32_t value) : m_value(value) {}
+    Handle(size_t index, std::uint32_t generation) : m_value((generation << indexBits) | (std::uint32_t)index) {}
+
+    std::uint32_t value() const { return m_value; }
+    size_t index() const { return m_value & indexMask; }
+    std::uint32_t generation() const { return m_value >> indexBits; }
+    bool isNull() const { return index() == maxSlots; }
+
+    bool operator==(Handle other) const { return m_value == other.m_value; }
+    bool operator!=(Handle other) const { return m_value != other.m_value; }
+
+  private:
+    std::uint32_t m_value;
+  };
+
+  /**
+   * Arrays with stable handles (sparse set). The rows are kept dense in an
+   * Arrays object, so the arrays are processed with the same loops as the
+   * arrays of an Arrays object (see data and parallelForEach). destroy
+   * moves the last row into the gap (swap-and-pop), which changes the row of
+   * the moved element but not its handle.
+   *
+   * Each handle refers to a slot, a slot stores the row of its element and
+   * the generation of the slot in one 32 bit word (same layout as a handle),
+   * so a lookup is a single load. destroy increments the generation of the
+   * slot, all handles to the destroyed row become invalid. Free slots are
+   * reused in FIFO order, but only once more than minFreeSlots slots are
+   * free, so a slot is reused (and its 8 bit generation wraps around) as
+   * rarely as possible.
+   * At most Handle::maxSlots slots (16M) can be allocated.
+   */
+  template<typename TGrowth, typename... TArrays>
+  class BasicHandleArrays final
+  {
+  private:
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+    //the rows of the arrays, followed by the slot index of each row
+    using Rows = BasicArrays<TGrowth, TArrays..., std::uint32_t>;
+
+    static const size_t slotArray = sizeof...(TArrays);
+
+  public:
+    using GrowthPolicy = TGrowth;
+
+    static const size_t minFreeSlots = 1024;
+
+    explicit BasicHandleArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    BasicHandleArrays(const BasicHandleArrays& other) = default;
+    BasicHandleArrays& operator=(const BasicHandleArrays& other) = default;
+
+    BasicHandleArrays(BasicHandleArrays&& other) noexcept;
+    BasicHandleArrays& operator=(BasicHandleArrays&& other) noexcept;
+
+    void swap(BasicHandleArrays& other) noexcept;
+
+    size_t size() const;
+    size_t capacity() const;
+    size_t numSlots() const;
+    void clear();
+    void reserve(size_t n);
+
+    template<typename... TArgs>
+    Handle create(TArgs&&... args);
+
+    void destroy(Handle handle);
+
+    bool contains(Handle handle) const;
+    size_t indexOf(Handle handle) const;
+    Handle handleAt(size_t index) const;
+
+    template<size_t Index>
+    Type<Index>& at(Handle handle);
+
+    template<size_t Index>
+    const Type<Index>& at(Handle handle) const;
+
+    template<size_t Index>
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    ArrayRef<Type<Index>> array();
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    Type<Index>* data();
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(TFunction fn, size_t grainSize = 4096);
+
+    template<size_t... Indices, typename TFunction>
+    void parallelForEach(ThreadPool& pool, TFunction fn, size_t grainSize = 4096);
+
+  private:
+    size_t allocateSlot();
+    void freeSlot(size_t slot);
+
+    Rows m_rows;
+    Arrays<std::uint32_t> m_slots;
+    size_t m_numFree;
+    size_t m_freeHead;
+    size_t m_freeTail;
+  };
+
+  /**
+   * HandleArrays with the default growth policy.
+   */
+  template<typename... TArrays>
+  using HandleArrays = BasicHandleArrays<geometric_growth<>, TArrays...>;
+
+  //============================================================================
+
+  template<typename TGrowth, typename... TArrays>
+  BasicHandleArrays<TGrowth, TArrays...>::BasicHandleArrays(Allocator* allocator)
+    : m_rows(allocator)
+    , m_slots(allocator)
+    , m_numFree(0)
+    , m_freeHead(0)
+    , m_freeTail(0)
+  {
+  }
+
+  /**
+   * O(1), see Arrays. All handles of other stay valid for this object, other
+   * is left empty.
+   */
+  template<typename TGrowth, typename... TArrays>
+  BasicHandleArrays<TGrowth, TArrays...>::BasicHandleArrays(BasicHandleArrays&& other) noexcept
+    : m_rows(std::move(other.m_rows))
+    , m_slots(std::move(other.m_slots))
+    , m_numFree(other.m_numFree)
+    , m_freeHead(other.m_freeHead)
+    , m_freeTail(other.m_freeTail)
+  {
+    other.m_numFree = 0;
+    other.m_freeHead = 0;
+    other.m_freeTail = 0;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  auto BasicHandleArrays<TGrowth, TArrays...>::operator=(BasicHandleArrays&& other) noexcept -> BasicHandleArrays&
+  {
+    if (this != &other)
+    {
+      BasicHandleArrays tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicHandleArrays<TGrowth, TArrays...>::swap(BasicHandleArrays& other) noexcept
+  {
+    m_rows.swap(other.m_rows);
+    m_slots.swap(other.m_slots);
+    std::swap(m_numFree, other.m_numFree);
+    std::swap(m_freeHead, other.m_freeHead);
+    std::swap(m_freeTail, other.m_freeTail);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicHandleArrays<TGrowth, TArrays...>::size() const
+  {
+    return m_rows.size();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicHandleArrays<TGrowth, TArrays...>::capacity() const
+  {
+    return m_rows.capacity();
+  }
+
+  /**
+   * Number of allocated slots (live and free).
+   */
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicHandleArrays<TGrowth, TArrays...>::numSlots() const
+  {
+    return m_slots.size();
+  }
+
+  /**
+   * Destroys all rows, all handles become invalid.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicHandleArrays<TGrowth, TArrays...>::clear()
+  {
+    const std::uint32_t* slots = m_rows.template data<slotArray>();
+    for (size_t i = 0; i < m_rows.size(); ++i)
+      freeSlot(slots[i]);
+
+    m_rows.clear();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicHandleArrays<TGrowth, TArrays...>::reserve(size_t n)
+  {
+    m_rows.reserve(n);
+    m_slots.reserve(n);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicHandleArrays<TGrowth, TArrays...>::allocateSlot()
+  {
+    if (m_numFree > minFreeSlots)
+    {
+      const size_t slot = m_freeHead;
+      m_freeHead = m_slots.template at<0>(slot) & Handle::indexMask;
+      --m_numFree;
+      return slot;
+    }
+
+    const size_t slot = m_slots.size();
+    assert(slot < Handle::maxSlots && "too many slots");
+    m_slots.append((std::uint32_t)0);
+    return slot;
+  }
+
+  /**
+   * Increments the generation of the slot and appends it to the free list
+   * (the index bits of a free slot link to the next free slot).
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicHandleArrays<TGrowth, TArrays...>::freeSlot(size_t slot)
+  {
+    std::uint32_t* slots = m_slots.template data<0>();
+    slots[slot] = (slots[slot] + ((std::uint32_t)1 << Handle::indexBits)) & Handle::generationMask;
+
+    if (m_numFree == 0)
+      m_freeHead = slot;
+    else
+      slots[m_freeTail] |= (std::uint32_t)slot;
+
+    m_freeTail = slot;
+    ++m_numFree;
+  }
+
+  /**
+   * Append a row, constructs each element in place from the perfectly
+   * forwarded argument for its column (see Arrays::emplaceBack).
+   * Returns the handle of the new row.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TArgs>
+  Handle BasicHandleArrays<TGrowth, TArrays...>::create(TArgs&&... args)
+  {
+    static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
+
+    const size_t slot = allocateSlot();
+    const size_t row = m_rows.size();
+    m_rows.emplaceBack(std::forward<TArgs>(args)..., (std::uint32_t)slot);
+
+    std::uint32_t& value = m_slots.template at<0>(slot);
+    value = (value & Handle::generationMask) | (std::uint32_t)row;
+    return Handle(slot, value >> Handle::indexBits);
+  }
+
+  /**
+   * Destroy the row of handle, the last row is moved into its place.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicHandleArrays<TGrowth, TArrays...>::destroy(Handle handle)
+  {
+    assert(contains(handle) && "invalid handle");
+
+    const size_t row = indexOf(handle);
+    const size_t last = m_rows.size() - 1;
+
+    if (row != last)
+    {
+      std::uint32_t& moved = m_slots.template at<0>(m_rows.template at<slotArray>(last));
+      moved = (moved & Handle::generationMask) | (std::uint32_t)row;
+    }
+
+    m_rows.removeAtUnordered(row);
+    freeSlot(handle.index());
+  }
+
+  /**
+   * true if handle refers to a row of this container.
+   */
+  template<typename TGrowth, typename... TArrays>
+  bool BasicHandleArrays<TGrowth, TArrays...>::contains(Handle handle) const
+  {
+    if (handle.index() >= m_slots.size())
+      return false;
+
+    //the index bits of free slots are not rows, check that the row links back
+    const std::uint32_t value = m_slots.template at<0>(handle.index());
+    const size_t row = value & Handle::indexMask;
+    return (value & Handle::generationMask) == (handle.value() & Handle::generationMask)
+      && row < m_rows.size() && m_rows.template at<slotArray>(row) == handle.index();
+  }
+
+  /**
+   * Current row of handle, changes when other rows are destroyed.
+   */
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicHandleArrays<TGrowth, TArrays...>::indexOf(Handle handle) const
+  {
+    assert(handle.index() < m_slots.size() && "invalid handle");
+
+    const std::uint32_t value = m_slots.template at<0>(handle.index());
+    assert((value & Handle::generationMask) == (handle.value() & Handle::generationMask) && "stale handle");
+
+    return value & Handle::indexMask;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  Handle BasicHandleArrays<TGrowth, TArrays...>::handleAt(size_t index) const
+  {
+    const size_t slot = m_rows.template at<slotArray>(index);
+    return Handle((m_slots.template at<0>(slot) & Handle::generationMask) | (std::uint32_t)slot);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::at(Handle handle) -> Type<Index>&
+  {
+    return m_rows.template data<Index>()[indexOf(handle)];
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::at(Handle handle) const -> const Type<Index>&
+  {
+    return m_rows.template data<Index>()[indexOf(handle)];
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::at(size_t i) -> Type<Index>&
+  {
+    return m_rows.template at<Index>(i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    return m_rows.template at<Index>(i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::array() -> ArrayRef<Type<Index>>
+  {
+    return m_rows.template array<Index>();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    return m_rows.template array<Index>();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::data() -> Type<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicHandleArrays<TGrowth, TArrays...>::data() const -> const Type<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  /**
+   * See Arrays::parallelForEach.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicHandleArrays<TGrowth, TArrays...>::parallelForEach(TFunction fn, size_t grainSize)
+  {
+    m_rows.template parallelForEach<Indices...>(fn, grainSize);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicHandleArrays<TGrowth, TArrays...>::parallelForEach(ThreadPool& pool, TFunction fn, size_t grainSize)
+  {
+    m_rows.template parallelForEach<Indices...>(pool, fn, grainSize);
+  }
+}
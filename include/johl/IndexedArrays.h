@@ -0,0 +1,489 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+
+namespace johl
+{
+  /**
+   * Arrays with a hash index on the key array TKeyIndex, which maps each key
+   * to its row (see find). The keys are unique, append and insertAt reject
+   * rows with a key that is already in the container.
+   *
+   * The index is an open addressing hash table with linear probing and a
+   * power of two number of slots, filled to at most one half. A slot stores
+   * the upper 32 bits of the (fibonacci) hash of its key and the row in one
+   * 64 bit word, so probing compares the stored hash bits and reads the key
+   * array only on a match. The home slot of a key is derived from the stored
+   * hash bits, erase moves the following slots of the probe sequence back
+   * (no tombstones) and the table is rebuilt from the key array when it
+   * grows.
+   * The index is updated by each operation that moves rows: removeAt and
+   * insertAt adjust the rows of all shifted keys in a single linear pass
+   * over the table, removeAtUnordered and swapAt only update the slots of
+   * the moved keys.
+   * The key array is read-only (const elements), the keys are hashed with std::hash and
+   * compared with operator==. At most 2^32 - 1 rows are supported.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  class BasicIndexedArrays final
+  {
+  private:
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+    //the elements of the key array are const
+    template<size_t Index>
+    using Element = typename std::conditional<Index == TKeyIndex, const Type<Index>, Type<Index>>::type;
+
+    using Rows = BasicArrays<TGrowth, TArrays...>;
+
+    static_assert(TKeyIndex < sizeof...(TArrays), "key index out of range");
+    static_assert(!Rows::template IsBitArray<TKeyIndex>::value, "bit arrays can not be key arrays");
+
+    static const std::uint64_t emptySlot = ~(std::uint64_t)0;
+    static const std::uint32_t emptyRow = 0xFFFFFFFF;
+    static const unsigned minSlotBits = 4;
+
+  public:
+    using GrowthPolicy = TGrowth;
+    using Key = Type<TKeyIndex>;
+
+    static const size_t npos = (size_t)-1;
+
+    explicit BasicIndexedArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    BasicIndexedArrays(const BasicIndexedArrays& other) = default;
+    BasicIndexedArrays& operator=(const BasicIndexedArrays& other) = default;
+
+    BasicIndexedArrays(BasicIndexedArrays&& other) noexcept;
+    BasicIndexedArrays& operator=(BasicIndexedArrays&& other) noexcept;
+
+    void swap(BasicIndexedArrays& other) noexcept;
+
+    size_t size() const;
+    size_t capacity() const;
+    size_t numSlots() const;
+    void clear();
+    void reserve(size_t n);
+
+    template<typename... TArgs>
+    bool append(TArgs&&... args);
+
+    template<typename... TArgs>
+    bool insertAt(size_t index, TArgs&&... args);
+
+    void removeAt(size_t index);
+    void removeAtUnordered(size_t index);
+    void swapAt(size_t a, size_t b);
+
+    template<size_t Index>
+    size_t find(const Key& key) const;
+
+    bool contains(const Key& key) const;
+
+    template<size_t Index>
+    Element<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    ArrayRef<Element<Index>> array();
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    Element<Index>* data();
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+  private:
+    static std::uint32_t hashOf(const Key& key);
+    size_t homeSlot(std::uint32_t hash) const;
+
+    size_t findSlot(const Key& key) const;
+    void insertSlot(std::uint32_t hash, size_t row);
+    void eraseSlot(size_t slot);
+    void shiftRows(size_t from, std::int64_t delta);
+    void rehash(unsigned slotBits);
+    void reserveSlots(size_t n);
+
+    Rows m_rows;
+    Arrays<std::uint64_t> m_slots;
+    unsigned m_slotBits;
+  };
+
+  /**
+   * IndexedArrays with the default growth policy.
+   */
+  template<size_t TKeyIndex, typename... TArrays>
+  using IndexedArrays = BasicIndexedArrays<geometric_growth<>, TKeyIndex, TArrays...>;
+
+  //============================================================================
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  const size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::npos;
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::BasicIndexedArrays(Allocator* allocator)
+    : m_rows(allocator)
+    , m_slots(allocator)
+    , m_slotBits(0)
+  {
+  }
+
+  /**
+   * O(1), see Arrays. other is left empty.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::BasicIndexedArrays(BasicIndexedArrays&& other) noexcept
+    : m_rows(std::move(other.m_rows))
+    , m_slots(std::move(other.m_slots))
+    , m_slotBits(other.m_slotBits)
+  {
+    other.m_slotBits = 0;
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::operator=(BasicIndexedArrays&& other) noexcept -> BasicIndexedArrays&
+  {
+    if (this != &other)
+    {
+      BasicIndexedArrays tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::swap(BasicIndexedArrays& other) noexcept
+  {
+    m_rows.swap(other.m_rows);
+    m_slots.swap(other.m_slots);
+    std::swap(m_slotBits, other.m_slotBits);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::size() const
+  {
+    return m_rows.size();
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::capacity() const
+  {
+    return m_rows.capacity();
+  }
+
+  /**
+   * Number of slots of the hash table (a power of two or zero).
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::numSlots() const
+  {
+    return m_slots.size();
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::clear()
+  {
+    m_rows.clear();
+
+    std::uint64_t* slots = m_slots.template data<0>();
+    for (size_t i = 0; i < m_slots.size(); ++i)
+      slots[i] = emptySlot;
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::reserve(size_t n)
+  {
+    m_rows.reserve(n);
+    reserveSlots(n);
+  }
+
+  /**
+   * Append a row, constructs each element in place from the perfectly
+   * forwarded argument for its array (see Arrays::emplaceBack).
+   * Returns false (and does not append) if the key is already in the
+   * container.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<typename... TArgs>
+  bool BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::append(TArgs&&... args)
+  {
+    return insertAt(m_rows.size(), std::forward<TArgs>(args)...);
+  }
+
+  /**
+   * Insert a row at index, the following rows are shifted by one (see
+   * Arrays::emplaceAt). Returns false (and does not insert) if the key is
+   * already in the container.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<typename... TArgs>
+  bool BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::insertAt(size_t index, TArgs&&... args)
+  {
+    static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
+    assert(index <= m_rows.size() && "index out of range");
+    assert(m_rows.size() < emptyRow && "too many rows");
+
+    const Key& key = std::get<TKeyIndex>(std::tie(args...));
+    const std::uint32_t hash = hashOf(key);
+    if (findSlot(key) != npos)
+      return false;
+
+    reserveSlots(m_rows.size() + 1);
+    if (index < m_rows.size())
+      shiftRows(index, 1);
+
+    insertSlot(hash, index);
+    m_rows.emplaceAt(index, std::forward<TArgs>(args)...);
+    return true;
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::removeAt(size_t index)
+  {
+    assert(index < m_rows.size() && "index out of range");
+
+    eraseSlot(findSlot(m_rows.template at<TKeyIndex>(index)));
+    if (index + 1 < m_rows.size())
+      shiftRows(index + 1, -1);
+
+    m_rows.removeAt(index);
+  }
+
+  /**
+   * Remove the row at index, the last row is moved into its place.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::removeAtUnordered(size_t index)
+  {
+    assert(index < m_rows.size() && "index out of range");
+
+    const size_t last = m_rows.size() - 1;
+    eraseSlot(findSlot(m_rows.template at<TKeyIndex>(index)));
+
+    if (index != last)
+    {
+      std::uint64_t& moved = m_slots.template at<0>(findSlot(m_rows.template at<TKeyIndex>(last)));
+      moved = (moved & ~(std::uint64_t)emptyRow) | index;
+    }
+
+    m_rows.removeAtUnordered(index);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::swapAt(size_t a, size_t b)
+  {
+    assert(a < m_rows.size() && b < m_rows.size() && "index out of range");
+
+    if (a == b)
+      return;
+
+    std::uint64_t& slotA = m_slots.template at<0>(findSlot(m_rows.template at<TKeyIndex>(a)));
+    std::uint64_t& slotB = m_slots.template at<0>(findSlot(m_rows.template at<TKeyIndex>(b)));
+    slotA = (slotA & ~(std::uint64_t)emptyRow) | b;
+    slotB = (slotB & ~(std::uint64_t)emptyRow) | a;
+
+    m_rows.swapAt(a, b);
+  }
+
+  /**
+   * Row of key, npos if the key is not in the container. Index has to be
+   * the key array.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::find(const Key& key) const
+  {
+    static_assert(Index == TKeyIndex, "find requires the key array");
+
+    const size_t slot = findSlot(key);
+    return slot == npos ? npos : (std::uint32_t)m_slots.template at<0>(slot);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  bool BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::contains(const Key& key) const
+  {
+    return findSlot(key) != npos;
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::at(size_t i) -> Element<Index>&
+  {
+    return m_rows.template at<Index>(i);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    return m_rows.template at<Index>(i);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::array() -> ArrayRef<Element<Index>>
+  {
+    return ArrayRef<Element<Index>>(m_rows.template data<Index>(), m_rows.size());
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    return m_rows.template array<Index>();
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::data() -> Element<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  template<size_t Index>
+  auto BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::data() const -> const Type<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  /**
+   * Upper 32 bits of the fibonacci hash of key, the upper bits of the
+   * product depend on all bits of std::hash (the identity for integers).
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  std::uint32_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::hashOf(const Key& key)
+  {
+    return (std::uint32_t)(((std::uint64_t)std::hash<Key>()(key) * 0x9E3779B97F4A7C15ull) >> 32);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::homeSlot(std::uint32_t hash) const
+  {
+    return hash >> (32 - m_slotBits);
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  size_t BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::findSlot(const Key& key) const
+  {
+    if (m_slots.size() == 0)
+      return npos;
+
+    const std::uint64_t* slots = m_slots.template data<0>();
+    const Key* keys = m_rows.template data<TKeyIndex>();
+    const size_t mask = m_slots.size() - 1;
+    const std::uint32_t hash = hashOf(key);
+
+    for (size_t i = homeSlot(hash);; i = (i + 1) & mask)
+    {
+      const std::uint64_t slot = slots[i];
+      if (slot == emptySlot)
+        return npos;
+
+      if ((std::uint32_t)(slot >> 32) == hash && keys[(std::uint32_t)slot] == key)
+        return i;
+    }
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::insertSlot(std::uint32_t hash, size_t row)
+  {
+    std::uint64_t* slots = m_slots.template data<0>();
+    const size_t mask = m_slots.size() - 1;
+
+    size_t i = homeSlot(hash);
+    while (slots[i] != emptySlot)
+      i = (i + 1) & mask;
+
+    slots[i] = ((std::uint64_t)hash << 32) | row;
+  }
+
+  /**
+   * Empties slot and moves back each following slot of the probe sequence
+   * whose home slot is not between the gap and itself, so lookups never
+   * stop early at the gap.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::eraseSlot(size_t slot)
+  {
+    assert(slot != npos && "key not in the index");
+
+    std::uint64_t* slots = m_slots.template data<0>();
+    const size_t mask = m_slots.size() - 1;
+
+    size_t gap = slot;
+    for (size_t i = (gap + 1) & mask; slots[i] != emptySlot; i = (i + 1) & mask)
+    {
+      const size_t home = homeSlot((std::uint32_t)(slots[i] >> 32));
+      if (((i - home) & mask) >= ((i - gap) & mask))
+      {
+        slots[gap] = slots[i];
+        gap = i;
+      }
+    }
+
+    slots[gap] = emptySlot;
+  }
+
+  /**
+   * Adds delta to all rows >= from, one branch-free pass over the table.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::shiftRows(size_t from, std::int64_t delta)
+  {
+    std::uint64_t* slots = m_slots.template data<0>();
+    const std::uint32_t first = (std::uint32_t)from;
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+      const std::uint32_t row = (std::uint32_t)slots[i];
+      const bool shifted = row >= first && row != emptyRow;
+      slots[i] += (std::uint64_t)(shifted ? delta : 0);
+    }
+  }
+
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::rehash(unsigned slotBits)
+  {
+    const size_t num = (size_t)1 << slotBits;
+
+    m_slots.clear();
+    m_slots.reserve(num);
+    for (size_t i = 0; i < num; ++i)
+      m_slots.append(emptySlot);
+
+    m_slotBits = slotBits;
+
+    const Key* keys = m_rows.template data<TKeyIndex>();
+    for (size_t row = 0; row < m_rows.size(); ++row)
+      insertSlot(hashOf(keys[row]), row);
+  }
+
+  /**
+   * Grows the table (rebuilding it from the key array) if n keys would fill
+   * it to more than one half.
+   */
+  template<typename TGrowth, size_t TKeyIndex, typename... TArrays>
+  void BasicIndexedArrays<TGrowth, TKeyIndex, TArrays...>::reserveSlots(size_t n)
+  {
+    if (n * 2 <= m_slots.size())
+      return;
+
+    unsigned slotBits = m_slotBits > minSlotBits ? m_slotBits : minSlotBits;
+    while (((size_t)1 << slotBits) < n * 2)
+      ++slotBits;
+
+    assert(slotBits <= 32 && "too many rows");
+    rehash(slotBits);
+  }
+}
@@ -0,0 +1,397 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <johl/detail/Kernels.h>
+
+namespace johl
+{
+namespace kernels
+{
+  /**
+   * Instruction set used by the kernels. Selected at runtime (see
+   * detectSimdLevel), can be lowered with setSimdLevel (e.g. for testing).
+   */
+  enum class SimdLevel
+  {
+    Scalar = 0,
+    SSE2 = 1,
+    AVX2 = 2,
+    AVX512 = 3
+  };
+
+  SimdLevel detectSimdLevel();
+  SimdLevel simdLevel();
+  void setSimdLevel(SimdLevel level);
+
+  //raw kernels, n is the number of floats
+  void axpy(size_t n, float a, const float* x, float* y);
+  void scale(size_t n, float a, float* x);
+
+  template<typename TFunction>
+  void map(size_t n, const float* x, float* y, TFunction f);
+
+  //masked kernels, rows * width floats, mask has one entry per row
+  void maskedAxpy(size_t rows, size_t width, float a, const bool* mask, const float* x, float* y);
+  void maskedAxpy(size_t rows, size_t width, float a, const std::uint64_t* mask, const float* x, float* y);
+
+  //reductions, rows * width floats, one result per component (width entries)
+  void sum(size_t rows, size_t width, const float* x, float* out);
+  void minMax(size_t rows, size_t width, const float* x, float* min, float* max);
+
+  //kernels on the arrays of an Arrays object
+  template<size_t Y, size_t X, typename TArrays>
+  void axpy(TArrays& arrays, float a);
+
+  template<size_t X, typename TArrays>
+  void scale(TArrays& arrays, float a);
+
+  template<size_t Y, size_t X, typename TArrays, typename TFunction>
+  void map(TArrays& arrays, TFunction f);
+
+  template<size_t Y, size_t X, size_t Mask, typename TArrays>
+  void maskedAxpy(TArrays& arrays, float a);
+
+  //============================================================================
+
+  namespace detail
+  {
+    inline SimdLevel& currentLevel()
+    {
+      static SimdLevel level = detectSimdLevel(); //threadsafe since C+11, thanks to 'magic statics'
+      return level;
+    }
+
+    //vector width in bytes of the given level, used to select aligned loads/stores
+    inline size_t vectorBytes(SimdLevel level)
+    {
+      switch (level)
+      {
+      case SimdLevel::AVX512: return 64;
+      case SimdLevel::AVX2:   return 32;
+      case SimdLevel::SSE2:   return 16;
+      case SimdLevel::Scalar: return 1;
+      }
+      return 1;
+    }
+
+    inline bool isAligned(const void* p, size_t alignment)
+    {
+      return ((std::uintptr_t)p % alignment) == 0;
+    }
+
+    /**
+     * Element type of array Index of an Arrays object. The kernels treat each
+     * element as sizeof(T) / sizeof(float) floats (e.g. float or a Vec4 of
+     * four floats).
+     */
+    template<size_t Index, typename TArrays>
+    struct FloatArray final
+    {
+      FloatArray() = delete;
+
+      using Type = typename std::remove_pointer<decltype(std::declval<TArrays&>().template data<Index>())>::type;
+      static_assert(johl::detail::is_trivially_copyable<Type>::value, "kernels require trivially copyable elements");
+      static_assert(sizeof(Type) % sizeof(float) == 0, "kernels require elements that consist of floats");
+
+      static const size_t width = sizeof(Type) / sizeof(float);
+
+      static float* data(TArrays& arrays)
+      {
+        return reinterpret_cast<float*>(arrays.template data<Index>());
+      }
+    };
+
+    /**
+     * True if array Index of an Arrays object can be used as a mask: a bool
+     * array, or a 'bits' array (the data are its words). Containers without
+     * IsBitArray only support bool masks.
+     */
+    template<size_t Index, typename TArrays>
+    struct IsMaskArray final
+    {
+      IsMaskArray() = delete;
+
+      using Type = typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<TArrays&>().template data<Index>())>::type>::type;
+
+      static const bool value = std::is_same<Type, bool>::value || johl::detail::IsBitArrayOf<Index, TArrays>::value;
+    };
+
+    template<size_t TWidth, typename TMask>
+    void maskedAxpy(size_t n, size_t width, float a, const TMask& mask, const float* x, float* y)
+    {
+      using namespace johl::detail::kernels;
+
+      const SimdLevel level = currentLevel();
+      const bool aligned = isAligned(x, vectorBytes(level)) && isAligned(y, vectorBytes(level));
+      johl::detail::unused(aligned);
+
+      switch (level)
+      {
+#if JOHL_KERNELS_X86
+      case SimdLevel::AVX512:
+        return aligned ? maskedAxpyAvx512<TWidth, true>(n, width, a, mask, x, y) : maskedAxpyAvx512<TWidth, false>(n, width, a, mask, x, y);
+      case SimdLevel::AVX2:
+        return aligned ? maskedAxpyAvx2<TWidth, true>(n, width, a, mask, x, y) : maskedAxpyAvx2<TWidth, false>(n, width, a, mask, x, y);
+      case SimdLevel::SSE2:
+        return aligned ? maskedAxpySse<TWidth, true>(n, width, a, mask, x, y) : maskedAxpySse<TWidth, false>(n, width, a, mask, x, y);
+#endif
+      default:
+        return maskedAxpyScalar<TWidth>(n, width, a, mask, x, y);
+      }
+    }
+
+    //selects a specialized implementation for common row widths
+    template<typename TMask>
+    void maskedAxpy(size_t rows, size_t width, float a, const TMask& mask, const float* x, float* y)
+    {
+      const size_t n = rows * width;
+
+      switch (width)
+      {
+      case 1:  return maskedAxpy<1>(n, width, a, mask, x, y);
+      case 2:  return maskedAxpy<2>(n, width, a, mask, x, y);
+      case 4:  return maskedAxpy<4>(n, width, a, mask, x, y);
+      case 8:  return maskedAxpy<8>(n, width, a, mask, x, y);
+      case 16: return maskedAxpy<16>(n, width, a, mask, x, y);
+      default: return maskedAxpy<0>(n, width, a, mask, x, y);
+      }
+    }
+  }
+
+  inline SimdLevel detectSimdLevel()
+  {
+#if JOHL_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+      return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+      return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+  }
+
+  inline SimdLevel simdLevel()
+  {
+    return detail::currentLevel();
+  }
+
+  /**
+   * Select the instruction set, levels above detectSimdLevel() are ignored.
+   * Not threadsafe, call it before running any kernels.
+   */
+  inline void setSimdLevel(SimdLevel level)
+  {
+    const SimdLevel supported = detectSimdLevel();
+    detail::currentLevel() = (int)level <= (int)supported ? level : supported;
+  }
+
+  /**
+   * y[i] += a * x[i]
+   */
+  inline void axpy(size_t n, float a, const float* x, float* y)
+  {
+    using namespace johl::detail::kernels;
+
+    const SimdLevel level = simdLevel();
+    const bool aligned = detail::isAligned(x, detail::vectorBytes(level)) && detail::isAligned(y, detail::vectorBytes(level));
+    johl::detail::unused(aligned);
+
+    switch (level)
+    {
+#if JOHL_KERNELS_X86
+    case SimdLevel::AVX512:
+      return aligned ? axpyAvx512<true>(n, a, x, y) : axpyAvx512<false>(n, a, x, y);
+    case SimdLevel::AVX2:
+      return aligned ? axpyAvx2<true>(n, a, x, y) : axpyAvx2<false>(n, a, x, y);
+    case SimdLevel::SSE2:
+      return aligned ? axpySse<true>(n, a, x, y) : axpySse<false>(n, a, x, y);
+#endif
+    default:
+      return axpyScalar(n, a, x, y);
+    }
+  }
+
+  /**
+   * x[i] *= a
+   */
+  inline void scale(size_t n, float a, float* x)
+  {
+    using namespace johl::detail::kernels;
+
+    const SimdLevel level = simdLevel();
+    const bool aligned = detail::isAligned(x, detail::vectorBytes(level));
+    johl::detail::unused(aligned);
+
+    switch (level)
+    {
+#if JOHL_KERNELS_X86
+    case SimdLevel::AVX512:
+      return aligned ? scaleAvx512<true>(n, a, x) : scaleAvx512<false>(n, a, x);
+    case SimdLevel::AVX2:
+      return aligned ? scaleAvx2<true>(n, a, x) : scaleAvx2<false>(n, a, x);
+    case SimdLevel::SSE2:
+      return aligned ? scaleSse<true>(n, a, x) : scaleSse<false>(n, a, x);
+#endif
+    default:
+      return scaleScalar(n, a, x);
+    }
+  }
+
+  /**
+   * y[i] = f(x[i]), x and y may be the same array.
+   * Plain loop over non-aliasing pointers, left to the auto-vectorizer of the
+   * compiler (f is arbitrary code).
+   */
+  template<typename TFunction>
+  void map(size_t n, const float* x, float* y, TFunction f)
+  {
+    if (x == y)
+    {
+      for (size_t i = 0; i < n; ++i)
+        y[i] = f(y[i]);
+    }
+    else
+    {
+      const float* __restrict src = x;
+      float* __restrict dst = y;
+      for (size_t i = 0; i < n; ++i)
+        dst[i] = f(src[i]);
+    }
+  }
+
+  /**
+   * y[r * width + k] += a * x[r * width + k] for all rows r with mask[r] == true
+   * (0 <= k < width).
+   */
+  inline void maskedAxpy(size_t rows, size_t width, float a, const bool* mask, const float* x, float* y)
+  {
+    const johl::detail::kernels::BoolMask m = { mask };
+    detail::maskedAxpy(rows, width, a, m, x, y);
+  }
+
+  /**
+   * Same as above, mask is a bit set (bit r % 64 of word r / 64 is row r).
+   */
+  inline void maskedAxpy(size_t rows, size_t width, float a, const std::uint64_t* mask, const float* x, float* y)
+  {
+    const johl::detail::kernels::BitMask m = { mask };
+    detail::maskedAxpy(rows, width, a, m, x, y);
+  }
+
+  /**
+   * out[k] = sum of x[r * width + k] over all rows r (0 <= k < width).
+   * Widths of 1, 2, 4, 8 and 16 floats are vectorized.
+   */
+  inline void sum(size_t rows, size_t width, const float* x, float* out)
+  {
+    using namespace johl::detail::kernels;
+
+    const size_t n = rows * width;
+    for (size_t k = 0; k < width; ++k)
+      out[k] = 0.0f;
+
+    const bool vectorized = width <= 16 && (width & (width - 1)) == 0;
+    switch (vectorized ? simdLevel() : SimdLevel::Scalar)
+    {
+#if JOHL_KERNELS_X86
+    case SimdLevel::AVX512:
+      return sumAvx512(n, width, x, out);
+    case SimdLevel::AVX2:
+      return sumAvx2(n, width, x, out);
+    case SimdLevel::SSE2:
+      return sumSse(n, width, x, out);
+#endif
+    default:
+      return sumScalar(0, n, width, x, out);
+    }
+  }
+
+  /**
+   * min[k] and max[k] = minimum and maximum of x[r * width + k] over all rows
+   * r (+infinity and -infinity without rows). NaNs are ignored.
+   */
+  inline void minMax(size_t rows, size_t width, const float* x, float* min, float* max)
+  {
+    using namespace johl::detail::kernels;
+
+    const size_t n = rows * width;
+    for (size_t k = 0; k < width; ++k)
+    {
+      min[k] = std::numeric_limits<float>::infinity();
+      max[k] = -std::numeric_limits<float>::infinity();
+    }
+
+    const bool vectorized = width <= 16 && (width & (width - 1)) == 0;
+    switch (vectorized ? simdLevel() : SimdLevel::Scalar)
+    {
+#if JOHL_KERNELS_X86
+    case SimdLevel::AVX512:
+      return minMaxAvx512(n, width, x, min, max);
+    case SimdLevel::AVX2:
+      return minMaxAvx2(n, width, x, min, max);
+    case SimdLevel::SSE2:
+      return minMaxSse(n, width, x, min, max);
+#endif
+    default:
+      return minMaxScalar(0, n, width, x, min, max);
+    }
+  }
+
+  /**
+   * arrays.data<Y>()[i] += a * arrays.data<X>()[i] for all rows, elementwise
+   * for elements that consist of multiple floats.
+   * Arrays declared with an alignment of at least the vector width (e.g.
+   * aligned<Vec4, 64>) always take the aligned load/store path.
+   */
+  template<size_t Y, size_t X, typename TArrays>
+  void axpy(TArrays& arrays, float a)
+  {
+    using ArrayY = detail::FloatArray<Y, TArrays>;
+    using ArrayX = detail::FloatArray<X, TArrays>;
+    static_assert(ArrayY::width == ArrayX::width, "arrays X and Y need elements of the same size");
+
+    axpy(arrays.size() * ArrayY::width, a, ArrayX::data(arrays), ArrayY::data(arrays));
+  }
+
+  /**
+   * arrays.data<X>()[i] *= a for all rows.
+   */
+  template<size_t X, typename TArrays>
+  void scale(TArrays& arrays, float a)
+  {
+    using ArrayX = detail::FloatArray<X, TArrays>;
+
+    scale(arrays.size() * ArrayX::width, a, ArrayX::data(arrays));
+  }
+
+  /**
+   * arrays.data<Y>()[i] = f(arrays.data<X>()[i]) for all floats of all rows.
+   */
+  template<size_t Y, size_t X, typename TArrays, typename TFunction>
+  void map(TArrays& arrays, TFunction f)
+  {
+    using ArrayY = detail::FloatArray<Y, TArrays>;
+    using ArrayX = detail::FloatArray<X, TArrays>;
+    static_assert(ArrayY::width == ArrayX::width, "arrays X and Y need elements of the same size");
+
+    map(arrays.size() * ArrayY::width, ArrayX::data(arrays), ArrayY::data(arrays), f);
+  }
+
+  /**
+   * arrays.data<Y>()[i] += a * arrays.data<X>()[i] for all rows i with
+   * a set mask bit. Array Mask has to be a bool array or a 'bits' array.
+   */
+  template<size_t Y, size_t X, size_t Mask, typename TArrays>
+  void maskedAxpy(TArrays& arrays, float a)
+  {
+    using ArrayY = detail::FloatArray<Y, TArrays>;
+    using ArrayX = detail::FloatArray<X, TArrays>;
+    static_assert(ArrayY::width == ArrayX::width, "arrays X and Y need elements of the same size");
+    static_assert(detail::IsMaskArray<Mask, TArrays>::value, "array Mask has to be a bool array or a bit array");
+
+    const auto* mask = arrays.template data<Mask>(); //bool* or the words of a bit array
+    maskedAxpy(arrays.size(), ArrayY::width, a, mask, ArrayX::data(arrays), ArrayY::data(arrays));
+  }
+}
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include <johl/Allocator.h>
+#include <johl/detail/Arrays.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+//virtual memory allocator, only available on POSIX systems
+#if defined(__unix__) || defined(__APPLE__)
+#define JOHL_HAS_MMAP_ALLOCATOR 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define JOHL_HAS_MMAP_ALLOCATOR 0
+#endif
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+namespace johl
+{
+  /**
+   * Allocator that maps each allocation to its own range of virtual memory.
+   * At least reserveBytes of address space are reserved for every allocation
+   * (allocateAtLeast reports all of it), physical pages are only committed
+   * by the operating system when they are first touched. Arrays created with
+   * this allocator grow within the reserved range without moving any rows.
+   *
+   * With hugePages the ranges are aligned to 2 MiB and transparent huge pages
+   * are requested (madvise(MADV_HUGEPAGE), where available), which reduces
+   * TLB misses of random accesses into large arrays.
+   * decommit returns the pages to the operating system (MADV_DONTNEED), they
+   * read as zero when touched again.
+   *
+   * Every allocation costs at least one page and a system call, use it for a
+   * few large containers, not for many small ones. Throws std::bad_alloc if
+   * the address space cannot be mapped. Threadsafe.
+   */
+  class MmapAllocator final : public Allocator
+  {
+  public:
+    explicit MmapAllocator(size_t reserveBytes = sizeof(void*) >= 8 ? (size_t)1 << 34 : (size_t)1 << 28, bool hugePages = true);
+
+    virtual void* allocate(size_t size) override;
+    virtual void deallocate(void* p) override;
+    virtual void* allocateAligned(size_t size, size_t alignment) override;
+    virtual void* allocateAtLeast(size_t size, size_t alignment, size_t& allocatedSize) override;
+    virtual void deallocateSized(void* p, size_t size, size_t alignment) override;
+    virtual bool tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment) override;
+    virtual void* reallocate(void* p, size_t oldSize, size_t newSize, size_t alignment) override;
+    virtual void decommit(void* p, size_t size) override;
+
+    size_t reserveBytes() const;
+    bool hugePages() const;
+
+    static size_t pageSize();
+    static const size_t hugePageSize = (size_t)1 << 21;
+
+  private:
+    //stored in front of every allocation
+    struct Header
+    {
+      char* mapping;
+      size_t mappingSize;
+    };
+
+    static Header* headerOf(void* p);
+    static size_t usableSize(void* p);
+    static size_t roundUp(size_t size, size_t alignment);
+
+    size_t m_reserveBytes;
+    bool m_hugePages;
+  };
+
+  //============================================================================
+
+  inline MmapAllocator::MmapAllocator(size_t reserveBytes, bool hugePages)
+    : m_reserveBytes(reserveBytes)
+    , m_hugePages(hugePages)
+  {
+  }
+
+  inline size_t MmapAllocator::reserveBytes() const
+  {
+    return m_reserveBytes;
+  }
+
+  inline bool MmapAllocator::hugePages() const
+  {
+    return m_hugePages;
+  }
+
+  inline size_t MmapAllocator::pageSize()
+  {
+    static const size_t size = (size_t)sysconf(_SC_PAGESIZE); //threadsafe since C+11, thanks to 'magic statics'
+    return size;
+  }
+
+  inline size_t MmapAllocator::roundUp(size_t size, size_t alignment)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  inline auto MmapAllocator::headerOf(void* p) -> Header*
+  {
+    return static_cast<Header*>(p) - 1;
+  }
+
+  inline size_t MmapAllocator::usableSize(void* p)
+  {
+    const Header* header = headerOf(p);
+    return header->mappingSize - (size_t)(static_cast<char*>(p) - header->mapping);
+  }
+
+  inline void* MmapAllocator::allocate(size_t size)
+  {
+    return allocateAligned(size, alignof(std::max_align_t));
+  }
+
+  inline void* MmapAllocator::allocateAligned(size_t size, size_t alignment)
+  {
+    size_t allocatedSize;
+    return allocateAtLeast(size, alignment, allocatedSize);
+  }
+
+  /**
+   * Maps max(size, reserveBytes) bytes (plus the header). The mapping is
+   * over-allocated by its alignment and trimmed, so it starts at a multiple
+   * of the page (or huge page) size.
+   */
+  inline void* MmapAllocator::allocateAtLeast(size_t size, size_t alignment, size_t& allocatedSize)
+  {
+    const size_t page = pageSize();
+    const size_t offset = roundUp(sizeof(Header), alignment > alignof(std::max_align_t) ? alignment : alignof(std::max_align_t));
+    const size_t mappingAlignment = m_hugePages && offset <= hugePageSize ? hugePageSize : roundUp(offset, page);
+    const size_t mappingSize = roundUp(offset + (size > m_reserveBytes ? size : m_reserveBytes), page);
+
+    const size_t mappedSize = mappingSize + mappingAlignment - page;
+    void* mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapped == MAP_FAILED)
+      throw std::bad_alloc();
+
+    char* begin = static_cast<char*>(mapped);
+    char* mapping = begin + (mappingAlignment - (size_t)((std::uintptr_t)begin % mappingAlignment)) % mappingAlignment;
+    char* end = begin + mappedSize;
+
+    if (mapping > begin)
+      munmap(begin, (size_t)(mapping - begin));
+    if (mapping + mappingSize < end)
+      munmap(mapping + mappingSize, (size_t)(end - mapping - mappingSize));
+
+#ifdef MADV_HUGEPAGE
+    if (m_hugePages)
+      madvise(mapping, mappingSize, MADV_HUGEPAGE);
+#endif
+
+    void* p = mapping + offset;
+    Header* header = headerOf(p);
+    header->mapping = mapping;
+    header->mappingSize = mappingSize;
+
+    allocatedSize = mappingSize - offset;
+    return p;
+  }
+
+  inline void MmapAllocator::deallocate(void* p)
+  {
+    if (!p)
+      return;
+
+    const Header* header = headerOf(p);
+    munmap(header->mapping, header->mappingSize);
+  }
+
+  inline void MmapAllocator::deallocateSized(void* p, size_t size, size_t alignment)
+  {
+    detail::unused(size, alignment);
+    deallocate(p);
+  }
+
+  inline bool MmapAllocator::tryExpand(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+    detail::unused(oldSize, alignment);
+    return newSize <= usableSize(p);
+  }
+
+  /**
+   * Blocks that outgrow their reserved range are moved with mremap on Linux,
+   * which remaps the pages instead of copying them. If that fails, the block
+   * is copied into a new mapping.
+   */
+  inline void* MmapAllocator::reallocate(void* p, size_t oldSize, size_t newSize, size_t alignment)
+  {
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+    if (p && !tryExpand(p, oldSize, newSize, alignment))
+    {
+      Header* header = headerOf(p);
+      const size_t offset = (size_t)(static_cast<char*>(p) - header->mapping);
+      const size_t mappingSize = roundUp(offset + newSize, pageSize());
+
+      void* mapping = mremap(header->mapping, header->mappingSize, mappingSize, MREMAP_MAYMOVE);
+      if (mapping != MAP_FAILED)
+      {
+        char* q = static_cast<char*>(mapping) + offset;
+        headerOf(q)->mapping = static_cast<char*>(mapping);
+        headerOf(q)->mappingSize = mappingSize;
+        return q;
+      }
+    }
+#endif
+
+    return Allocator::reallocate(p, oldSize, newSize, alignment);
+  }
+
+  /**
+   * Releases all whole pages in [p, p + size).
+   */
+  inline void MmapAllocator::decommit(void* p, size_t size)
+  {
+    const size_t page = pageSize();
+    const std::uintptr_t begin = roundUp((std::uintptr_t)p, page);
+    const std::uintptr_t end = ((std::uintptr_t)p + size) / page * page;
+
+    if (begin < end)
+      madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+  }
+}
+
+#endif
@@ -0,0 +1,502 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <johl/Kernels.h>
+#include <johl/ThreadPool.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace johl
+{
+  //rows per task of the parallel reductions (rounded up to a multiple of 64)
+  static const size_t reduceGrainSize = 1 << 16;
+
+  /**
+   * Opt-in for sum and minMax of elements that are not arithmetic: specialize
+   * it as std::true_type for types that consist of floats only (e.g. a Vec4
+   * of four floats), they are reduced per component.
+   */
+  template<typename T>
+  struct is_float_vector : std::false_type
+  {
+  };
+
+  namespace detail
+  {
+    //element type of array Index of an Arrays object (or any container with data<Index>())
+    template<size_t Index, typename TArrays>
+    using ElementType = typename std::remove_const<typename std::remove_pointer<decltype(std::declval<const TArrays&>().template data<Index>())>::type>::type;
+  }
+
+  /**
+   * Reductions over the elements of array Index. Each function has a
+   * parallel overload that takes a ThreadPool: the rows are split into chunks
+   * of grainSize rows (independent of the number of threads), each chunk is
+   * reduced by one task and the results of the chunks are combined in order
+   * of the chunks, so the result does not depend on the scheduling.
+   * Parallel float sums may differ from sequential ones in the last bits
+   * (the additions are grouped differently).
+   * Not for bit arrays (see countBits).
+   */
+  template<size_t Index, typename TArrays, typename T, typename TOperation>
+  T reduce(const TArrays& arrays, T init, TOperation op);
+
+  template<size_t Index, typename TArrays, typename T, typename TOperation>
+  T reduce(ThreadPool& pool, const TArrays& arrays, T init, TOperation op, size_t grainSize = reduceGrainSize);
+
+  template<size_t Index, typename TArrays>
+  detail::ElementType<Index, TArrays> sum(const TArrays& arrays);
+
+  template<size_t Index, typename TArrays>
+  detail::ElementType<Index, TArrays> sum(ThreadPool& pool, const TArrays& arrays, size_t grainSize = reduceGrainSize);
+
+  template<size_t Index, typename TArrays>
+  std::pair<detail::ElementType<Index, TArrays>, detail::ElementType<Index, TArrays>> minMax(const TArrays& arrays);
+
+  template<size_t Index, typename TArrays>
+  std::pair<detail::ElementType<Index, TArrays>, detail::ElementType<Index, TArrays>> minMax(ThreadPool& pool, const TArrays& arrays, size_t grainSize = reduceGrainSize);
+
+  template<size_t Index, typename TArrays, typename TPredicate>
+  size_t count(const TArrays& arrays, TPredicate pred);
+
+  template<size_t Index, typename TArrays, typename TPredicate>
+  size_t count(ThreadPool& pool, const TArrays& arrays, TPredicate pred, size_t grainSize = reduceGrainSize);
+
+  template<size_t Index, typename TArrays, typename TBin>
+  void histogram(const TArrays& arrays, size_t numBins, TBin binOf, size_t* counts);
+
+  template<size_t Index, typename TArrays, typename TBin>
+  void histogram(ThreadPool& pool, const TArrays& arrays, size_t numBins, TBin binOf, size_t* counts, size_t grainSize = reduceGrainSize);
+
+  /**
+   * Bin function for histogram: numBins bins of equal width between min and
+   * max, values outside of [min, max) are counted in the first or last bin.
+   */
+  template<typename T>
+  struct UniformBins
+  {
+    T min;
+    double scale;
+    size_t numBins;
+
+    size_t operator()(T value) const
+    {
+      if (!(value > min))
+        return 0;
+
+      const double bin = (double)(value - min) * scale;
+      return bin < (double)(numBins - 1) ? (size_t)bin : numBins - 1;
+    }
+  };
+
+  template<typename T>
+  UniformBins<T> uniformBins(T min, T max, size_t numBins);
+
+  //============================================================================
+
+  namespace detail
+  {
+    /**
+     * Reduces the chunks of [0, num) on the pool with f(begin, end) and
+     * combines the results in order of the chunks.
+     */
+    template<typename T, typename TFunction, typename TCombine>
+    T reduceChunks(ThreadPool& pool, size_t num, size_t grainSize, T init, TFunction f, TCombine combine)
+    {
+      static const size_t chunkAlignment = 64;
+
+      const size_t chunkSize = grainSize > chunkAlignment ? ((grainSize + chunkAlignment - 1) / chunkAlignment) * chunkAlignment : chunkAlignment;
+      const size_t numChunks = (num + chunkSize - 1) / chunkSize;
+
+      Arrays<T> partials;
+      partials.reserve(numChunks);
+      for (size_t chunk = 0; chunk < numChunks; ++chunk)
+        partials.append(init);
+
+      T* results = partials.template data<0>();
+      pool.parallelFor(numChunks, [&](size_t chunk)
+      {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = begin + chunkSize < num ? begin + chunkSize : num;
+        results[chunk] = f(begin, end);
+      });
+
+      T result = init;
+      for (size_t chunk = 0; chunk < numChunks; ++chunk)
+        result = combine(result, results[chunk]);
+
+      return result;
+    }
+
+    template<typename T>
+    T largest()
+    {
+      return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+
+    template<typename T>
+    T smallest()
+    {
+      return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    }
+
+    /**
+     * sum and minMax of the rows [begin, end) for arithmetic types, with four
+     * independent accumulators. Floats and float vectors (see
+     * is_float_vector) use the simd kernels, see below.
+     */
+    template<typename T, bool = std::is_arithmetic<T>::value>
+    struct Reduction final
+    {
+      Reduction() = delete;
+
+      static T sum(const T* x, size_t begin, size_t end)
+      {
+        T acc[4] = { T(), T(), T(), T() };
+
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+          acc[0] += x[i];
+          acc[1] += x[i + 1];
+          acc[2] += x[i + 2];
+          acc[3] += x[i + 3];
+        }
+        for (; i < end; ++i)
+          acc[0] += x[i];
+
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+      }
+
+      static T add(const T& a, const T& b)
+      {
+        return a + b;
+      }
+
+      static std::pair<T, T> minMax(const T* x, size_t begin, size_t end)
+      {
+        T mins[4] = { largest<T>(), largest<T>(), largest<T>(), largest<T>() };
+        T maxs[4] = { smallest<T>(), smallest<T>(), smallest<T>(), smallest<T>() };
+
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+          for (size_t k = 0; k < 4; ++k)
+          {
+            mins[k] = x[i + k] < mins[k] ? x[i + k] : mins[k];
+            maxs[k] = x[i + k] > maxs[k] ? x[i + k] : maxs[k];
+          }
+        }
+        for (; i < end; ++i)
+        {
+          mins[0] = x[i] < mins[0] ? x[i] : mins[0];
+          maxs[0] = x[i] > maxs[0] ? x[i] : maxs[0];
+        }
+
+        std::pair<T, T> result = minMaxIdentity();
+        for (size_t k = 0; k < 4; ++k)
+          result = combineMinMax(result, std::make_pair(mins[k], maxs[k]));
+
+        return result;
+      }
+
+      static std::pair<T, T> minMaxIdentity()
+      {
+        return std::make_pair(largest<T>(), smallest<T>());
+      }
+
+      static std::pair<T, T> combineMinMax(const std::pair<T, T>& a, const std::pair<T, T>& b)
+      {
+        return std::make_pair(b.first < a.first ? b.first : a.first, b.second > a.second ? b.second : a.second);
+      }
+    };
+
+    //elements of one or more floats, reduced per component with the simd kernels
+    template<typename T>
+    struct FloatReduction
+    {
+      FloatReduction() = delete;
+
+      static_assert(is_trivially_copyable<T>::value, "reductions require arithmetic or trivially copyable elements");
+      static_assert(sizeof(T) % sizeof(float) == 0, "reductions of non-arithmetic elements require elements that consist of floats");
+
+      static const size_t width = sizeof(T) / sizeof(float);
+
+      static T fromFloats(const float* values)
+      {
+        T result;
+        memcpy(&result, values, sizeof(T));
+        return result;
+      }
+
+      static T sum(const T* x, size_t begin, size_t end)
+      {
+        float out[width];
+        johl::kernels::sum(end - begin, width, reinterpret_cast<const float*>(x + begin), out);
+        return fromFloats(out);
+      }
+
+      static T add(const T& a, const T& b)
+      {
+        const float* fa = reinterpret_cast<const float*>(&a);
+        const float* fb = reinterpret_cast<const float*>(&b);
+
+        float out[width];
+        for (size_t k = 0; k < width; ++k)
+          out[k] = fa[k] + fb[k];
+        return fromFloats(out);
+      }
+
+      static std::pair<T, T> minMax(const T* x, size_t begin, size_t end)
+      {
+        float min[width], max[width];
+        johl::kernels::minMax(end - begin, width, reinterpret_cast<const float*>(x + begin), min, max);
+        return std::make_pair(fromFloats(min), fromFloats(max));
+      }
+
+      static std::pair<T, T> minMaxIdentity()
+      {
+        float min[width], max[width];
+        johl::kernels::minMax(0, width, nullptr, min, max);
+        return std::make_pair(fromFloats(min), fromFloats(max));
+      }
+
+      static std::pair<T, T> combineMinMax(const std::pair<T, T>& a, const std::pair<T, T>& b)
+      {
+        const float* mins[2] = { reinterpret_cast<const float*>(&a.first), reinterpret_cast<const float*>(&b.first) };
+        const float* maxs[2] = { reinterpret_cast<const float*>(&a.second), reinterpret_cast<const float*>(&b.second) };
+
+        float min[width], max[width];
+        for (size_t k = 0; k < width; ++k)
+        {
+          min[k] = mins[1][k] < mins[0][k] ? mins[1][k] : mins[0][k];
+          max[k] = maxs[1][k] > maxs[0][k] ? maxs[1][k] : maxs[0][k];
+        }
+        return std::make_pair(fromFloats(min), fromFloats(max));
+      }
+    };
+
+    template<>
+    struct Reduction<float, true> final : FloatReduction<float>
+    {
+    };
+
+    template<typename T>
+    struct Reduction<T, false> final : FloatReduction<T>
+    {
+      static_assert(is_float_vector<T>::value, "sum and minMax require arithmetic elements or float vectors (specialize johl::is_float_vector)");
+    };
+
+    template<typename T, typename TPredicate>
+    size_t countRange(const T* x, size_t begin, size_t end, TPredicate& pred)
+    {
+      size_t n[4] = { 0, 0, 0, 0 };
+
+      size_t i = begin;
+      for (; i + 4 <= end; i += 4)
+      {
+        n[0] += pred(x[i]) ? 1 : 0;
+        n[1] += pred(x[i + 1]) ? 1 : 0;
+        n[2] += pred(x[i + 2]) ? 1 : 0;
+        n[3] += pred(x[i + 3]) ? 1 : 0;
+      }
+      for (; i < end; ++i)
+        n[0] += pred(x[i]) ? 1 : 0;
+
+      return (n[0] + n[1]) + (n[2] + n[3]);
+    }
+
+    /**
+     * Adds the histogram of the rows [begin, end) to counts. Counts into four
+     * interleaved sub-histograms, so runs of the same bin do not wait for the
+     * previous increment of the same counter. The sub-histograms are added
+     * to counts while holding mutex (if not null).
+     */
+    template<typename T, typename TBin>
+    void histogramRange(const T* x, size_t begin, size_t end, size_t numBins, TBin& binOf, size_t* counts, std::mutex* mutex)
+    {
+      //small histograms are counted on the stack
+      static const size_t maxStackBins = 256;
+      size_t stack[4 * maxStackBins];
+      std::unique_ptr<size_t[]> heap(numBins > maxStackBins ? new size_t[4 * numBins] : nullptr);
+
+      size_t* bins = numBins > maxStackBins ? heap.get() : stack;
+      memset(bins, 0, sizeof(size_t) * 4 * numBins);
+      size_t* c[4] = { bins, bins + numBins, bins + 2 * numBins, bins + 3 * numBins };
+
+      size_t i = begin;
+      for (; i + 4 <= end; i += 4)
+      {
+        for (size_t k = 0; k < 4; ++k)
+        {
+          const size_t bin = binOf(x[i + k]);
+          assert(bin < numBins && "bin out of range");
+          ++c[k][bin];
+        }
+      }
+      for (; i < end; ++i)
+      {
+        const size_t bin = binOf(x[i]);
+        assert(bin < numBins && "bin out of range");
+        ++c[0][bin];
+      }
+
+      std::unique_lock<std::mutex> lock;
+      if (mutex)
+        lock = std::unique_lock<std::mutex>(*mutex);
+
+      for (size_t b = 0; b < numBins; ++b)
+        counts[b] += (c[0][b] + c[1][b]) + (c[2][b] + c[3][b]);
+    }
+  }
+
+  /**
+   * Left fold of the elements of array Index: init = op(init, x) for each
+   * element x, in order of the rows.
+   */
+  template<size_t Index, typename TArrays, typename T, typename TOperation>
+  T reduce(const TArrays& arrays, T init, TOperation op)
+  {
+    const auto* x = arrays.template data<Index>();
+    const size_t num = arrays.size();
+
+    for (size_t i = 0; i < num; ++i)
+      init = op(init, x[i]);
+
+    return init;
+  }
+
+  /**
+   * Parallel reduce, each chunk is folded starting with init, the results of
+   * the chunks are combined with op(a, b). op has to be associative and init
+   * its identity (e.g. 0 for a sum).
+   */
+  template<size_t Index, typename TArrays, typename T, typename TOperation>
+  T reduce(ThreadPool& pool, const TArrays& arrays, T init, TOperation op, size_t grainSize)
+  {
+    const auto* x = arrays.template data<Index>();
+
+    return detail::reduceChunks(pool, arrays.size(), grainSize, init, [&](size_t begin, size_t end)
+    {
+      T result = init;
+      for (size_t i = begin; i < end; ++i)
+        result = op(result, x[i]);
+      return result;
+    }, op);
+  }
+
+  /**
+   * Sum of all elements of array Index. Elements that are not arithmetic
+   * have to be float vectors (see is_float_vector), they are summed per
+   * component (e.g. the sum of the x, y, z and w of a Vec4).
+   */
+  template<size_t Index, typename TArrays>
+  detail::ElementType<Index, TArrays> sum(const TArrays& arrays)
+  {
+    using Reduction = detail::Reduction<detail::ElementType<Index, TArrays>>;
+    return Reduction::sum(arrays.template data<Index>(), 0, arrays.size());
+  }
+
+  template<size_t Index, typename TArrays>
+  detail::ElementType<Index, TArrays> sum(ThreadPool& pool, const TArrays& arrays, size_t grainSize)
+  {
+    using T = detail::ElementType<Index, TArrays>;
+    using Reduction = detail::Reduction<T>;
+
+    const T* x = arrays.template data<Index>();
+    return detail::reduceChunks(pool, arrays.size(), grainSize, Reduction::sum(x, 0, 0),
+      [x](size_t begin, size_t end) { return Reduction::sum(x, begin, end); }, &Reduction::add);
+  }
+
+  /**
+   * Smallest and largest element of array Index (per component for elements
+   * that consist of floats, e.g. the bounds of positions). Without rows the
+   * result is (infinity or max, -infinity or lowest).
+   */
+  template<size_t Index, typename TArrays>
+  std::pair<detail::ElementType<Index, TArrays>, detail::ElementType<Index, TArrays>> minMax(const TArrays& arrays)
+  {
+    using Reduction = detail::Reduction<detail::ElementType<Index, TArrays>>;
+    return Reduction::minMax(arrays.template data<Index>(), 0, arrays.size());
+  }
+
+  template<size_t Index, typename TArrays>
+  std::pair<detail::ElementType<Index, TArrays>, detail::ElementType<Index, TArrays>> minMax(ThreadPool& pool, const TArrays& arrays, size_t grainSize)
+  {
+    using T = detail::ElementType<Index, TArrays>;
+    using Reduction = detail::Reduction<T>;
+
+    const T* x = arrays.template data<Index>();
+    return detail::reduceChunks(pool, arrays.size(), grainSize, Reduction::minMaxIdentity(),
+      [x](size_t begin, size_t end) { return Reduction::minMax(x, begin, end); }, &Reduction::combineMinMax);
+  }
+
+  /**
+   * Number of elements of array Index for which pred(x) is true, counted
+   * without branches.
+   */
+  template<size_t Index, typename TArrays, typename TPredicate>
+  size_t count(const TArrays& arrays, TPredicate pred)
+  {
+    return detail::countRange(arrays.template data<Index>(), 0, arrays.size(), pred);
+  }
+
+  template<size_t Index, typename TArrays, typename TPredicate>
+  size_t count(ThreadPool& pool, const TArrays& arrays, TPredicate pred, size_t grainSize)
+  {
+    const auto* x = arrays.template data<Index>();
+    return detail::reduceChunks(pool, arrays.size(), grainSize, (size_t)0,
+      [&](size_t begin, size_t end) { TPredicate p = pred; return detail::countRange(x, begin, end, p); },
+      [](size_t a, size_t b) { return a + b; });
+  }
+
+  /**
+   * counts[b] = number of elements x of array Index with binOf(x) == b, for
+   * the numBins bins [0, numBins) (see uniformBins).
+   */
+  template<size_t Index, typename TArrays, typename TBin>
+  void histogram(const TArrays& arrays, size_t numBins, TBin binOf, size_t* counts)
+  {
+    for (size_t b = 0; b < numBins; ++b)
+      counts[b] = 0;
+
+    detail::histogramRange(arrays.template data<Index>(), 0, arrays.size(), numBins, binOf, counts, nullptr);
+  }
+
+  template<size_t Index, typename TArrays, typename TBin>
+  void histogram(ThreadPool& pool, const TArrays& arrays, size_t numBins, TBin binOf, size_t* counts, size_t grainSize)
+  {
+    static const size_t chunkAlignment = 64;
+
+    for (size_t b = 0; b < numBins; ++b)
+      counts[b] = 0;
+
+    const auto* x = arrays.template data<Index>();
+    const size_t num = arrays.size();
+    const size_t chunkSize = grainSize > chunkAlignment ? ((grainSize + chunkAlignment - 1) / chunkAlignment) * chunkAlignment : chunkAlignment;
+    const size_t numChunks = (num + chunkSize - 1) / chunkSize;
+
+    //integer counts, the order in which the chunks are added does not matter
+    std::mutex mutex;
+    pool.parallelFor(numChunks, [&](size_t chunk)
+    {
+      const size_t begin = chunk * chunkSize;
+      const size_t end = begin + chunkSize < num ? begin + chunkSize : num;
+      TBin bin = binOf;
+      detail::histogramRange(x, begin, end, numBins, bin, counts, &mutex);
+    });
+  }
+
+  template<typename T>
+  UniformBins<T> uniformBins(T min, T max, size_t numBins)
+  {
+    assert(numBins > 0 && max > min && "invalid bins");
+
+    UniformBins<T> bins;
+    bins.min = min;
+    bins.scale = (double)numBins / (double)(max - min);
+    bins.numBins = numBins;
+    return bins;
+  }
+}
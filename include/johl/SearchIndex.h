@@ -0,0 +1,195 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <johl/detail/Bits.h>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace johl
+{
+  /**
+   * Read-optimized search index over a sorted array (e.g. timestamps), for
+   * point and range queries (see lowerBound and equalRange). The keys are
+   * copied in Eytzinger order (the implicit binary tree of a binary search,
+   * stored level by level: the children of node k are 2k and 2k + 1), so
+   * the first levels of every search share a few cache lines, and the nodes
+   * a few levels below the current node are adjacent and prefetched while
+   * the current level is compared. The search loop has no data dependent
+   * branches, only the depth of the tree.
+   * Each node also stores the row of its key, the results are rows of the
+   * indexed array. The index does not observe the array, rebuild it with
+   * build after the array has changed (O(n), no sort, no allocation if the
+   * capacity suffices, e.g. after bulk appends).
+   * Keys are compared with operator<. At most 2^32 - 1 keys are supported.
+   */
+  template<typename T>
+  class SearchIndex final
+  {
+  public:
+    explicit SearchIndex(Allocator* allocator = Allocator::defaultAllocator());
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+    void build(const T* keys, size_t n);
+
+    template<size_t Index, typename TArrays>
+    void build(const TArrays& arrays);
+
+    size_t lowerBound(const T& key) const;
+    size_t upperBound(const T& key) const;
+    std::pair<size_t, size_t> equalRange(const T& key) const;
+
+  private:
+    template<typename TLess>
+    size_t search(TLess less) const;
+
+    //node 0 is unused, nodes are cache line aligned
+    Arrays<aligned<T, 64>, std::uint32_t> m_nodes;
+  };
+
+  //============================================================================
+
+  namespace detail
+  {
+    constexpr size_t floorPowerOfTwo(size_t n)
+    {
+      return n < 2 ? 1 : 2 * floorPowerOfTwo(n / 2);
+    }
+  }
+
+  template<typename T>
+  SearchIndex<T>::SearchIndex(Allocator* allocator)
+    : m_nodes(allocator)
+  {
+  }
+
+  template<typename T>
+  size_t SearchIndex<T>::size() const
+  {
+    return m_nodes.size() > 0 ? m_nodes.size() - 1 : 0;
+  }
+
+  template<typename T>
+  bool SearchIndex<T>::empty() const
+  {
+    return size() == 0;
+  }
+
+  template<typename T>
+  void SearchIndex<T>::clear()
+  {
+    m_nodes.clear();
+  }
+
+  /**
+   * Rebuild the index from n keys in ascending order, keys[i] is the key of
+   * row i. The tree is filled in order (an in-order walk of the implicit
+   * tree, without recursion).
+   */
+  template<typename T>
+  void SearchIndex<T>::build(const T* keys, size_t n)
+  {
+    assert(n < 0xFFFFFFFF && "too many keys for a search index");
+    assert(std::is_sorted(keys, keys + n) && "keys are not sorted");
+
+    m_nodes.clear();
+    if (n == 0)
+      return;
+
+    m_nodes.reserve(n + 1);
+    for (size_t k = 0; k <= n; ++k)
+      m_nodes.append(T(), (std::uint32_t)0);
+
+    T* nodes = m_nodes.template data<0>();
+    std::uint32_t* rows = m_nodes.template data<1>();
+
+    //leftmost node
+    size_t k = 1;
+    while (2 * k <= n)
+      k *= 2;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      nodes[k] = keys[i];
+      rows[k] = (std::uint32_t)i;
+
+      if (2 * k + 1 <= n)
+      {
+        //leftmost node of the right subtree
+        k = 2 * k + 1;
+        while (2 * k <= n)
+          k *= 2;
+      }
+      else
+      {
+        //up to the first ancestor whose left subtree is done
+        while (k & 1)
+          k >>= 1;
+        k >>= 1;
+      }
+    }
+  }
+
+  template<typename T>
+  template<size_t Index, typename TArrays>
+  void SearchIndex<T>::build(const TArrays& arrays)
+  {
+    build(arrays.template data<Index>(), arrays.size());
+  }
+
+  /**
+   * First row whose key is not less than key, size() if there is none.
+   */
+  template<typename T>
+  size_t SearchIndex<T>::lowerBound(const T& key) const
+  {
+    return search([&key](const T& node) { return node < key; });
+  }
+
+  /**
+   * First row whose key is greater than key, size() if there is none.
+   */
+  template<typename T>
+  size_t SearchIndex<T>::upperBound(const T& key) const
+  {
+    return search([&key](const T& node) { return !(key < node); });
+  }
+
+  /**
+   * Rows [first, second) with a key equal to key.
+   */
+  template<typename T>
+  std::pair<size_t, size_t> SearchIndex<T>::equalRange(const T& key) const
+  {
+    return std::make_pair(lowerBound(key), upperBound(key));
+  }
+
+  /**
+   * Descends to a leaf, going right if less(node) (node k + 1 of each level
+   * is 2k + less(node)). The answer is the last node where the search went
+   * left: the trailing right turns (ones) and that left turn (a zero) are
+   * shifted out of k. The descendants prefetchNodes levels below k fill one
+   * cache line and are prefetched in every iteration.
+   */
+  template<typename T>
+  template<typename TLess>
+  size_t SearchIndex<T>::search(TLess less) const
+  {
+    static const size_t prefetchNodes = sizeof(T) < 64 ? detail::floorPowerOfTwo(64 / sizeof(T)) : 1;
+
+    const size_t n = size();
+    const T* nodes = m_nodes.template data<0>();
+
+    size_t k = 1;
+    while (k <= n)
+    {
+      detail::prefetch(nodes + k * prefetchNodes);
+      k = 2 * k + (less(nodes[k]) ? 1 : 0);
+    }
+
+    k >>= detail::bitarray::ctz(~(std::uint64_t)k) + 1;
+    return k == 0 ? n : m_nodes.template at<1>(k);
+  }
+}
@@ -0,0 +1,315 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <johl/Kernels.h>
+#include <cstdint>
+
+namespace johl
+{
+  /**
+   * Compact list of row indices in ascending order, e.g. the active rows of
+   * an Arrays object (see select). The selection is built once and can be
+   * reused by several passes over the selected rows (see FilteredView), so
+   * the cost of filtering is paid once instead of in every loop.
+   * Indices are 32 bit, selections of containers with more than 2^32 rows
+   * are not supported.
+   */
+  class Selection final
+  {
+  public:
+    explicit Selection(Allocator* allocator = Allocator::defaultAllocator());
+
+    size_t size() const;
+    bool empty() const;
+
+    const std::uint32_t* data() const;
+    std::uint32_t operator[](size_t i) const;
+
+    const std::uint32_t* begin() const;
+    const std::uint32_t* end() const;
+
+    void clear();
+    void reserve(size_t n);
+
+    void append(std::uint32_t row);
+    void appendRange(size_t n, const std::uint32_t* rows);
+
+  private:
+    Arrays<std::uint32_t> m_rows;
+  };
+
+  //select rows by a predicate on the elements of array Index
+  template<size_t Index, typename TArrays, typename TPredicate>
+  void select(const TArrays& arrays, TPredicate pred, Selection& selection);
+
+  template<size_t Index, typename TArrays, typename TPredicate>
+  Selection select(const TArrays& arrays, TPredicate pred);
+
+  //select the rows with a set flag in array Index (a bool array or a bit array)
+  template<size_t Index, typename TGrowth, typename... TArrays>
+  void select(const BasicArrays<TGrowth, TArrays...>& arrays, Selection& selection);
+
+  template<size_t Index, typename TGrowth, typename... TArrays>
+  Selection select(const BasicArrays<TGrowth, TArrays...>& arrays);
+
+  /**
+   * The selected rows of an Arrays object (or any container with
+   * data<Index>()). The container and the selection have to outlive the
+   * view, rows must not be added or removed while the view is used.
+   */
+  template<typename TArrays>
+  class FilteredView final
+  {
+  public:
+    FilteredView(TArrays& arrays, const Selection& selection);
+
+    size_t size() const;
+
+    //row of the container of the i-th selected row
+    size_t rowAt(size_t i) const;
+
+    template<size_t... Indices, typename TFunction>
+    void forEach(TFunction fn) const;
+
+  private:
+    TArrays* m_arrays;
+    const Selection* m_selection;
+  };
+
+  template<typename TArrays>
+  FilteredView<TArrays> filter(TArrays& arrays, const Selection& selection);
+
+  //============================================================================
+
+  namespace detail
+  {
+    //rows per block, the indices of a block are collected on the stack
+    static const size_t selectBlockRows = 1024;
+
+    template<typename TRows>
+    size_t selectRows(const TRows& rows, size_t begin, size_t end, std::uint32_t* out)
+    {
+      using namespace johl::detail::kernels;
+
+      switch (johl::kernels::simdLevel())
+      {
+#if JOHL_KERNELS_X86
+      case johl::kernels::SimdLevel::AVX512:
+        return selectAvx512(rows, begin, end, out);
+      case johl::kernels::SimdLevel::AVX2:
+        return selectAvx2(rows, begin, end, out);
+      case johl::kernels::SimdLevel::SSE2:
+        return selectSse(rows, begin, end, out);
+#endif
+      default:
+        return selectScalar(rows, begin, end, out);
+      }
+    }
+
+    inline johl::detail::kernels::BoolRows maskRows(const bool* flags)
+    {
+      const johl::detail::kernels::BoolRows rows = { flags };
+      return rows;
+    }
+
+    inline johl::detail::kernels::BitRows maskRows(const std::uint64_t* words)
+    {
+      const johl::detail::kernels::BitRows rows = { words };
+      return rows;
+    }
+
+    //visits the selected rows, the elements of the row prefetchDistance
+    //iterations ahead are prefetched
+    template<typename TFunction, typename... TPointers>
+    void forEachSelected(const std::uint32_t* rows, size_t num, TFunction& fn, TPointers... arrays)
+    {
+      static const size_t prefetchDistance = 16;
+
+      size_t i = 0;
+      for (; i + prefetchDistance < num; ++i)
+      {
+        const size_t ahead = rows[i + prefetchDistance];
+        const int prefetched[] = { prefetch(arrays + ahead)... };
+        unused(prefetched);
+
+        const size_t row = rows[i];
+        fn(arrays[row]...);
+      }
+
+      for (; i < num; ++i)
+      {
+        const size_t row = rows[i];
+        fn(arrays[row]...);
+      }
+    }
+  }
+
+  inline Selection::Selection(Allocator* allocator)
+    : m_rows(allocator)
+  {
+  }
+
+  inline size_t Selection::size() const
+  {
+    return m_rows.size();
+  }
+
+  inline bool Selection::empty() const
+  {
+    return m_rows.size() == 0;
+  }
+
+  inline const std::uint32_t* Selection::data() const
+  {
+    return m_rows.data<0>();
+  }
+
+  inline std::uint32_t Selection::operator[](size_t i) const
+  {
+    return m_rows.at<0>(i);
+  }
+
+  inline const std::uint32_t* Selection::begin() const
+  {
+    return m_rows.data<0>();
+  }
+
+  inline const std::uint32_t* Selection::end() const
+  {
+    return m_rows.data<0>() + m_rows.size();
+  }
+
+  inline void Selection::clear()
+  {
+    m_rows.clear();
+  }
+
+  inline void Selection::reserve(size_t n)
+  {
+    m_rows.reserve(n);
+  }
+
+  inline void Selection::append(std::uint32_t row)
+  {
+    m_rows.append(row);
+  }
+
+  inline void Selection::appendRange(size_t n, const std::uint32_t* rows)
+  {
+    m_rows.appendRange(n, rows);
+  }
+
+  /**
+   * Replaces the rows of selection with the rows i for which
+   * pred(arrays.data<Index>()[i]) is true. The predicate is evaluated for
+   * every row, the index of each row is written unconditionally and the
+   * count only advances for selected rows, so there is no branch that
+   * mispredicts at low or random selection ratios.
+   */
+  template<size_t Index, typename TArrays, typename TPredicate>
+  void select(const TArrays& arrays, TPredicate pred, Selection& selection)
+  {
+    const size_t num = arrays.size();
+    assert(num <= 0xFFFFFFFF && "too many rows for a selection");
+
+    static_assert(!detail::IsBitArrayOf<Index, TArrays>::value, "select with a predicate requires an array of elements, use select without a predicate for bit arrays");
+
+    const auto* values = arrays.template data<Index>();
+    std::uint32_t rows[detail::selectBlockRows + 1];
+
+    selection.clear();
+    for (size_t begin = 0; begin < num; begin += detail::selectBlockRows)
+    {
+      const size_t end = begin + detail::selectBlockRows < num ? begin + detail::selectBlockRows : num;
+
+      size_t n = 0;
+      for (size_t i = begin; i < end; ++i)
+      {
+        rows[n] = (std::uint32_t)i;
+        n += pred(values[i]) ? 1 : 0;
+      }
+
+      selection.appendRange(n, rows);
+    }
+  }
+
+  template<size_t Index, typename TArrays, typename TPredicate>
+  Selection select(const TArrays& arrays, TPredicate pred)
+  {
+    Selection selection;
+    select<Index>(arrays, pred, selection);
+    return selection;
+  }
+
+  /**
+   * Replaces the rows of selection with the rows that have a set flag in
+   * array Index. The flags are read 64 rows at a time as a bit mask and
+   * compacted with simd instructions (compress on AVX-512, a table of lane
+   * indices on AVX2 and SSE2), 64 rows without a set flag are skipped.
+   */
+  template<size_t Index, typename TGrowth, typename... TArrays>
+  void select(const BasicArrays<TGrowth, TArrays...>& arrays, Selection& selection)
+  {
+    using Flags = typename std::remove_pointer<decltype(arrays.template data<Index>())>::type;
+    static_assert(BasicArrays<TGrowth, TArrays...>::template IsBitArray<Index>::value || std::is_same<Flags, const bool>::value,
+      "select without a predicate requires a bool array or a bit array");
+
+    const size_t num = arrays.size();
+    assert(num <= 0xFFFFFFFF && "too many rows for a selection");
+
+    const auto rows = detail::maskRows(arrays.template data<Index>());
+    std::uint32_t indices[detail::selectBlockRows + johl::detail::kernels::selectPadding];
+
+    selection.clear();
+    for (size_t begin = 0; begin < num; begin += detail::selectBlockRows)
+    {
+      const size_t end = begin + detail::selectBlockRows < num ? begin + detail::selectBlockRows : num;
+      selection.appendRange(detail::selectRows(rows, begin, end, indices), indices);
+    }
+  }
+
+  template<size_t Index, typename TGrowth, typename... TArrays>
+  Selection select(const BasicArrays<TGrowth, TArrays...>& arrays)
+  {
+    Selection selection;
+    select<Index>(arrays, selection);
+    return selection;
+  }
+
+  template<typename TArrays>
+  FilteredView<TArrays>::FilteredView(TArrays& arrays, const Selection& selection)
+    : m_arrays(&arrays)
+    , m_selection(&selection)
+  {
+  }
+
+  template<typename TArrays>
+  size_t FilteredView<TArrays>::size() const
+  {
+    return m_selection->size();
+  }
+
+  template<typename TArrays>
+  size_t FilteredView<TArrays>::rowAt(size_t i) const
+  {
+    return (*m_selection)[i];
+  }
+
+  /**
+   * Calls fn(data<Indices>()[row]...) for each selected row, in ascending
+   * order of the rows. The elements of the rows a few iterations ahead are
+   * prefetched, so the gathers from scattered rows overlap their cache
+   * misses. Not for bit arrays.
+   */
+  template<typename TArrays>
+  template<size_t... Indices, typename TFunction>
+  void FilteredView<TArrays>::forEach(TFunction fn) const
+  {
+    detail::forEachSelected(m_selection->data(), m_selection->size(), fn, m_arrays->template data<Indices>()...);
+  }
+
+  template<typename TArrays>
+  FilteredView<TArrays> filter(TArrays& arrays, const Selection& selection)
+  {
+    return FilteredView<TArrays>(arrays, selection);
+  }
+}
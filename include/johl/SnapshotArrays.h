@@ -0,0 +1,556 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace johl
+{
+  namespace detail
+  {
+    template<typename TGrowth, typename... TArrays>
+    class SharedColumns;
+  }
+
+  /**
+   * Read-only snapshot of a SnapshotArrays object (see
+   * SnapshotArrays::snapshot). A snapshot shares the storage of the arrays
+   * with the container and with other snapshots, it never changes. The
+   * snapshot can be read and destroyed on any thread, without any locks.
+   */
+  template<typename TGrowth, typename... TArrays>
+  class ArraysSnapshot final
+  {
+  private:
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+    using Columns = detail::SharedColumns<TGrowth, TArrays...>;
+
+  public:
+    ArraysSnapshot() = default;
+    explicit ArraysSnapshot(const Columns& columns);
+
+    size_t size() const;
+    bool empty() const;
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+  private:
+    Columns m_columns;
+  };
+
+  /**
+   * Arrays with O(1) copy-on-write snapshots, for threads that read the
+   * arrays while another thread changes them (e.g. rendering while the
+   * simulation runs). Each array is stored in its own block with a
+   * reference count, a snapshot only increments the reference counts. The
+   * first write to a shared array copies that array (not the other arrays),
+   * later writes go to the copy. Structural changes (append, removeAt, ...)
+   * write to all arrays.
+   * Readers never block the writer: snapshots are immutable, the reference
+   * counts are atomic, the last owner of a block (container or snapshot)
+   * frees it. The container itself is not thread-safe, take snapshots on
+   * the thread that changes it and pass them to the readers.
+   * Copies of the container share all arrays like snapshots.
+   */
+  template<typename TGrowth, typename... TArrays>
+  class BasicSnapshotArrays final
+  {
+  private:
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+    using Columns = detail::SharedColumns<TGrowth, TArrays...>;
+    using Indices = typename detail::MakeIndexSequence<sizeof...(TArrays)>::Type;
+
+  public:
+    using GrowthPolicy = TGrowth;
+    using Snapshot = ArraysSnapshot<TGrowth, TArrays...>;
+
+    explicit BasicSnapshotArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    Snapshot snapshot() const;
+
+    template<size_t Index>
+    bool isShared() const;
+
+    size_t size() const;
+    void clear();
+    void reserve(size_t n);
+
+    template<typename... TArgs>
+    void append(TArgs&&... args);
+
+    template<typename... TArgs>
+    void insertAt(size_t index, TArgs&&... args);
+
+    void removeAt(size_t index);
+    void removeAtUnordered(size_t index);
+    void swapAt(size_t a, size_t b);
+
+    template<size_t Index>
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    ArrayRef<Type<Index>> array();
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    Type<Index>* data();
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+  private:
+    template<size_t Index>
+    BasicArrays<TGrowth, typename detail::Get<Index, TArrays...>::Type>& writable();
+
+    template<size_t... Is, typename... TArgs>
+    void insertAt(detail::IndexSequence<Is...>, size_t index, TArgs&&... args);
+
+    template<size_t... Is, typename TFunction>
+    void forEachColumn(detail::IndexSequence<Is...>, TFunction fn);
+
+    Allocator* m_allocator;
+    Columns m_columns;
+  };
+
+  /**
+   * SnapshotArrays with the default growth policy.
+   */
+  template<typename... TArrays>
+  using SnapshotArrays = BasicSnapshotArrays<geometric_growth<>, TArrays...>;
+
+  //============================================================================
+
+  namespace detail
+  {
+    /**
+     * One array (an Arrays object with one array) in its own block, with a
+     * reference count. Blocks are created with a count of one.
+     */
+    template<typename TColumn>
+    class SharedColumn final
+    {
+    public:
+      static SharedColumn* create(Allocator* allocator)
+      {
+        return new (allocateBlock(allocator)) SharedColumn(allocator);
+      }
+
+      //deep copy, uses the allocator of other
+      static SharedColumn* copy(const SharedColumn& other)
+      {
+        void* block = allocateBlock(other.m_allocator);
+        try
+        {
+          return new (block) SharedColumn(other);
+        }
+        catch (...)
+        {
+          other.m_allocator->deallocate(block);
+          throw;
+        }
+      }
+
+      static void release(SharedColumn* column)
+      {
+        if (column && column->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          Allocator* allocator = column->m_allocator;
+          column->~SharedColumn();
+          allocator->deallocate(column);
+        }
+      }
+
+      void acquire()
+      {
+        m_refs.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      //only the owner can add references, a count of one stays one
+      bool isShared() const
+      {
+        return m_refs.load(std::memory_order_acquire) != 1;
+      }
+
+      TColumn arrays;
+
+    private:
+      static void* allocateBlock(Allocator* allocator)
+      {
+        void* block = allocator->allocate(sizeof(SharedColumn));
+        if (!block)
+          throw std::bad_alloc();
+
+        return block;
+      }
+
+      explicit SharedColumn(Allocator* allocator)
+        : arrays(allocator)
+        , m_refs(1)
+        , m_allocator(allocator)
+      {
+      }
+
+      SharedColumn(const SharedColumn& other)
+        : arrays(other.arrays)
+        , m_refs(1)
+        , m_allocator(other.m_allocator)
+      {
+      }
+
+      std::atomic<size_t> m_refs;
+      Allocator* m_allocator;
+    };
+
+    /**
+     * References to the blocks of the arrays of a SnapshotArrays object or
+     * snapshot (null for arrays without a block). Copies add references.
+     */
+    template<typename TGrowth, typename... TArrays>
+    class SharedColumns final
+    {
+    private:
+      static const size_t numArrays = sizeof...(TArrays);
+      static_assert(numArrays > 0, "SnapshotArrays needs at least one array");
+
+    public:
+      template<size_t Index>
+      using Column = SharedColumn<BasicArrays<TGrowth, typename Get<Index, TArrays...>::Type>>;
+
+      SharedColumns()
+      {
+        std::fill(m_columns, m_columns + numArrays, nullptr);
+      }
+
+      SharedColumns(const SharedColumns& other)
+      {
+        std::copy(other.m_columns, other.m_columns + numArrays, m_columns);
+        acquire(typename MakeIndexSequence<numArrays>::Type());
+      }
+
+      SharedColumns(SharedColumns&& other) noexcept
+      {
+        std::copy(other.m_columns, other.m_columns + numArrays, m_columns);
+        std::fill(other.m_columns, other.m_columns + numArrays, nullptr);
+      }
+
+      SharedColumns& operator=(SharedColumns other) noexcept
+      {
+        swap(other);
+        return *this;
+      }
+
+      ~SharedColumns()
+      {
+        release(typename MakeIndexSequence<numArrays>::Type());
+      }
+
+      void swap(SharedColumns& other) noexcept
+      {
+        std::swap_ranges(m_columns, m_columns + numArrays, other.m_columns);
+      }
+
+      size_t size() const
+      {
+        return m_columns[0] ? get<0>()->arrays.size() : 0;
+      }
+
+      template<size_t Index>
+      Column<Index>* get() const
+      {
+        return static_cast<Column<Index>*>(m_columns[Index]);
+      }
+
+      template<size_t Index>
+      void set(Column<Index>* column)
+      {
+        m_columns[Index] = column;
+      }
+
+    private:
+      template<size_t... Is>
+      void acquire(IndexSequence<Is...>)
+      {
+        const int acquired[] = { (get<Is>() ? get<Is>()->acquire() : void(), 0)... };
+        unused(acquired);
+      }
+
+      template<size_t... Is>
+      void release(IndexSequence<Is...>)
+      {
+        const int released[] = { (Column<Is>::release(get<Is>()), 0)... };
+        unused(released);
+      }
+
+      void* m_columns[numArrays];
+    };
+
+    //operations on each array of a SnapshotArrays object
+    struct ReserveColumn final
+    {
+      size_t n;
+
+      template<typename TColumn>
+      void operator()(TColumn& column) const { column.reserve(n); }
+    };
+
+    struct RemoveFromColumn final
+    {
+      size_t index;
+
+      template<typename TColumn>
+      void operator()(TColumn& column) const { column.removeAt(index); }
+    };
+
+    struct RemoveUnorderedFromColumn final
+    {
+      size_t index;
+
+      template<typename TColumn>
+      void operator()(TColumn& column) const { column.removeAtUnordered(index); }
+    };
+
+    struct SwapInColumn final
+    {
+      size_t a;
+      size_t b;
+
+      template<typename TColumn>
+      void operator()(TColumn& column) const { column.swapAt(a, b); }
+    };
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  ArraysSnapshot<TGrowth, TArrays...>::ArraysSnapshot(const Columns& columns)
+    : m_columns(columns)
+  {
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t ArraysSnapshot<TGrowth, TArrays...>::size() const
+  {
+    return m_columns.size();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  bool ArraysSnapshot<TGrowth, TArrays...>::empty() const
+  {
+    return m_columns.size() == 0;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto ArraysSnapshot<TGrowth, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    assert(i < size() && "index out of range");
+    return m_columns.template get<Index>()->arrays.template at<0>(i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto ArraysSnapshot<TGrowth, TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    return ArrayRef<const Type<Index>>(data<Index>(), size());
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto ArraysSnapshot<TGrowth, TArrays...>::data() const -> const Type<Index>*
+  {
+    const auto* column = m_columns.template get<Index>();
+    return column ? column->arrays.template data<0>() : nullptr;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  BasicSnapshotArrays<TGrowth, TArrays...>::BasicSnapshotArrays(Allocator* allocator)
+    : m_allocator(allocator)
+  {
+  }
+
+  /**
+   * O(number of arrays), shares all arrays.
+   */
+  template<typename TGrowth, typename... TArrays>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::snapshot() const -> Snapshot
+  {
+    return Snapshot(m_columns);
+  }
+
+  /**
+   * true if array Index is shared with a snapshot (or a copy), the next
+   * write to the array copies it.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  bool BasicSnapshotArrays<TGrowth, TArrays...>::isShared() const
+  {
+    const auto* column = m_columns.template get<Index>();
+    return column && column->isShared();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  size_t BasicSnapshotArrays<TGrowth, TArrays...>::size() const
+  {
+    return m_columns.size();
+  }
+
+  /**
+   * Shared arrays are released instead of copied.
+   */
+  template<typename TGrowth, typename... TArrays>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::clear()
+  {
+    Columns empty;
+    m_columns.swap(empty);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::reserve(size_t n)
+  {
+    forEachColumn(Indices(), detail::ReserveColumn{ n });
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TArgs>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::append(TArgs&&... args)
+  {
+    insertAt(Indices(), size(), std::forward<TArgs>(args)...);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<typename... TArgs>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::insertAt(size_t index, TArgs&&... args)
+  {
+    insertAt(Indices(), index, std::forward<TArgs>(args)...);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Is, typename... TArgs>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::insertAt(detail::IndexSequence<Is...>, size_t index, TArgs&&... args)
+  {
+    static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
+    assert(index <= size() && "index out of range");
+
+    const int inserted[] = { (writable<Is>().emplaceAt(index, std::forward<TArgs>(args)), 0)... };
+    detail::unused(inserted);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::removeAt(size_t index)
+  {
+    forEachColumn(Indices(), detail::RemoveFromColumn{ index });
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::removeAtUnordered(size_t index)
+  {
+    forEachColumn(Indices(), detail::RemoveUnorderedFromColumn{ index });
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::swapAt(size_t a, size_t b)
+  {
+    forEachColumn(Indices(), detail::SwapInColumn{ a, b });
+  }
+
+  /**
+   * Element i of array Index for writing, copies the array if it is shared.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::at(size_t i) -> Type<Index>&
+  {
+    assert(i < size() && "index out of range");
+    return writable<Index>().template at<0>(i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    assert(i < size() && "index out of range");
+    return m_columns.template get<Index>()->arrays.template at<0>(i);
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::array() -> ArrayRef<Type<Index>>
+  {
+    return ArrayRef<Type<Index>>(data<Index>(), size());
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    return ArrayRef<const Type<Index>>(data<Index>(), size());
+  }
+
+  /**
+   * Array Index for writing, copies the array if it is shared.
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::data() -> Type<Index>*
+  {
+    return writable<Index>().template data<0>();
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::data() const -> const Type<Index>*
+  {
+    const auto* column = m_columns.template get<Index>();
+    return column ? column->arrays.template data<0>() : nullptr;
+  }
+
+  /**
+   * Array Index, copied first if it is shared (the copy replaces the
+   * reference of this container, the snapshots keep the old block).
+   */
+  template<typename TGrowth, typename... TArrays>
+  template<size_t Index>
+  auto BasicSnapshotArrays<TGrowth, TArrays...>::writable() -> BasicArrays<TGrowth, typename detail::Get<Index, TArrays...>::Type>&
+  {
+    using Column = typename Columns::template Column<Index>;
+
+    Column* column = m_columns.template get<Index>();
+    if (!column)
+    {
+      column = Column::create(m_allocator);
+      m_columns.template set<Index>(column);
+    }
+    else if (column->isShared())
+    {
+      Column* copy = Column::copy(*column);
+      Column::release(column);
+      column = copy;
+      m_columns.template set<Index>(column);
+    }
+
+    return column->arrays;
+  }
+
+  template<typename TGrowth, typename... TArrays>
+  template<size_t... Is, typename TFunction>
+  void BasicSnapshotArrays<TGrowth, TArrays...>::forEachColumn(detail::IndexSequence<Is...>, TFunction fn)
+  {
+    const int visited[] = { (fn(writable<Is>()), 0)... };
+    detail::unused(visited);
+  }
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace johl
+{
+  /**
+   * Minimal work-stealing thread pool for data parallel loops.
+   *
+   * parallelFor(num, f) calls f(i) exactly once for each i in [0, num) and
+   * blocks until all calls returned. The task indices are split into one
+   * contiguous range per thread. A thread takes tasks from the front of its
+   * own range and, once that is exhausted, steals the back half of the
+   * largest remaining range of another thread.
+   * The calling thread participates, so a pool with numThreads == 1 does not
+   * start any worker threads.
+   * Calls from inside a task (nested parallelFor) are executed sequentially by
+   * the calling thread. Tasks must not throw.
+   */
+  class ThreadPool final
+  {
+  public:
+    explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    size_t size() const;
+
+    template<typename TFunction>
+    void parallelFor(size_t num, TFunction f);
+
+    static ThreadPool& defaultPool();
+
+  private:
+    //range of task indices owned by one thread, padded to keep the slots of
+    //different threads in different cache lines
+    struct Slot
+    {
+      std::mutex mutex;
+      size_t begin;
+      size_t end;
+      char padding[64];
+    };
+
+    struct Job
+    {
+      void (*run)(void* context, size_t index);
+      void* context;
+    };
+
+    template<typename TFunction>
+    static void runTask(void* context, size_t index);
+
+    static bool& insideTask();
+
+    void workerMain(size_t slot);
+    void participate(const Job& job, size_t slot);
+    bool takeTask(size_t slot, size_t& index);
+    bool stealTasks(size_t slot);
+
+    size_t m_numThreads;
+    std::unique_ptr<Slot[]> m_slots;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_submitMutex; //serializes parallelFor calls from different threads
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Job* m_job;
+    size_t m_generation;
+    size_t m_busy;
+    bool m_stop;
+  };
+
+  //============================================================================
+
+  inline ThreadPool::ThreadPool(size_t numThreads)
+    : m_numThreads(numThreads > 0 ? numThreads : 1)
+    , m_slots(new Slot[m_numThreads])
+    , m_workers()
+    , m_job(nullptr)
+    , m_generation(0)
+    , m_busy(0)
+    , m_stop(false)
+  {
+    for (size_t i = 0; i < m_numThreads; ++i)
+    {
+      m_slots[i].begin = 0;
+      m_slots[i].end = 0;
+    }
+
+    //slot 0 belongs to the calling thread
+    for (size_t i = 1; i < m_numThreads; ++i)
+      m_workers.emplace_back(&ThreadPool::workerMain, this, i);
+  }
+
+  inline ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+
+  inline size_t ThreadPool::size() const
+  {
+    return m_numThreads;
+  }
+
+  inline ThreadPool& ThreadPool::defaultPool()
+  {
+    static ThreadPool pool; //threadsafe since C+11, thanks to 'magic statics'
+    return pool;
+  }
+
+  inline bool& ThreadPool::insideTask()
+  {
+    static thread_local bool inside = false;
+    return inside;
+  }
+
+  template<typename TFunction>
+  void ThreadPool::runTask(void* context, size_t index)
+  {
+    (*static_cast<TFunction*>(context))(index);
+  }
+
+  template<typename TFunction>
+  void ThreadPool::parallelFor(size_t num, TFunction f)
+  {
+    if (num == 0)
+      return;
+
+    if (m_numThreads == 1 || num == 1 || insideTask())
+    {
+      for (size_t i = 0; i < num; ++i)
+        f(i);
+      return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+    //split tasks evenly, the first (num % m_numThreads) slots get one more
+    const size_t perSlot = num / m_numThreads;
+    const size_t remainder = num % m_numThreads;
+    size_t begin = 0;
+    for (size_t i = 0; i < m_numThreads; ++i)
+    {
+      const size_t count = perSlot + (i < remainder ? 1 : 0);
+      std::lock_guard<std::mutex> lock(m_slots[i].mutex);
+      m_slots[i].begin = begin;
+      m_slots[i].end = begin + count;
+      begin += count;
+    }
+
+    const Job job = { &runTask<TFunction>, &f };
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_job = &job;
+      m_busy = m_workers.size();
+      ++m_generation;
+    }
+    m_wake.notify_all();
+
+    participate(job, 0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+  }
+
+  inline void ThreadPool::workerMain(size_t slot)
+  {
+    size_t generation = 0;
+
+    for (;;)
+    {
+      const Job* job = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+        if (m_stop)
+          return;
+
+        generation = m_generation;
+        job = m_job;
+      }
+
+      participate(*job, slot);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (--m_busy == 0)
+        m_done.notify_all();
+    }
+  }
+
+  inline void ThreadPool::participate(const Job& job, size_t slot)
+  {
+    insideTask() = true;
+
+    size_t index;
+    for (;;)
+    {
+      while (takeTask(slot, index))
+        job.run(job.context, index);
+
+      if (!stealTasks(slot))
+        break;
+    }
+
+    insideTask() = false;
+  }
+
+  inline bool ThreadPool::takeTask(size_t slot, size_t& index)
+  {
+    Slot& s = m_slots[slot];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.begin == s.end)
+      return false;
+
+    index = s.begin++;
+    return true;
+  }
+
+  //moves the back half of the largest remaining range into our own slot.
+  //returns false if there is nothing left to steal.
+  inline bool ThreadPool::stealTasks(size_t slot)
+  {
+    for (;;)
+    {
+      size_t victim = slot;
+      size_t largest = 0;
+      for (size_t i = 0; i < m_numThreads; ++i)
+      {
+        if (i == slot)
+          continue;
+
+        std::lock_guard<std::mutex> lock(m_slots[i].mutex);
+        const size_t remaining = m_slots[i].end - m_slots[i].begin;
+        if (remaining > largest)
+        {
+          largest = remaining;
+          victim = i;
+        }
+      }
+
+      if (victim == slot)
+        return false;
+
+      size_t begin;
+      size_t end;
+      {
+        Slot& v = m_slots[victim];
+        std::lock_guard<std::mutex> lock(v.mutex);
+        const size_t remaining = v.end - v.begin;
+        if (remaining == 0)
+          continue; //victim finished its range in the meantime, try again
+
+        end = v.end;
+        begin = v.end - (remaining + 1) / 2;
+        v.end = begin;
+      }
+
+      Slot& s = m_slots[slot];
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.begin = begin;
+      s.end = end;
+      return true;
+    }
+  }
+}
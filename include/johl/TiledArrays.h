@@ -0,0 +1,514 @@
+#pragma once
+#include <johl/Arrays.h>
+
+namespace johl
+{
+  namespace detail
+  {
+    //offsets of the arrays in a tile of TRows rows (see ChunkOffsets)
+    template<typename TLayout, size_t TRows, typename TSequence>
+    struct TileOffsets;
+
+    template<typename TLayout, size_t TRows, size_t... Indices>
+    struct TileOffsets<TLayout, TRows, IndexSequence<Indices...>> final
+    {
+      TileOffsets() = delete;
+      static constexpr size_t values[] = { TLayout::offset(Indices, TRows)... };
+
+      //tiles are placed back to back, every tile starts at maxAlignment
+      static constexpr size_t stride = alignUp(TLayout::bytes(TRows), TLayout::maxAlignment);
+    };
+
+    template<typename TLayout, size_t TRows, size_t... Indices>
+    constexpr size_t TileOffsets<TLayout, TRows, IndexSequence<Indices...>>::values[];
+  }
+
+  /**
+   * 'array-of-structs-of-arrays' container: rows are grouped into tiles of
+   * TTileRows rows, a tile stores TTileRows elements of each array (in the
+   * order of ArraysLayout). All tiles share one block of memory.
+   * The arrays of one row are at most one tile apart instead of a whole
+   * array (SoA), while a loop over one array still reads TTileRows
+   * consecutive elements (e.g. one SIMD register with TTileRows = 4, 8 or 16
+   * floats).
+   * The address of a row does not depend on the capacity, containers of
+   * trivially relocatable arrays grow with Allocator::reallocate.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  class BasicTiledArrays final
+  {
+  private:
+    static_assert(detail::is_power_of_two<TTileRows>::value, "TTileRows must be power two");
+    static_assert(ArraysLayout<TArrays...>::bitsPerRow == ArraysLayout<TArrays...>::bytesPerRow * 8, "bit arrays are only supported by BasicArrays");
+
+    using ForEachArray = detail::arrays::ForEach<sizeof...(TArrays), 0, TArrays...>;
+
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+  public:
+    using GrowthPolicy = TGrowth;
+    using Layout = ArraysLayout<TArrays...>;
+
+  private:
+    using Offsets = detail::TileOffsets<Layout, TTileRows, typename detail::MakeIndexSequence<sizeof...(TArrays)>::Type>;
+
+  public:
+    static const size_t tileRows = TTileRows;
+    static constexpr size_t tileBytes = Offsets::stride;
+
+    /**
+     * The arrays of one tile, data<Index>()[0..size()).
+     */
+    class Tile
+    {
+    public:
+      Tile(char* data, size_t size) : m_data(data), m_size(size) {}
+
+      size_t size() const { return m_size; }
+
+      template<size_t Index>
+      Type<Index>* data() const
+      {
+        return reinterpret_cast<Type<Index>*>(m_data + Offsets::values[Index]);
+      }
+
+    private:
+      char* m_data;
+      size_t m_size;
+    };
+
+    class TileIterator
+    {
+    public:
+      TileIterator(char* data, size_t tile, size_t numRows) : m_data(data), m_tile(tile), m_numRows(numRows) {}
+
+      Tile operator*() const
+      {
+        const size_t begin = m_tile * TTileRows;
+        return Tile(m_data + m_tile * tileBytes, m_numRows - begin < TTileRows ? m_numRows - begin : TTileRows);
+      }
+
+      TileIterator& operator++() { ++m_tile; return *this; }
+      bool operator==(const TileIterator& other) const { return m_tile == other.m_tile; }
+      bool operator!=(const TileIterator& other) const { return m_tile != other.m_tile; }
+
+    private:
+      char* m_data;
+      size_t m_tile;
+      size_t m_numRows;
+    };
+
+    struct TileRange
+    {
+      TileIterator first;
+      TileIterator last;
+
+      TileIterator begin() const { return first; }
+      TileIterator end() const { return last; }
+    };
+
+    explicit BasicTiledArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    BasicTiledArrays(const BasicTiledArrays& other);
+    BasicTiledArrays& operator=(const BasicTiledArrays& other);
+
+    BasicTiledArrays(BasicTiledArrays&& other) noexcept;
+    BasicTiledArrays& operator=(BasicTiledArrays&& other) noexcept;
+
+    ~BasicTiledArrays();
+
+    void swap(BasicTiledArrays& other) noexcept;
+
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+    void reserve(size_t n);
+
+    size_t numTiles() const;
+    Tile tile(size_t t);
+    TileRange tiles();
+
+    template<size_t Index>
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<typename... TArgs>
+    void append(TArgs... args);
+
+    template<typename... TArgs>
+    auto emplaceBack(TArgs&&... args)
+      -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type;
+
+    void removeLast();
+    void removeAtUnordered(size_t index);
+
+    template<size_t... Indices, typename TFunction>
+    void forEachTile(TFunction fn);
+
+  private:
+    void grow(size_t required);
+    void tileArrays(size_t t, void** arrays) const;
+    void destructAll();
+
+    size_t m_numUsed;
+    size_t m_numTiles;
+    Allocator* m_allocator;
+    char* m_data;
+  };
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void swap(BasicTiledArrays<TGrowth, TTileRows, TArrays...>& a, BasicTiledArrays<TGrowth, TTileRows, TArrays...>& b) noexcept;
+
+  /**
+   * TiledArrays with the default growth policy.
+   */
+  template<size_t TTileRows, typename... TArrays>
+  using TiledArrays = BasicTiledArrays<geometric_growth<>, TTileRows, TArrays...>;
+
+  //============================================================================
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  constexpr size_t BasicTiledArrays<TGrowth, TTileRows, TArrays...>::tileBytes;
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  BasicTiledArrays<TGrowth, TTileRows, TArrays...>::BasicTiledArrays(Allocator* allocator)
+    : m_numUsed(0)
+    , m_numTiles(0)
+    , m_allocator(allocator)
+    , m_data(nullptr)
+  {
+    assert(m_allocator && "allocator must not be null");
+  }
+
+  /**
+   * Deep copy, uses the same allocator as other.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  BasicTiledArrays<TGrowth, TTileRows, TArrays...>::BasicTiledArrays(const BasicTiledArrays& other)
+    : BasicTiledArrays(other.m_allocator)
+  {
+    *this = other;
+  }
+
+  /**
+   * Deep copy, keeps the allocator of this object. If all arrays are 
+   * trivially copyable, all tiles are copied with one memcpy.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::operator=(const BasicTiledArrays& other) -> BasicTiledArrays&
+  {
+    if (this == &other)
+      return *this;
+
+    clear();
+    reserve(other.m_numUsed);
+
+    const size_t num = other.numTiles();
+    if (detail::IsTriviallyRelocatable<TArrays...>::value)
+    {
+      if (num > 0)
+        memcpy(m_data, other.m_data, num * tileBytes);
+
+      m_numUsed = other.m_numUsed;
+      return *this;
+    }
+
+    for (size_t t = 0; t < num; ++t)
+    {
+      void* src[sizeof...(TArrays)];
+      void* dst[sizeof...(TArrays)];
+      other.tileArrays(t, src);
+      tileArrays(t, dst);
+      ForEachArray::copyArrays(src, dst, other.m_numUsed - t * TTileRows < TTileRows ? other.m_numUsed - t * TTileRows : TTileRows);
+    }
+
+    m_numUsed = other.m_numUsed;
+    return *this;
+  }
+
+  /**
+   * Takes over the memory (and the allocator) of other in O(1), see
+   * BasicArrays(BasicArrays&&).
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  BasicTiledArrays<TGrowth, TTileRows, TArrays...>::BasicTiledArrays(BasicTiledArrays&& other) noexcept
+    : m_numUsed(other.m_numUsed)
+    , m_numTiles(other.m_numTiles)
+    , m_allocator(other.m_allocator)
+    , m_data(other.m_data)
+  {
+    other.m_numUsed = 0;
+    other.m_numTiles = 0;
+    other.m_data = nullptr;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::operator=(BasicTiledArrays&& other) noexcept -> BasicTiledArrays&
+  {
+    if (this != &other)
+    {
+      BasicTiledArrays tmp(std::move(other));
+      swap(tmp);
+    }
+
+    return *this;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  BasicTiledArrays<TGrowth, TTileRows, TArrays...>::~BasicTiledArrays()
+  {
+    destructAll();
+
+    if (m_data)
+      m_allocator->deallocateSized(m_data, m_numTiles * tileBytes, Layout::maxAlignment);
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::swap(BasicTiledArrays& other) noexcept
+  {
+    std::swap(m_numUsed, other.m_numUsed);
+    std::swap(m_numTiles, other.m_numTiles);
+    std::swap(m_allocator, other.m_allocator);
+    std::swap(m_data, other.m_data);
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void swap(BasicTiledArrays<TGrowth, TTileRows, TArrays...>& a, BasicTiledArrays<TGrowth, TTileRows, TArrays...>& b) noexcept
+  {
+    a.swap(b);
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  size_t BasicTiledArrays<TGrowth, TTileRows, TArrays...>::size() const
+  {
+    return m_numUsed;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  size_t BasicTiledArrays<TGrowth, TTileRows, TArrays...>::capacity() const
+  {
+    return m_numTiles * TTileRows;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::clear()
+  {
+    destructAll();
+    m_numUsed = 0;
+  }
+
+  /**
+   * Make room for at least n rows (rounded up to whole tiles).
+   * Trivially relocatable arrays are moved with Allocator::reallocate (which
+   * may expand the block in place), otherwise the rows are moved tile by tile
+   * into a new block.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::reserve(size_t n)
+  {
+    const size_t numTiles = (n + TTileRows - 1) / TTileRows;
+    if (numTiles <= m_numTiles)
+      return;
+
+    if (detail::IsTriviallyRelocatable<TArrays...>::value)
+    {
+      m_data = static_cast<char*>(m_allocator->reallocate(m_data, m_numTiles * tileBytes, numTiles * tileBytes, Layout::maxAlignment));
+      m_numTiles = numTiles;
+      return;
+    }
+
+    char* data = static_cast<char*>(m_allocator->allocateAligned(numTiles * tileBytes, Layout::maxAlignment));
+
+    const size_t num = this->numTiles();
+    for (size_t t = 0; t < num; ++t)
+    {
+      void* src[sizeof...(TArrays)];
+      void* dst[sizeof...(TArrays)];
+      tileArrays(t, src);
+      for (size_t i = 0; i < sizeof...(TArrays); ++i)
+        dst[i] = data + t * tileBytes + Offsets::values[i];
+
+      ForEachArray::moveRange(src, 0, dst, 0, m_numUsed - t * TTileRows < TTileRows ? m_numUsed - t * TTileRows : TTileRows);
+    }
+
+    if (m_data)
+      m_allocator->deallocateSized(m_data, m_numTiles * tileBytes, Layout::maxAlignment);
+
+    m_data = data;
+    m_numTiles = numTiles;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  size_t BasicTiledArrays<TGrowth, TTileRows, TArrays...>::numTiles() const
+  {
+    return (m_numUsed + TTileRows - 1) / TTileRows;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::tile(size_t t) -> Tile
+  {
+    assert(t < numTiles() && "tile out of range");
+    return *TileIterator(m_data, t, m_numUsed);
+  }
+
+  /**
+   * All tiles that contain rows, for use in range-based for-loops:
+   *   for (auto tile : arrays.tiles())
+   *     process(tile.size(), tile.data<0>(), tile.data<1>());
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::tiles() -> TileRange
+  {
+    return TileRange{ TileIterator(m_data, 0, m_numUsed), TileIterator(m_data, numTiles(), m_numUsed) };
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::at(size_t i) -> Type<Index>&
+  {
+    assert(i < m_numUsed && "index i out of range");
+    return reinterpret_cast<Type<Index>*>(m_data + (i / TTileRows) * tileBytes + Offsets::values[Index])[i % TTileRows];
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  template<size_t Index>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    assert(i < m_numUsed && "index i out of range");
+    return reinterpret_cast<const Type<Index>*>(m_data + (i / TTileRows) * tileBytes + Offsets::values[Index])[i % TTileRows];
+  }
+
+  /**
+   * Append a row, see BasicArrays::append.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  template<typename... TArgs>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::append(TArgs... args)
+  {
+    static_assert(sizeof...(TArgs) == sizeof...(TArrays), "number of arguments does not match number of arrays");
+
+    grow(m_numUsed + 1);
+
+    void* arrays[sizeof...(TArrays)];
+    tileArrays(m_numUsed / TTileRows, arrays);
+    ForEachArray::constructAt(arrays, m_numUsed % TTileRows, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  /**
+   * Append a row, see BasicArrays::emplaceBack.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  template<typename... TArgs>
+  auto BasicTiledArrays<TGrowth, TTileRows, TArrays...>::emplaceBack(TArgs&&... args)
+    -> typename std::enable_if<sizeof...(TArgs) == sizeof...(TArrays), void>::type
+  {
+    grow(m_numUsed + 1);
+
+    void* arrays[sizeof...(TArrays)];
+    tileArrays(m_numUsed / TTileRows, arrays);
+    ForEachArray::constructAt(arrays, m_numUsed % TTileRows, std::forward<TArgs>(args)...);
+
+    ++m_numUsed;
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::removeLast()
+  {
+    assert(m_numUsed > 0 && "container is empty");
+
+    --m_numUsed;
+
+    void* arrays[sizeof...(TArrays)];
+    tileArrays(m_numUsed / TTileRows, arrays);
+    ForEachArray::destructRange(arrays, m_numUsed % TTileRows, 1);
+  }
+
+  /**
+   * Remove the row at index by moving the last row into its place, see
+   * BasicArrays::removeAtUnordered.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::removeAtUnordered(size_t index)
+  {
+    assert(index < m_numUsed && "index out of range");
+
+    const size_t last = m_numUsed - 1;
+
+    void* arrays[sizeof...(TArrays)];
+    tileArrays(index / TTileRows, arrays);
+    ForEachArray::destructRange(arrays, index % TTileRows, 1);
+
+    if (index != last)
+    {
+      void* lastArrays[sizeof...(TArrays)];
+      tileArrays(last / TTileRows, lastArrays);
+      ForEachArray::moveRange(lastArrays, last % TTileRows, arrays, index % TTileRows, 1);
+    }
+
+    --m_numUsed;
+  }
+
+  /**
+   * Process all rows tile by tile, for each tile
+   *   fn(0, tile.size(), tile.data<Indices>()...)
+   * is called (same signature as for BasicArrays::parallelForEach).
+   * All but the last tile have exactly TTileRows rows.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  template<size_t... Indices, typename TFunction>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::forEachTile(TFunction fn)
+  {
+    const size_t full = m_numUsed / TTileRows;
+    for (size_t t = 0; t < full; ++t)
+    {
+      const Tile tile(m_data + t * tileBytes, TTileRows);
+      fn((size_t)0, TTileRows, tile.template data<Indices>()...);
+    }
+
+    if (full * TTileRows < m_numUsed)
+    {
+      const Tile tile(m_data + full * tileBytes, m_numUsed - full * TTileRows);
+      fn((size_t)0, tile.size(), tile.template data<Indices>()...);
+    }
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::grow(size_t required)
+  {
+    if (capacity() >= required)
+      return;
+
+    reserve(TGrowth::capacity(capacity(), required));
+  }
+
+  /**
+   * set the array pointers of a tile.
+   */
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::tileArrays(size_t t, void** arrays) const
+  {
+    char* begin = m_data + t * tileBytes;
+    for (size_t i = 0; i < sizeof...(TArrays); ++i)
+      arrays[i] = begin + Offsets::values[i];
+  }
+
+  template<typename TGrowth, size_t TTileRows, typename... TArrays>
+  void BasicTiledArrays<TGrowth, TTileRows, TArrays...>::destructAll()
+  {
+    if (detail::IsTriviallyRelocatable<TArrays...>::value)
+      return;
+
+    const size_t num = numTiles();
+    for (size_t t = 0; t < num; ++t)
+    {
+      void* arrays[sizeof...(TArrays)];
+      tileArrays(t, arrays);
+      ForEachArray::destructRange(arrays, 0, m_numUsed - t * TTileRows < TTileRows ? m_numUsed - t * TTileRows : TTileRows);
+    }
+  }
+}
@@ -0,0 +1,522 @@
+#pragma once
+#include <johl/Arrays.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace johl
+{
+  namespace detail
+  {
+    template<bool TEnabled, typename TGrowth, typename... TArrays>
+    class ChangeTracker;
+  }
+
+  /**
+   * Arrays with change tracking, so systems that process the arrays every
+   * frame can skip the rows and arrays that did not change. Each array has a
+   * dirty flag per row (a bit array that is moved along with the rows) and
+   * a version: version() counts all changes, version<Index>() is the
+   * version of the last change of array Index.
+   *
+   * Writes through the non-const at<Index>(i) and markDirty<Index>(i) mark
+   * row i of array Index dirty. append and insertAt mark all arrays of the
+   * new row dirty, swapAt and removeAtUnordered mark all arrays of the rows
+   * that received other elements dirty. The dirty flags of shifted rows
+   * (removeAt, insertAt) move with the rows. Every structural change
+   * updates the versions of all arrays. Writes through data<Index>() are
+   * not tracked, use markDirty.
+   * The flags are reset with clearDirty, typically after the dirty rows
+   * have been processed (see forEachDirty).
+   *
+   * With TTrackChanges = false nothing is tracked and nothing is stored
+   * (the tracker is an empty private base): all rows are always dirty and
+   * all versions are the maximum version, so the same processing code
+   * visits every row.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  class BasicTrackedArrays final : private detail::ChangeTracker<TTrackChanges, TGrowth, TArrays...>
+  {
+  private:
+    template<size_t Index>
+    using Type = typename detail::AlignedType<typename detail::Get<Index, TArrays...>::Type>::Type;
+
+    using Rows = BasicArrays<TGrowth, TArrays...>;
+    using Tracker = detail::ChangeTracker<TTrackChanges, TGrowth, TArrays...>;
+
+  public:
+    using GrowthPolicy = TGrowth;
+
+    static const bool tracksChanges = TTrackChanges;
+
+    explicit BasicTrackedArrays(Allocator* allocator = Allocator::defaultAllocator());
+
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+    void reserve(size_t n);
+
+    template<typename... TArgs>
+    void append(TArgs&&... args);
+
+    template<typename... TArgs>
+    void insertAt(size_t index, TArgs&&... args);
+
+    void removeAt(size_t index);
+    void removeAtUnordered(size_t index);
+    void swapAt(size_t a, size_t b);
+
+    template<size_t Index>
+    Type<Index>& at(size_t i);
+
+    template<size_t Index>
+    const Type<Index>& at(size_t i) const;
+
+    template<size_t Index>
+    ArrayRef<const Type<Index>> array() const;
+
+    template<size_t Index>
+    Type<Index>* data();
+
+    template<size_t Index>
+    const Type<Index>* data() const;
+
+    template<size_t Index>
+    void markDirty(size_t i);
+
+    template<size_t Index>
+    bool isDirty(size_t i) const;
+
+    template<size_t Index>
+    size_t countDirty() const;
+
+    template<size_t Index, typename TFunction>
+    void forEachDirty(TFunction fn) const;
+
+    void clearDirty();
+
+    template<size_t Index>
+    void clearDirty();
+
+    std::uint64_t version() const;
+
+    template<size_t Index>
+    std::uint64_t version() const;
+
+  private:
+    Tracker& tracker();
+    const Tracker& tracker() const;
+
+    Rows m_rows;
+  };
+
+  /**
+   * TrackedArrays with the default growth policy.
+   */
+  template<typename... TArrays>
+  using TrackedArrays = BasicTrackedArrays<geometric_growth<>, true, TArrays...>;
+
+  //============================================================================
+
+  namespace detail
+  {
+    //one dirty bit array per array
+    template<typename T>
+    struct DirtyColumn final
+    {
+      DirtyColumn() = delete;
+
+      using Type = bits;
+      static const bool dirty = true;
+    };
+
+    template<typename T>
+    const bool DirtyColumn<T>::dirty;
+
+    template<typename TGrowth, typename... TArrays>
+    class ChangeTracker<true, TGrowth, TArrays...>
+    {
+    private:
+      using Flags = BasicArrays<TGrowth, typename DirtyColumn<TArrays>::Type...>;
+      using Indices = typename MakeIndexSequence<sizeof...(TArrays)>::Type;
+
+      static const size_t numArrays = sizeof...(TArrays);
+
+    public:
+      explicit ChangeTracker(Allocator* allocator)
+        : m_flags(allocator)
+        , m_version(0)
+      {
+        std::fill(m_versions, m_versions + numArrays, (std::uint64_t)0);
+      }
+
+      void reserve(size_t n)
+      {
+        m_flags.reserve(n);
+      }
+
+      void clear()
+      {
+        m_flags.clear();
+        changed();
+      }
+
+      void append()
+      {
+        m_flags.append(DirtyColumn<TArrays>::dirty...);
+        changed();
+      }
+
+      void insertAt(size_t index)
+      {
+        //same bounds as the rows (emplaceAt), index may be size()
+        m_flags.emplaceAt(index, DirtyColumn<TArrays>::dirty...);
+        changed();
+      }
+
+      void removeAt(size_t index)
+      {
+        m_flags.removeAt(index);
+        changed();
+      }
+
+      void removeAtUnordered(size_t index)
+      {
+        m_flags.removeAtUnordered(index);
+        if (index < m_flags.size())
+          markRow(index, Indices());
+        changed();
+      }
+
+      void swapAt(size_t a, size_t b)
+      {
+        markRow(a, Indices());
+        markRow(b, Indices());
+        changed();
+      }
+
+      template<size_t Index>
+      void mark(size_t i)
+      {
+        m_flags.template setBit<Index>(i);
+        m_versions[Index] = ++m_version;
+      }
+
+      template<size_t Index>
+      bool isDirty(size_t i) const
+      {
+        return m_flags.template testBit<Index>(i);
+      }
+
+      template<size_t Index>
+      size_t countDirty(size_t) const
+      {
+        return m_flags.template countBits<Index>();
+      }
+
+      template<size_t Index, typename TFunction>
+      void forEachDirty(size_t, TFunction& fn) const
+      {
+        m_flags.template forEachSetBit<Index>(fn);
+      }
+
+      template<size_t Index>
+      void clearDirty()
+      {
+        std::uint64_t* words = m_flags.template data<Index>();
+        std::fill(words, words + bitarray::numWords(m_flags.size()), (std::uint64_t)0);
+      }
+
+      void clearDirty()
+      {
+        clearDirty(Indices());
+      }
+
+      std::uint64_t version() const
+      {
+        return m_version;
+      }
+
+      template<size_t Index>
+      std::uint64_t version() const
+      {
+        return m_versions[Index];
+      }
+
+    private:
+      //a structural change, changes all arrays
+      void changed()
+      {
+        std::fill(m_versions, m_versions + numArrays, ++m_version);
+      }
+
+      template<size_t... Is>
+      void markRow(size_t i, IndexSequence<Is...>)
+      {
+        const int marked[] = { (m_flags.template setBit<Is>(i), 0)... };
+        unused(marked);
+      }
+
+      template<size_t... Is>
+      void clearDirty(IndexSequence<Is...>)
+      {
+        const int cleared[] = { (clearDirty<Is>(), 0)... };
+        unused(cleared);
+      }
+
+      Flags m_flags;
+      std::uint64_t m_version;
+      std::uint64_t m_versions[numArrays];
+    };
+
+    //no tracking: every row is dirty, versions are always the maximum
+    template<typename TGrowth, typename... TArrays>
+    class ChangeTracker<false, TGrowth, TArrays...>
+    {
+    public:
+      explicit ChangeTracker(Allocator*) {}
+
+      void reserve(size_t) {}
+      void clear() {}
+      void append() {}
+      void insertAt(size_t) {}
+      void removeAt(size_t) {}
+      void removeAtUnordered(size_t) {}
+      void swapAt(size_t, size_t) {}
+
+      template<size_t Index>
+      void mark(size_t) {}
+
+      template<size_t Index>
+      bool isDirty(size_t) const
+      {
+        return true;
+      }
+
+      template<size_t Index>
+      size_t countDirty(size_t size) const
+      {
+        return size;
+      }
+
+      template<size_t Index, typename TFunction>
+      void forEachDirty(size_t size, TFunction& fn) const
+      {
+        for (size_t i = 0; i < size; ++i)
+          fn(i);
+      }
+
+      template<size_t Index>
+      void clearDirty() {}
+
+      void clearDirty() {}
+
+      std::uint64_t version() const
+      {
+        return ~(std::uint64_t)0;
+      }
+
+      template<size_t Index>
+      std::uint64_t version() const
+      {
+        return ~(std::uint64_t)0;
+      }
+    };
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::BasicTrackedArrays(Allocator* allocator)
+    : Tracker(allocator)
+    , m_rows(allocator)
+  {
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::tracker() -> Tracker&
+  {
+    return *this;
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::tracker() const -> const Tracker&
+  {
+    return *this;
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  size_t BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::size() const
+  {
+    return m_rows.size();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  size_t BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::capacity() const
+  {
+    return m_rows.capacity();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::clear()
+  {
+    m_rows.clear();
+    tracker().clear();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::reserve(size_t n)
+  {
+    m_rows.reserve(n);
+    tracker().reserve(n);
+  }
+
+  /**
+   * Append a row (see Arrays::emplaceBack), the new row is dirty.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<typename... TArgs>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::append(TArgs&&... args)
+  {
+    m_rows.emplaceBack(std::forward<TArgs>(args)...);
+    tracker().append();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<typename... TArgs>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::insertAt(size_t index, TArgs&&... args)
+  {
+    m_rows.emplaceAt(index, std::forward<TArgs>(args)...);
+    tracker().insertAt(index);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::removeAt(size_t index)
+  {
+    m_rows.removeAt(index);
+    tracker().removeAt(index);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::removeAtUnordered(size_t index)
+  {
+    m_rows.removeAtUnordered(index);
+    tracker().removeAtUnordered(index);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::swapAt(size_t a, size_t b)
+  {
+    m_rows.swapAt(a, b);
+    tracker().swapAt(a, b);
+  }
+
+  /**
+   * Element i of array Index for writing, marks the row dirty.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::at(size_t i) -> Type<Index>&
+  {
+    Type<Index>& element = m_rows.template at<Index>(i);
+    tracker().template mark<Index>(i);
+    return element;
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::at(size_t i) const -> const Type<Index>&
+  {
+    return m_rows.template at<Index>(i);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::array() const -> ArrayRef<const Type<Index>>
+  {
+    return m_rows.template array<Index>();
+  }
+
+  /**
+   * Writes through the returned pointer are not tracked, see markDirty.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::data() -> Type<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  auto BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::data() const -> const Type<Index>*
+  {
+    return m_rows.template data<Index>();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::markDirty(size_t i)
+  {
+    assert(i < m_rows.size() && "index out of range");
+    tracker().template mark<Index>(i);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  bool BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::isDirty(size_t i) const
+  {
+    return tracker().template isDirty<Index>(i);
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  size_t BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::countDirty() const
+  {
+    return tracker().template countDirty<Index>(m_rows.size());
+  }
+
+  /**
+   * Calls fn(i) for each row i with a dirty element in array Index, in
+   * ascending order. Rows without changes are skipped 64 at a time.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index, typename TFunction>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::forEachDirty(TFunction fn) const
+  {
+    tracker().template forEachDirty<Index>(m_rows.size(), fn);
+  }
+
+  /**
+   * Resets the dirty flags of all arrays, the versions do not change.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::clearDirty()
+  {
+    tracker().clearDirty();
+  }
+
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  void BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::clearDirty()
+  {
+    tracker().template clearDirty<Index>();
+  }
+
+  /**
+   * Incremented by every change, never decreases (also not by clear).
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  std::uint64_t BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::version() const
+  {
+    return tracker().version();
+  }
+
+  /**
+   * Version of the last change of array Index, an array with the same
+   * version as in an earlier frame has not changed since.
+   */
+  template<typename TGrowth, bool TTrackChanges, typename... TArrays>
+  template<size_t Index>
+  std::uint64_t BasicTrackedArrays<TGrowth, TTrackChanges, TArrays...>::version() const
+  {
+    return tracker().template version<Index>();
+  }
+}
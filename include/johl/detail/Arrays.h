@@ -2,10 +2,13 @@
 
 #include <type_traits>
 #include <utility>
+#include <tuple>
+#include <new>
 #include <cstring>
 #include <cstdint>
 
 #include <ciso646>
+#include <johl/detail/Bits.h>
 
 namespace johl
 {
@@ -46,6 +49,20 @@ namespace detail
   {
   }
 
+  /**
+   * Software prefetch of the cache line at p (a hint, p may be any address).
+   * Returns 0, so it can be expanded over a parameter pack.
+   */
+  inline int prefetch(const void* p)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    unused(p);
+#endif
+    return 0;
+  }
+
   /**
    * Template meta program to get the n-th type from a parameter pack (TArrays).
    */
@@ -67,6 +84,29 @@ namespace detail
     typedef typename Get<Index - 1, Rest...>::Type Type;
   };
   
+  /**
+   * compile time sequence of indices (C++11 replacement for std::index_sequence).
+   * MakeIndexSequence<N>::Type is IndexSequence<0, 1, ..., N-1>.
+   */
+  template<size_t... Indices>
+  struct IndexSequence final
+  {
+  };
+
+  template<size_t N, size_t... Indices>
+  struct MakeIndexSequence final
+  {
+    MakeIndexSequence() = delete;
+    typedef typename MakeIndexSequence<N - 1, N - 1, Indices...>::Type Type;
+  };
+
+  template<size_t... Indices>
+  struct MakeIndexSequence<0, Indices...> final
+  {
+    MakeIndexSequence() = delete;
+    typedef IndexSequence<Indices...> Type; //end of template meta program recursion
+  };
+
   /**
    * check at compile time, if N is a power of two
    */
@@ -80,7 +120,7 @@ namespace detail
   
   /**
    * AlignedType::Type is always the actual type.
-   * AlignedType::align is the default alignment.
+   * AlignedType::align is the default alignment (the natural alignment of T).
    * this type will be specialized for the 'align' tag type, that override the
    * alignment.
    */
@@ -89,30 +129,52 @@ namespace detail
   {
     AlignedType() = delete;
     using Type = T;
-    static const size_t align = 4;
+    static const size_t align = alignof(T);
   }; 
 
   /**
-   * template meta program to calculate the sum of all alignments for a given
-   * list of types.
+   * Column group of an array: 0 for all arrays, except for arrays annotated
+   * with the 'group' tag type (see Arrays header). Each group of a container
+   * gets its own block of memory.
    */
+  template<typename T>
+  struct ColumnGroup final
+  {
+    ColumnGroup() = delete;
+    static const size_t value = 0;
+  };
+
+  /**
+   * true for arrays that store one bit per row (see the 'bits' tag type in
+   * the Arrays header). Bit arrays are stored as packed 64 bit words.
+   */
+  template<typename T>
+  struct IsBitArray final
+  {
+    IsBitArray() = delete;
+    static const bool value = false;
+  };
+
+  //number of groups (highest group + 1)
   template<typename... Types>
-  struct SumAlignment;
+  struct NumGroups;
 
   template<typename T>
-  struct SumAlignment<T> final
+  struct NumGroups<T> final
   {
-    SumAlignment() = delete;
-    static const size_t value = AlignedType<T>::align;
+    NumGroups() = delete;
+    static const size_t value = ColumnGroup<T>::value + 1;
   };
 
   template<typename TFirst, typename... TRest>
-  struct SumAlignment<TFirst, TRest...> final
+  struct NumGroups<TFirst, TRest...> final
   {
-    SumAlignment() = delete;
-    static const size_t value = AlignedType<TFirst>::align + SumAlignment<TRest...>::value;
+    NumGroups() = delete;
+    static const size_t value = NumGroups<TFirst>::value > NumGroups<TRest...>::value ? NumGroups<TFirst>::value : NumGroups<TRest...>::value;
   };
 
+  //group index that selects all arrays of a container
+  static const size_t allGroups = (size_t)-1;
 
   /**
    * template meta program to calculate the sum of all sizes for a given
@@ -133,6 +195,267 @@ namespace detail
     static const size_t value = sizeof(typename AlignedType<TFirst>::Type) + SumSize<TRest...>::value;
   };
 
+  /**
+   * template meta program to check if all types are trivially relocatable
+   * (trivially copyable and trivially destructible, see moveData), so they 
+   * can be moved around in memory with memmove.
+   */
+  template<typename... Types>
+  struct IsTriviallyRelocatable;
+
+  template<typename T>
+  struct IsTriviallyRelocatable<T> final
+  {
+    IsTriviallyRelocatable() = delete;
+    using Type = typename AlignedType<T>::Type;
+    static const bool value = is_trivially_copyable<Type>::value && is_trivially_destructible<Type>::value;
+  };
+
+  template<typename TFirst, typename... TRest>
+  struct IsTriviallyRelocatable<TFirst, TRest...> final
+  {
+    IsTriviallyRelocatable() = delete;
+    static const bool value = IsTriviallyRelocatable<TFirst>::value && IsTriviallyRelocatable<TRest...>::value;
+  };
+
+  //same as IsTriviallyRelocatable for the arrays of one group
+  template<size_t TGroup, typename... Types>
+  struct IsGroupTriviallyRelocatable;
+
+  template<size_t TGroup, typename T>
+  struct IsGroupTriviallyRelocatable<TGroup, T> final
+  {
+    IsGroupTriviallyRelocatable() = delete;
+    static const bool value = ColumnGroup<T>::value != TGroup || IsTriviallyRelocatable<T>::value;
+  };
+
+  template<size_t TGroup, typename TFirst, typename... TRest>
+  struct IsGroupTriviallyRelocatable<TGroup, TFirst, TRest...> final
+  {
+    IsGroupTriviallyRelocatable() = delete;
+    static const bool value = IsGroupTriviallyRelocatable<TGroup, TFirst>::value && IsGroupTriviallyRelocatable<TGroup, TRest...>::value;
+  };
+
+  /**
+   * round offset up to the next multiple of alignment (power of two)
+   */
+  constexpr size_t alignUp(size_t offset, size_t alignment)
+  {
+    return (offset + alignment - 1) & ~(alignment - 1);
+  }
+
+  /**
+   * per array sizes and alignments, and the order in which the arrays are
+   * placed in memory: stable sorted by descending alignment.
+   * Arrays that are not part of TGroup (unless TGroup is allGroups) have size
+   * 0 and alignment 1, so they are placed at the end of the block and take
+   * no space.
+   */
+  template<size_t TGroup, typename... TArrays>
+  struct LayoutTraits
+  {
+    LayoutTraits() = delete;
+
+    static constexpr size_t numArrays = sizeof...(TArrays);
+    static constexpr bool contains[] = { (TGroup == allGroups || ColumnGroup<TArrays>::value == TGroup)... };
+    static constexpr bool bitArrays[] = { ((TGroup == allGroups || ColumnGroup<TArrays>::value == TGroup) && IsBitArray<TArrays>::value)... };
+    static constexpr size_t sizes[] = { ((TGroup == allGroups || ColumnGroup<TArrays>::value == TGroup) && !IsBitArray<TArrays>::value ? sizeof(typename AlignedType<TArrays>::Type) : 0)... };
+    static constexpr size_t alignments[] = { ((TGroup == allGroups || ColumnGroup<TArrays>::value == TGroup) ? AlignedType<TArrays>::align : 1)... };
+
+    static constexpr size_t sumSizes(size_t index = 0)
+    {
+      return index == numArrays ? 0 : sizes[index] + sumSizes(index + 1);
+    }
+
+    static constexpr size_t sumBits(size_t index = 0)
+    {
+      return index == numArrays ? 0 : (bitArrays[index] ? 1 : sizes[index] * 8) + sumBits(index + 1);
+    }
+
+    //bytes of array 'index' for numRows rows (whole words for bit arrays)
+    static constexpr size_t arrayBytes(size_t index, size_t numRows)
+    {
+      return bitArrays[index] ? (numRows + 63) / 64 * sizeof(std::uint64_t) : sizes[index] * numRows;
+    }
+
+    //number of arrays that are placed in front of array 'index'
+    static constexpr size_t rank(size_t index, size_t other = 0)
+    {
+      return other == numArrays ? 0 :
+        ((alignments[other] > alignments[index] || (alignments[other] == alignments[index] && other < index)) ? 1 : 0) + rank(index, other + 1);
+    }
+
+    //index of the array with the given rank
+    static constexpr size_t withRank(size_t position, size_t index = 0)
+    {
+      return rank(index) == position ? index : withRank(position, index + 1);
+    }
+
+    static constexpr size_t maxAlignment(size_t index = 0)
+    {
+      return index + 1 == numArrays ? alignments[index] :
+        (alignments[index] > maxAlignment(index + 1) ? alignments[index] : maxAlignment(index + 1));
+    }
+  };
+
+  template<size_t TGroup, typename... TArrays>
+  constexpr bool LayoutTraits<TGroup, TArrays...>::contains[];
+
+  template<size_t TGroup, typename... TArrays>
+  constexpr bool LayoutTraits<TGroup, TArrays...>::bitArrays[];
+
+  template<size_t TGroup, typename... TArrays>
+  constexpr size_t LayoutTraits<TGroup, TArrays...>::sizes[];
+
+  template<size_t TGroup, typename... TArrays>
+  constexpr size_t LayoutTraits<TGroup, TArrays...>::alignments[];
+
+  /**
+   * memory layout of a block of rows (see johl::ArraysLayout), TGroup selects
+   * the arrays in the block (see LayoutTraits).
+   */
+  template<typename TSequence, size_t TGroup, typename... TArrays>
+  struct Layout;
+
+  template<size_t... Indices, size_t TGroup, typename... TArrays>
+  struct Layout<IndexSequence<Indices...>, TGroup, TArrays...> final
+  {
+  private:
+    using Traits = LayoutTraits<TGroup, TArrays...>;
+
+    static constexpr size_t positions[] = { Traits::rank(Indices)... };
+    static constexpr size_t order[] = { Traits::withRank(Indices)... };
+
+    static constexpr size_t offsetAt(size_t position, size_t numRows)
+    {
+      return position == 0 ? 0 :
+        alignUp(offsetAt(position - 1, numRows) + Traits::arrayBytes(order[position - 1], numRows), Traits::alignments[order[position]]);
+    }
+
+  public:
+    Layout() = delete;
+
+    static constexpr size_t numArrays = sizeof...(TArrays);
+    //bit arrays are not included in bytesPerRow, but in bitsPerRow
+    static constexpr size_t bytesPerRow = Traits::sumSizes();
+    static constexpr size_t bitsPerRow = Traits::sumBits();
+    static constexpr size_t maxAlignment = Traits::maxAlignment();
+
+    //true if array 'index' is stored in this block
+    static constexpr bool contains(size_t index)
+    {
+      return Traits::contains[index];
+    }
+
+    //size of an element in bytes (0 for bit arrays)
+    static constexpr size_t arraySize(size_t index)
+    {
+      return Traits::sizes[index];
+    }
+
+    static constexpr bool isBitArray(size_t index)
+    {
+      return Traits::bitArrays[index];
+    }
+
+    //size of array 'index' in bytes for numRows rows
+    static constexpr size_t arrayBytes(size_t index, size_t numRows)
+    {
+      return Traits::arrayBytes(index, numRows);
+    }
+
+    static constexpr size_t arrayAlignment(size_t index)
+    {
+      return Traits::alignments[index];
+    }
+
+    //position of array 'index' in memory (0 = first array in the block)
+    static constexpr size_t position(size_t index)
+    {
+      return positions[index];
+    }
+
+    //index of the array at the given position in memory
+    static constexpr size_t arrayAt(size_t position)
+    {
+      return order[position];
+    }
+
+    //offset in bytes of array 'index' relative to the begin of the block
+    static constexpr size_t offset(size_t index, size_t numRows)
+    {
+      return offsetAt(positions[index], numRows);
+    }
+
+    //size in bytes of a block for numRows rows, starting at an address
+    //aligned to maxAlignment
+    static constexpr size_t bytes(size_t numRows)
+    {
+      return offsetAt(numArrays - 1, numRows) + Traits::arrayBytes(order[numArrays - 1], numRows);
+    }
+
+    //padding bytes in a block of numRows rows
+    static constexpr size_t padding(size_t numRows)
+    {
+      return bytes(numRows) - (bitsPerRow * numRows + 7) / 8;
+    }
+  };
+
+  template<size_t... Indices, size_t TGroup, typename... TArrays>
+  constexpr size_t Layout<IndexSequence<Indices...>, TGroup, TArrays...>::positions[];
+
+  template<size_t... Indices, size_t TGroup, typename... TArrays>
+  constexpr size_t Layout<IndexSequence<Indices...>, TGroup, TArrays...>::order[];
+
+  /**
+   * Layouts of all groups of a container, indexed by the group at runtime.
+   */
+  template<typename TGroups, typename... TArrays>
+  struct GroupLayouts;
+
+  template<size_t... Groups, typename... TArrays>
+  struct GroupLayouts<IndexSequence<Groups...>, TArrays...> final
+  {
+  private:
+    using Sequence = typename MakeIndexSequence<sizeof...(TArrays)>::Type;
+
+    template<size_t TGroup>
+    using GroupLayout = Layout<Sequence, TGroup, TArrays...>;
+
+  public:
+    GroupLayouts() = delete;
+
+    static constexpr size_t numGroups = sizeof...(Groups);
+    static constexpr size_t groups[] = { ColumnGroup<TArrays>::value... };
+    static constexpr size_t maxAlignment[] = { GroupLayout<Groups>::maxAlignment... };
+    static constexpr size_t bitsPerRow[] = { GroupLayout<Groups>::bitsPerRow... };
+    static constexpr bool triviallyRelocatable[] = { IsGroupTriviallyRelocatable<Groups, TArrays...>::value... };
+
+    static size_t bytes(size_t group, size_t numRows)
+    {
+      static size_t (* const functions[])(size_t) = { &GroupLayout<Groups>::bytes... };
+      return functions[group](numRows);
+    }
+
+    static size_t arrayAt(size_t group, size_t position)
+    {
+      static size_t (* const functions[])(size_t) = { &GroupLayout<Groups>::arrayAt... };
+      return functions[group](position);
+    }
+  };
+
+  template<size_t... Groups, typename... TArrays>
+  constexpr size_t GroupLayouts<IndexSequence<Groups...>, TArrays...>::groups[];
+
+  template<size_t... Groups, typename... TArrays>
+  constexpr size_t GroupLayouts<IndexSequence<Groups...>, TArrays...>::maxAlignment[];
+
+  template<size_t... Groups, typename... TArrays>
+  constexpr size_t GroupLayouts<IndexSequence<Groups...>, TArrays...>::bitsPerRow[];
+
+  template<size_t... Groups, typename... TArrays>
+  constexpr bool GroupLayouts<IndexSequence<Groups...>, TArrays...>::triviallyRelocatable[];
+
 namespace arrays
 {
 
@@ -174,7 +497,8 @@ namespace arrays
   typename std::enable_if<is_trivially_destructible<T>::value && is_trivially_copyable<T>::value, void>::type 
     moveData(T* dst, const T* src, size_t num)
   {
-      memmove(dst, src, sizeof(T) * num);   
+      if (num > 0) //src and dst may be nullptr (empty arrays)
+        memmove(dst, src, sizeof(T) * num);   
   }
 
   /**
@@ -196,6 +520,9 @@ namespace arrays
         src[index].~T();                            //destruct old object
       };
 
+      if (dst == src)
+        return;
+
       if (dst < src)
       {
         for (size_t i = 0; i < num; ++i)
@@ -208,6 +535,76 @@ namespace arrays
       }
   }
   
+  /**
+   * copy trivial data from src to dst by calling memcpy.
+   * src and dst must not overlap.
+   *
+   * This function is removed from overload resolution if type T is not trivially destructible or not trivially copyable.
+   */
+  template<class T>
+  typename std::enable_if<is_trivially_destructible<T>::value && is_trivially_copyable<T>::value, void>::type
+    copyData(T* dst, const T* src, size_t num)
+  {
+      if (num > 0) //src and dst may be nullptr (empty arrays)
+        memcpy(dst, src, sizeof(T) * num);
+  }
+
+  /**
+   * copy non-trivial data from src to dst by copy-constructing each object at 
+   * dst[i] (assumes dst is raw memory!). src and dst must not overlap.
+   *
+   * This function is removed from overload resolution if type T is trivially destructible and trivially copyable.
+   */
+  template<class T>
+  typename std::enable_if<!(is_trivially_destructible<T>::value && is_trivially_copyable<T>::value), void>::type
+    copyData(T* dst, const T* src, size_t num)
+  {
+      for (size_t i = 0; i < num; ++i)
+        new (&dst[i]) T(src[i]);
+  }
+
+  /**
+   * gather trivial data: dst[i] = src[indices[i]]. src and dst must not overlap.
+   *
+   * This function is removed from overload resolution if type T is not trivially destructible or not trivially copyable.
+   */
+  template<class T>
+  typename std::enable_if<is_trivially_destructible<T>::value && is_trivially_copyable<T>::value, void>::type
+    gatherData(T* dst, T* src, const size_t* indices, size_t num)
+  {
+      for (size_t i = 0; i < num; ++i)
+        memcpy(&dst[i], &src[indices[i]], sizeof(T));
+  }
+
+  /**
+   * gather non-trivial data: move-construct dst[i] from src[indices[i]]
+   * (assumes dst is raw memory!), destructs all objects in src afterwards.
+   * indices must be a permutation of 0..num-1. src and dst must not overlap.
+   *
+   * This function is removed from overload resolution if type T is trivially destructible and trivially copyable.
+   */
+  template<class T>
+  typename std::enable_if<!(is_trivially_destructible<T>::value && is_trivially_copyable<T>::value), void>::type
+    gatherData(T* dst, T* src, const size_t* indices, size_t num)
+  {
+      for (size_t i = 0; i < num; ++i)
+        new (&dst[i]) T(std::move(src[indices[i]]));
+
+      for (size_t i = 0; i < num; ++i)
+        src[i].~T();
+  }
+
+  /**
+   * construct object at dst (assumes dst is raw memory!) from the elements of
+   * a tuple of constructor arguments (see std::forward_as_tuple).
+   */
+  template<class T, typename... TArgs, size_t... Indices>
+  void constructFromTuple(T* dst, std::tuple<TArgs...>& args, IndexSequence<Indices...>)
+  {
+    unused(args);
+    new (dst) T(std::forward<TArgs>(std::get<Indices>(args))...);
+  }
+
   /**
    * Call destructor for a given range of objects.    
    * Enabled only for trivially destructible types (does nothing).
@@ -244,11 +641,6 @@ namespace arrays
   template<size_t TypeIndex>
   struct ForEach<0, TypeIndex>
   {
-    static void initArrayPointer(void** arrays, void* data, size_t numAllocated)
-    { 
-      unused(arrays, data, numAllocated); 
-    }
-
     static void destructRange(void** arrays, size_t from, size_t num) 
     { 
       unused(arrays, from, num); 
@@ -259,19 +651,54 @@ namespace arrays
       unused(arrays, index);
     }
 
+    static void constructPiecewiseAt(void** arrays, size_t index)
+    { 
+      unused(arrays, index);
+    }
+
     static void moveRange(void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
     {
       unused(src_arrays, src_from, dst_arrays, dst_from, num);
     }
 
+    static void moveGroupRange(size_t group, void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
+    {
+      unused(group, src_arrays, src_from, dst_arrays, dst_from, num);
+    }
+
+    static void copyRange(void** arrays, size_t from, size_t num)
+    {
+      unused(arrays, from, num);
+    }
+
+    static void copyArrays(void* const* src_arrays, void** dst_arrays, size_t num)
+    {
+      unused(src_arrays, dst_arrays, num);
+    }
+
+    static void gatherArrays(void** src_arrays, void** dst_arrays, const size_t* indices, size_t num)
+    {
+      unused(src_arrays, dst_arrays, indices, num);
+    }
+
     static void swap(void** arrays, size_t a, size_t b)
     {
       unused(arrays, a, b);
     }
   };
   
+  //operations on array TypeIndex (First), TBits selects the implementation
+  //for bit arrays
+  template<bool TBits, size_t RemainingTypes, size_t TypeIndex, typename First, typename... Rest>
+  struct ForEachArray;
+
   template<size_t RemainingTypes, size_t TypeIndex, typename First, typename... Rest>
-  struct ForEach<RemainingTypes, TypeIndex, First, Rest...>
+  struct ForEach<RemainingTypes, TypeIndex, First, Rest...> : ForEachArray<IsBitArray<First>::value, RemainingTypes, TypeIndex, First, Rest...>
+  {
+  };
+
+  template<size_t RemainingTypes, size_t TypeIndex, typename First, typename... Rest>
+  struct ForEachArray<false, RemainingTypes, TypeIndex, First, Rest...>
   {
     using Next = ForEach<RemainingTypes-1, TypeIndex+1, Rest...>;
 
@@ -279,19 +706,6 @@ namespace arrays
     static const size_t currentAlignment = AlignedType<First>::align;
     static_assert(is_power_of_two<currentAlignment>::value, "alignement needs to be power of two");
 
-    static void initArrayPointer(void** arrays, void* data, size_t numAllocated)
-    {
-      char** arr = (char**)arrays;
-
-      auto p = (std::uintptr_t)data;
-      p = p + (currentAlignment - (p % currentAlignment));
-      char*  d = (char*)p;
-
-      arr[TypeIndex] = d;
-
-      Next::initArrayPointer(arrays, &d[sizeof(CurrentType) * numAllocated], numAllocated);
-    }
-
     static void destructRange(void** arrays, size_t from, size_t num)
     {
       CurrentType* array = static_cast<CurrentType*>(arrays[TypeIndex]);
@@ -301,7 +715,7 @@ namespace arrays
     }
 
     template<typename FirstArg, typename... RestArgs>
-    static void constructAt(void** arrays, size_t index, FirstArg first, RestArgs ...rest)
+    static void constructAt(void** arrays, size_t index, FirstArg&& first, RestArgs&& ...rest)
     {
       CurrentType* data = static_cast<CurrentType*>(arrays[TypeIndex]);
 
@@ -310,6 +724,16 @@ namespace arrays
       Next::constructAt(arrays, index, std::forward<RestArgs>(rest)...);
     }
 
+    template<typename... FirstArgs, typename... RestTuples>
+    static void constructPiecewiseAt(void** arrays, size_t index, std::tuple<FirstArgs...>& first, RestTuples& ...rest)
+    {
+      CurrentType* data = static_cast<CurrentType*>(arrays[TypeIndex]);
+
+      constructFromTuple(&data[index], first, typename MakeIndexSequence<sizeof...(FirstArgs)>::Type());
+
+      Next::constructPiecewiseAt(arrays, index, rest...);
+    }
+
     static void moveRange(void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
     {
       CurrentType* src = static_cast<CurrentType*>(src_arrays[TypeIndex]);
@@ -320,6 +744,50 @@ namespace arrays
       Next::moveRange(src_arrays, src_from, dst_arrays, dst_from, num);
     }
 
+    //same as moveRange, but only for the arrays of the given group
+    static void moveGroupRange(size_t group, void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
+    {
+      if (ColumnGroup<First>::value == group)
+      {
+        CurrentType* src = static_cast<CurrentType*>(src_arrays[TypeIndex]);
+        CurrentType* dst = static_cast<CurrentType*>(dst_arrays[TypeIndex]);
+
+        moveData(&dst[dst_from], &src[src_from], num);
+      }
+
+      Next::moveGroupRange(group, src_arrays, src_from, dst_arrays, dst_from, num);
+    }
+
+    template<typename... RestArgs>
+    static void copyRange(void** arrays, size_t from, size_t num, const CurrentType* first, RestArgs... rest)
+    {
+      CurrentType* dst = static_cast<CurrentType*>(arrays[TypeIndex]);
+
+      copyData(&dst[from], first, num);
+
+      Next::copyRange(arrays, from, num, rest...);
+    }
+
+    static void copyArrays(void* const* src_arrays, void** dst_arrays, size_t num)
+    {
+      const CurrentType* src = static_cast<const CurrentType*>(src_arrays[TypeIndex]);
+      CurrentType* dst = static_cast<CurrentType*>(dst_arrays[TypeIndex]);
+
+      copyData(dst, src, num);
+
+      Next::copyArrays(src_arrays, dst_arrays, num);
+    }
+
+    static void gatherArrays(void** src_arrays, void** dst_arrays, const size_t* indices, size_t num)
+    {
+      CurrentType* src = static_cast<CurrentType*>(src_arrays[TypeIndex]);
+      CurrentType* dst = static_cast<CurrentType*>(dst_arrays[TypeIndex]);
+
+      gatherData(dst, src, indices, num);
+
+      Next::gatherArrays(src_arrays, dst_arrays, indices, num);
+    }
+
     static void swap(void** arrays, size_t a, size_t b)
     {
       CurrentType* array = static_cast<CurrentType*>(arrays[TypeIndex]);
@@ -334,6 +802,111 @@ namespace arrays
       Next::swap(arrays, a, b);
     }
   };
+
+  inline bool bitFromTuple(std::tuple<>&)
+  {
+    return false;
+  }
+
+  template<typename TArg>
+  bool bitFromTuple(std::tuple<TArg>& args)
+  {
+    return std::forward<TArg>(std::get<0>(args)) ? true : false;
+  }
+
+  /**
+   * bit arrays: row i is bit i of the array of 64 bit words (see bitarray::test)
+   */
+  template<size_t RemainingTypes, size_t TypeIndex, typename First, typename... Rest>
+  struct ForEachArray<true, RemainingTypes, TypeIndex, First, Rest...>
+  {
+    using Next = ForEach<RemainingTypes-1, TypeIndex+1, Rest...>;
+    using Word = std::uint64_t;
+
+    static void destructRange(void** arrays, size_t from, size_t num)
+    {
+      Next::destructRange(arrays, from, num);
+    }
+
+    template<typename FirstArg, typename... RestArgs>
+    static void constructAt(void** arrays, size_t index, FirstArg&& first, RestArgs&& ...rest)
+    {
+      bitarray::set(static_cast<Word*>(arrays[TypeIndex]), index, first ? true : false);
+
+      Next::constructAt(arrays, index, std::forward<RestArgs>(rest)...);
+    }
+
+    template<typename... FirstArgs, typename... RestTuples>
+    static void constructPiecewiseAt(void** arrays, size_t index, std::tuple<FirstArgs...>& first, RestTuples& ...rest)
+    {
+      static_assert(sizeof...(FirstArgs) <= 1, "bit arrays are constructed from at most one argument");
+      bitarray::set(static_cast<Word*>(arrays[TypeIndex]), index, bitFromTuple(first));
+
+      Next::constructPiecewiseAt(arrays, index, rest...);
+    }
+
+    static void moveRange(void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
+    {
+      bitarray::move(static_cast<Word*>(dst_arrays[TypeIndex]), dst_from, static_cast<const Word*>(src_arrays[TypeIndex]), src_from, num);
+
+      Next::moveRange(src_arrays, src_from, dst_arrays, dst_from, num);
+    }
+
+    static void moveGroupRange(size_t group, void** src_arrays, size_t src_from, void** dst_arrays, size_t dst_from, size_t num)
+    {
+      if (ColumnGroup<First>::value == group)
+        bitarray::move(static_cast<Word*>(dst_arrays[TypeIndex]), dst_from, static_cast<const Word*>(src_arrays[TypeIndex]), src_from, num);
+
+      Next::moveGroupRange(group, src_arrays, src_from, dst_arrays, dst_from, num);
+    }
+
+    //the source is a packed bit array as well, starting at bit 0
+    template<typename... RestArgs>
+    static void copyRange(void** arrays, size_t from, size_t num, const Word* first, RestArgs... rest)
+    {
+      bitarray::move(static_cast<Word*>(arrays[TypeIndex]), from, first, 0, num);
+
+      Next::copyRange(arrays, from, num, rest...);
+    }
+
+    static void copyArrays(void* const* src_arrays, void** dst_arrays, size_t num)
+    {
+      if (num > 0)
+        memcpy(dst_arrays[TypeIndex], src_arrays[TypeIndex], bitarray::numWords(num) * sizeof(Word));
+
+      Next::copyArrays(src_arrays, dst_arrays, num);
+    }
+
+    static void gatherArrays(void** src_arrays, void** dst_arrays, const size_t* indices, size_t num)
+    {
+      const Word* src = static_cast<const Word*>(src_arrays[TypeIndex]);
+      Word* dst = static_cast<Word*>(dst_arrays[TypeIndex]);
+
+      for (size_t i = 0; i < num; i += bitarray::wordBits)
+      {
+        const size_t end = num - i < bitarray::wordBits ? num - i : bitarray::wordBits;
+
+        Word word = 0;
+        for (size_t k = 0; k < end; ++k)
+          word |= (Word)(bitarray::test(src, indices[i + k]) ? 1 : 0) << k;
+
+        dst[i / bitarray::wordBits] = word;
+      }
+
+      Next::gatherArrays(src_arrays, dst_arrays, indices, num);
+    }
+
+    static void swap(void** arrays, size_t a, size_t b)
+    {
+      Word* words = static_cast<Word*>(arrays[TypeIndex]);
+
+      const bool oa = bitarray::test(words, a);
+      bitarray::set(words, a, bitarray::test(words, b));
+      bitarray::set(words, b, oa);
+
+      Next::swap(arrays, a, b);
+    }
+  };
+}
 }
 }
-}
\ No newline at end of file
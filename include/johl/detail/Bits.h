@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace johl
+{
+namespace detail
+{
+namespace bitarray
+{
+  //packed bit arrays: bit i is bit (i % 64) of word (i / 64)
+  static const size_t wordBits = 64;
+
+  inline size_t numWords(size_t numBits)
+  {
+    return (numBits + wordBits - 1) / wordBits;
+  }
+
+  inline unsigned popcount(std::uint64_t x)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (unsigned)((x * 0x0101010101010101ull) >> 56);
+#endif
+  }
+
+  //number of trailing zero bits, x must not be zero
+  inline unsigned ctz(std::uint64_t x)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (unsigned)index;
+#else
+    unsigned n = 0;
+    for (; (x & 1) == 0; x >>= 1)
+      ++n;
+    return n;
+#endif
+  }
+
+  //mask of the lowest n bits (0 < n <= 64)
+  inline std::uint64_t lowMask(size_t n)
+  {
+    return n >= wordBits ? ~(std::uint64_t)0 : ((std::uint64_t)1 << n) - 1;
+  }
+
+  inline bool test(const std::uint64_t* words, size_t i)
+  {
+    return ((words[i / wordBits] >> (i % wordBits)) & 1) != 0;
+  }
+
+  inline void set(std::uint64_t* words, size_t i, bool value)
+  {
+    const std::uint64_t bit = (std::uint64_t)1 << (i % wordBits);
+    std::uint64_t& word = words[i / wordBits];
+    word = value ? (word | bit) : (word & ~bit);
+  }
+
+  //n bits (0 < n <= 64) starting at bit pos
+  inline std::uint64_t read(const std::uint64_t* words, size_t pos, size_t n)
+  {
+    const size_t word = pos / wordBits;
+    const size_t shift = pos % wordBits;
+
+    std::uint64_t value = words[word] >> shift;
+    if (shift + n > wordBits)
+      value |= words[word + 1] << (wordBits - shift);
+
+    return value & lowMask(n);
+  }
+
+  //overwrites n bits (0 < n <= 64) starting at bit pos with the lowest n bits of value
+  inline void write(std::uint64_t* words, size_t pos, size_t n, std::uint64_t value)
+  {
+    const size_t word = pos / wordBits;
+    const size_t shift = pos % wordBits;
+    const std::uint64_t mask = lowMask(n);
+
+    value &= mask;
+    words[word] = (words[word] & ~(mask << shift)) | (value << shift);
+
+    if (shift + n > wordBits)
+    {
+      const std::uint64_t high = lowMask(shift + n - wordBits);
+      words[word + 1] = (words[word + 1] & ~high) | (value >> (wordBits - shift));
+    }
+  }
+
+  /**
+   * Copy num bits from src (starting at bit srcFrom) to dst (starting at bit
+   * dstFrom), 64 bits at a time. The ranges may overlap, the bits are copied
+   * front to back or back to front (like memmove).
+   */
+  inline void move(std::uint64_t* dst, size_t dstFrom, const std::uint64_t* src, size_t srcFrom, size_t num)
+  {
+    if (num == 0 || (dst == src && dstFrom == srcFrom))
+      return;
+
+    if (dst != src || dstFrom < srcFrom)
+    {
+      for (size_t i = 0; i < num; i += wordBits)
+      {
+        const size_t n = num - i < wordBits ? num - i : wordBits;
+        write(dst, dstFrom + i, n, read(src, srcFrom + i, n));
+      }
+    }
+    else
+    {
+      for (size_t i = num; i > 0;)
+      {
+        const size_t n = i < wordBits ? i : wordBits;
+        i -= n;
+        write(dst, dstFrom + i, n, read(src, srcFrom + i, n));
+      }
+    }
+  }
+
+  //number of set bits in [begin, end)
+  inline size_t count(const std::uint64_t* words, size_t begin, size_t end)
+  {
+    size_t n = 0;
+    for (size_t i = begin; i < end;)
+    {
+      const size_t bits = end - i < wordBits - i % wordBits ? end - i : wordBits - i % wordBits;
+      n += popcount(read(words, i, bits));
+      i += bits;
+    }
+    return n;
+  }
+
+  //calls fn(i) for each set bit i in [begin, end), in ascending order
+  template<typename TFunction>
+  void forEachSet(const std::uint64_t* words, size_t begin, size_t end, TFunction fn)
+  {
+    for (size_t i = begin; i < end;)
+    {
+      const size_t bits = end - i < wordBits - i % wordBits ? end - i : wordBits - i % wordBits;
+      std::uint64_t word = read(words, i, bits);
+      while (word)
+      {
+        fn(i + ctz(word));
+        word &= word - 1;
+      }
+      i += bits;
+    }
+  }
+}
+}
+}
@@ -0,0 +1,721 @@
+#pragma once
+
+#include <johl/detail/Arrays.h>
+#include <cstdint>
+#include <limits>
+
+//SIMD implementations are available for gcc and clang on x86, everything else
+//uses the scalar implementation
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define JOHL_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define JOHL_KERNELS_X86 0
+#endif
+
+namespace johl
+{
+namespace detail
+{
+namespace kernels
+{
+  /**
+   * Mask readers for the masked kernels: row r is active if mask(r) is true.
+   */
+  struct BoolMask
+  {
+    const bool* flags;
+
+    bool operator()(size_t row) const
+    {
+      return flags[row];
+    }
+  };
+
+  struct BitMask
+  {
+    const std::uint64_t* words;
+
+    bool operator()(size_t row) const
+    {
+      return ((words[row >> 6] >> (row & 63)) & 1) != 0;
+    }
+  };
+
+  /**
+   * Lane mask for TLanes consecutive floats starting at float index first
+   * (a multiple of TLanes): bit l is set if the row of float (first + l) is
+   * active. Rows are TWidth floats wide, TWidth == 0 means the width is only
+   * known at runtime (width).
+   */
+  template<size_t TWidth, size_t TLanes, typename TMask>
+  inline unsigned laneMask(const TMask& mask, size_t first, size_t width)
+  {
+    unsigned m = 0;
+
+    if (TWidth != 0 && TWidth >= TLanes)
+    {
+      //all lanes belong to the same row (TWidth is a multiple of TLanes)
+      m = mask(first / TWidth) ? (1u << TLanes) - 1 : 0u;
+    }
+    else if (TWidth != 0)
+    {
+      //TLanes / TWidth complete rows
+      const unsigned rowBits = (1u << TWidth) - 1;
+      const size_t row = first / TWidth;
+      for (size_t r = 0; r < TLanes / TWidth; ++r)
+        m |= (mask(row + r) ? rowBits : 0u) << (r * TWidth);
+    }
+    else
+    {
+      size_t row = first / width;
+      size_t offset = first % width;
+      for (size_t l = 0; l < TLanes; ++l)
+      {
+        m |= (mask(row) ? 1u : 0u) << l;
+        if (++offset == width)
+        {
+          offset = 0;
+          ++row;
+        }
+      }
+    }
+
+    return m;
+  }
+
+  //============================================================================
+  // scalar
+  //============================================================================
+
+  inline void axpyScalar(size_t n, float a, const float* x, float* y)
+  {
+    for (size_t i = 0; i < n; ++i)
+      y[i] += a * x[i];
+  }
+
+  inline void scaleScalar(size_t n, float a, float* x)
+  {
+    for (size_t i = 0; i < n; ++i)
+      x[i] *= a;
+  }
+
+  //float range [begin, end), used for the tails of the simd kernels
+  template<typename TMask>
+  void maskedAxpyTail(size_t begin, size_t end, size_t width, float a, const TMask& mask, const float* x, float* y)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (mask(i / width))
+        y[i] += a * x[i];
+    }
+  }
+
+  template<size_t TWidth, typename TMask>
+  void maskedAxpyScalar(size_t n, size_t width, float a, const TMask& mask, const float* x, float* y)
+  {
+    const size_t w = TWidth != 0 ? TWidth : width;
+    const size_t rows = n / w;
+
+    for (size_t r = 0; r < rows; ++r)
+    {
+      if (mask(r))
+      {
+        for (size_t k = 0; k < w; ++k)
+          y[r * w + k] += a * x[r * w + k];
+      }
+    }
+  }
+
+#if JOHL_KERNELS_X86
+
+  //============================================================================
+  // SSE2 (4 floats), always available on x86-64
+  //============================================================================
+
+  template<bool Aligned>
+  inline __m128 loadSse(const float* p)
+  {
+    return Aligned ? _mm_load_ps(p) : _mm_loadu_ps(p);
+  }
+
+  template<bool Aligned>
+  inline void storeSse(float* p, __m128 v)
+  {
+    if (Aligned)
+      _mm_store_ps(p, v);
+    else
+      _mm_storeu_ps(p, v);
+  }
+
+  template<bool Aligned>
+  void axpySse(size_t n, float a, const float* x, float* y)
+  {
+    const __m128 va = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+      storeSse<Aligned>(&y[i], _mm_add_ps(loadSse<Aligned>(&y[i]), _mm_mul_ps(va, loadSse<Aligned>(&x[i]))));
+
+    axpyScalar(n - i, a, &x[i], &y[i]);
+  }
+
+  template<bool Aligned>
+  void scaleSse(size_t n, float a, float* x)
+  {
+    const __m128 va = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+      storeSse<Aligned>(&x[i], _mm_mul_ps(va, loadSse<Aligned>(&x[i])));
+
+    scaleScalar(n - i, a, &x[i]);
+  }
+
+  template<size_t TWidth, bool Aligned, typename TMask>
+  void maskedAxpySse(size_t n, size_t width, float a, const TMask& mask, const float* x, float* y)
+  {
+    //SSE2 has no masked float store: partially active blocks are updated
+    //lane by lane, inactive rows are never written
+    const __m128 va = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      const unsigned m = laneMask<TWidth, 4>(mask, i, width);
+      if (m == 0xF)
+      {
+        storeSse<Aligned>(&y[i], _mm_add_ps(loadSse<Aligned>(&y[i]), _mm_mul_ps(va, loadSse<Aligned>(&x[i]))));
+      }
+      else if (m != 0)
+      {
+        for (size_t l = 0; l < 4; ++l)
+        {
+          if (m & (1u << l))
+            y[i + l] += a * x[i + l];
+        }
+      }
+    }
+
+    maskedAxpyTail(i, n, width, a, mask, x, y);
+  }
+
+  //============================================================================
+  // AVX2 (8 floats)
+  //============================================================================
+
+  template<bool Aligned>
+  __attribute__((target("avx2"))) inline __m256 loadAvx2(const float* p)
+  {
+    return Aligned ? _mm256_load_ps(p) : _mm256_loadu_ps(p);
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx2"))) inline void storeAvx2(float* p, __m256 v)
+  {
+    if (Aligned)
+      _mm256_store_ps(p, v);
+    else
+      _mm256_storeu_ps(p, v);
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx2"))) void axpyAvx2(size_t n, float a, const float* x, float* y)
+  {
+    const __m256 va = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      const __m256 y0 = _mm256_add_ps(loadAvx2<Aligned>(&y[i]), _mm256_mul_ps(va, loadAvx2<Aligned>(&x[i])));
+      const __m256 y1 = _mm256_add_ps(loadAvx2<Aligned>(&y[i + 8]), _mm256_mul_ps(va, loadAvx2<Aligned>(&x[i + 8])));
+      storeAvx2<Aligned>(&y[i], y0);
+      storeAvx2<Aligned>(&y[i + 8], y1);
+    }
+    for (; i + 8 <= n; i += 8)
+      storeAvx2<Aligned>(&y[i], _mm256_add_ps(loadAvx2<Aligned>(&y[i]), _mm256_mul_ps(va, loadAvx2<Aligned>(&x[i]))));
+
+    axpyScalar(n - i, a, &x[i], &y[i]);
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx2"))) void scaleAvx2(size_t n, float a, float* x)
+  {
+    const __m256 va = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+      storeAvx2<Aligned>(&x[i], _mm256_mul_ps(va, loadAvx2<Aligned>(&x[i])));
+
+    scaleScalar(n - i, a, &x[i]);
+  }
+
+  template<size_t TWidth, bool Aligned, typename TMask>
+  __attribute__((target("avx2"))) void maskedAxpyAvx2(size_t n, size_t width, float a, const TMask& mask, const float* x, float* y)
+  {
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      const unsigned m = laneMask<TWidth, 8>(mask, i, width);
+      const __m256i active = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)m), bits), bits);
+      const __m256 sum = _mm256_add_ps(loadAvx2<Aligned>(&y[i]), _mm256_mul_ps(va, loadAvx2<Aligned>(&x[i])));
+      _mm256_maskstore_ps(&y[i], active, sum); //inactive rows are not written
+    }
+
+    maskedAxpyTail(i, n, width, a, mask, x, y);
+  }
+
+  //============================================================================
+  // AVX-512 (16 floats)
+  //============================================================================
+
+  template<bool Aligned>
+  __attribute__((target("avx512f"))) inline __m512 loadAvx512(const float* p)
+  {
+    return Aligned ? _mm512_load_ps(p) : _mm512_loadu_ps(p);
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx512f"))) inline void storeAvx512(float* p, __m512 v)
+  {
+    if (Aligned)
+      _mm512_store_ps(p, v);
+    else
+      _mm512_storeu_ps(p, v);
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx512f"))) void axpyAvx512(size_t n, float a, const float* x, float* y)
+  {
+    const __m512 va = _mm512_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+      storeAvx512<Aligned>(&y[i], _mm512_add_ps(loadAvx512<Aligned>(&y[i]), _mm512_mul_ps(va, loadAvx512<Aligned>(&x[i]))));
+
+    //masked tail instead of a scalar loop
+    if (i < n)
+    {
+      const __mmask16 tail = (__mmask16)((1u << (n - i)) - 1);
+      const __m512 vx = _mm512_maskz_loadu_ps(tail, &x[i]);
+      const __m512 vy = _mm512_maskz_loadu_ps(tail, &y[i]);
+      _mm512_mask_storeu_ps(&y[i], tail, _mm512_add_ps(vy, _mm512_mul_ps(va, vx)));
+    }
+  }
+
+  template<bool Aligned>
+  __attribute__((target("avx512f"))) void scaleAvx512(size_t n, float a, float* x)
+  {
+    const __m512 va = _mm512_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+      storeAvx512<Aligned>(&x[i], _mm512_mul_ps(va, loadAvx512<Aligned>(&x[i])));
+
+    if (i < n)
+    {
+      const __mmask16 tail = (__mmask16)((1u << (n - i)) - 1);
+      _mm512_mask_storeu_ps(&x[i], tail, _mm512_mul_ps(va, _mm512_maskz_loadu_ps(tail, &x[i])));
+    }
+  }
+
+  template<size_t TWidth, bool Aligned, typename TMask>
+  __attribute__((target("avx512f"))) void maskedAxpyAvx512(size_t n, size_t width, float a, const TMask& mask, const float* x, float* y)
+  {
+    const __m512 va = _mm512_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      const __mmask16 m = (__mmask16)laneMask<TWidth, 16>(mask, i, width);
+      const __m512 vy = loadAvx512<Aligned>(&y[i]);
+      const __m512 vx = loadAvx512<Aligned>(&x[i]);
+      //the masked add is not contracted to an fma, the results match the other levels
+      _mm512_mask_storeu_ps(&y[i], m, _mm512_mask_add_ps(vy, m, vy, _mm512_mul_ps(va, vx))); //inactive rows are not written
+    }
+
+    maskedAxpyTail(i, n, width, a, mask, x, y);
+  }
+
+#endif
+
+  //============================================================================
+  // reductions over rows of 'width' floats: float i belongs to component
+  // i % width. The simd versions accumulate blocks of 16, 32 or 64 floats in
+  // four independent accumulators and fold the lanes into the components at
+  // the end, so width has to be a power of two <= 16.
+  //============================================================================
+
+  inline void foldSum(const float* lanes, size_t num, size_t width, float* out)
+  {
+    for (size_t j = 0; j < num; ++j)
+      out[j % width] += lanes[j];
+  }
+
+  inline void foldMinMax(const float* mins, const float* maxs, size_t num, size_t width, float* min, float* max)
+  {
+    for (size_t j = 0; j < num; ++j)
+    {
+      min[j % width] = mins[j] < min[j % width] ? mins[j] : min[j % width];
+      max[j % width] = maxs[j] > max[j % width] ? maxs[j] : max[j % width];
+    }
+  }
+
+  inline void sumScalar(size_t begin, size_t n, size_t width, const float* x, float* out)
+  {
+    for (size_t i = begin; i < n; ++i)
+      out[i % width] += x[i];
+  }
+
+  inline void minMaxScalar(size_t begin, size_t n, size_t width, const float* x, float* min, float* max)
+  {
+    foldMinMax(x + begin, x + begin, n - begin, width, min, max);
+  }
+
+#if JOHL_KERNELS_X86
+
+  inline void sumSse(size_t n, size_t width, const float* x, float* out)
+  {
+    __m128 acc[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      for (size_t k = 0; k < 4; ++k)
+        acc[k] = _mm_add_ps(acc[k], _mm_loadu_ps(&x[i + 4 * k]));
+    }
+
+    float lanes[16];
+    for (size_t k = 0; k < 4; ++k)
+      _mm_storeu_ps(&lanes[4 * k], acc[k]);
+
+    foldSum(lanes, 16, width, out);
+    sumScalar(i, n, width, x, out);
+  }
+
+  inline void minMaxSse(size_t n, size_t width, const float* x, float* min, float* max)
+  {
+    __m128 mins[4], maxs[4];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      mins[k] = _mm_set1_ps(std::numeric_limits<float>::infinity());
+      maxs[k] = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+      for (size_t k = 0; k < 4; ++k)
+      {
+        const __m128 v = _mm_loadu_ps(&x[i + 4 * k]);
+        mins[k] = _mm_min_ps(v, mins[k]); //returns the second operand for NaNs
+        maxs[k] = _mm_max_ps(v, maxs[k]);
+      }
+    }
+
+    float minLanes[16], maxLanes[16];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      _mm_storeu_ps(&minLanes[4 * k], mins[k]);
+      _mm_storeu_ps(&maxLanes[4 * k], maxs[k]);
+    }
+
+    foldMinMax(minLanes, maxLanes, 16, width, min, max);
+    minMaxScalar(i, n, width, x, min, max);
+  }
+
+  __attribute__((target("avx2"))) inline void sumAvx2(size_t n, size_t width, const float* x, float* out)
+  {
+    __m256 acc[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+      for (size_t k = 0; k < 4; ++k)
+        acc[k] = _mm256_add_ps(acc[k], _mm256_loadu_ps(&x[i + 8 * k]));
+    }
+
+    float lanes[32];
+    for (size_t k = 0; k < 4; ++k)
+      _mm256_storeu_ps(&lanes[8 * k], acc[k]);
+
+    foldSum(lanes, 32, width, out);
+    sumScalar(i, n, width, x, out);
+  }
+
+  __attribute__((target("avx2"))) inline void minMaxAvx2(size_t n, size_t width, const float* x, float* min, float* max)
+  {
+    __m256 mins[4], maxs[4];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      mins[k] = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+      maxs[k] = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+      for (size_t k = 0; k < 4; ++k)
+      {
+        const __m256 v = _mm256_loadu_ps(&x[i + 8 * k]);
+        mins[k] = _mm256_min_ps(v, mins[k]);
+        maxs[k] = _mm256_max_ps(v, maxs[k]);
+      }
+    }
+
+    float minLanes[32], maxLanes[32];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      _mm256_storeu_ps(&minLanes[8 * k], mins[k]);
+      _mm256_storeu_ps(&maxLanes[8 * k], maxs[k]);
+    }
+
+    foldMinMax(minLanes, maxLanes, 32, width, min, max);
+    minMaxScalar(i, n, width, x, min, max);
+  }
+
+  __attribute__((target("avx512f"))) inline void sumAvx512(size_t n, size_t width, const float* x, float* out)
+  {
+    __m512 acc[4] = { _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+      for (size_t k = 0; k < 4; ++k)
+        acc[k] = _mm512_add_ps(acc[k], _mm512_loadu_ps(&x[i + 16 * k]));
+    }
+
+    float lanes[64];
+    for (size_t k = 0; k < 4; ++k)
+      _mm512_storeu_ps(&lanes[16 * k], acc[k]);
+
+    foldSum(lanes, 64, width, out);
+    sumScalar(i, n, width, x, out);
+  }
+
+  __attribute__((target("avx512f"))) inline void minMaxAvx512(size_t n, size_t width, const float* x, float* min, float* max)
+  {
+    __m512 mins[4], maxs[4];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      mins[k] = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+      maxs[k] = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    //the masked forms (all lanes) merge into the accumulator itself, the
+    //unmasked ones merge into _mm512_undefined_ps(), which makes gcc warn
+    //about an uninitialized value (-Wmaybe-uninitialized)
+    const __mmask16 all = (__mmask16)0xFFFF;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+      for (size_t k = 0; k < 4; ++k)
+      {
+        const __m512 v = _mm512_loadu_ps(&x[i + 16 * k]);
+        mins[k] = _mm512_mask_min_ps(mins[k], all, v, mins[k]);
+        maxs[k] = _mm512_mask_max_ps(maxs[k], all, v, maxs[k]);
+      }
+    }
+
+    float minLanes[64], maxLanes[64];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      _mm512_storeu_ps(&minLanes[16 * k], mins[k]);
+      _mm512_storeu_ps(&maxLanes[16 * k], maxs[k]);
+    }
+
+    foldMinMax(minLanes, maxLanes, 64, width, min, max);
+    minMaxScalar(i, n, width, x, min, max);
+  }
+
+#endif
+
+  //============================================================================
+  // selection: indices of the rows with a set mask bit
+  //============================================================================
+
+  //indices of the set bits of a byte, one per byte (lowest set bit first)
+  constexpr std::uint64_t compressEntry(unsigned m, unsigned bit = 0, unsigned n = 0)
+  {
+    return bit == 8 ? 0 :
+      ((m >> bit) & 1) != 0 ? ((std::uint64_t)bit << (8 * n)) | compressEntry(m, bit + 1, n + 1) : compressEntry(m, bit + 1, n);
+  }
+
+  constexpr unsigned char countEntry(unsigned m)
+  {
+    return m == 0 ? 0 : (unsigned char)((m & 1) + countEntry(m >> 1));
+  }
+
+  template<typename TSequence>
+  struct CompressTable;
+
+  template<size_t... Indices>
+  struct CompressTable<IndexSequence<Indices...>> final
+  {
+    CompressTable() = delete;
+
+    static constexpr std::uint64_t indices[] = { compressEntry(Indices)... };
+    static constexpr unsigned char counts[] = { countEntry(Indices)... };
+  };
+
+  template<size_t... Indices>
+  constexpr std::uint64_t CompressTable<IndexSequence<Indices...>>::indices[];
+
+  template<size_t... Indices>
+  constexpr unsigned char CompressTable<IndexSequence<Indices...>>::counts[];
+
+  using Compress = CompressTable<MakeIndexSequence<256>::Type>;
+
+  /**
+   * Mask readers for select: bit b of rows(row, n) is set if row + b is
+   * selected (n <= 64 rows).
+   */
+  struct BoolRows
+  {
+    const bool* flags;
+
+    std::uint64_t operator()(size_t row, size_t n) const
+    {
+      std::uint64_t m = 0;
+#if JOHL_KERNELS_X86
+      if (n == 64)
+      {
+        const __m128i zero = _mm_setzero_si128();
+        for (unsigned b = 0; b < 64; b += 16)
+        {
+          const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + row + b));
+          m |= (std::uint64_t)(~_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) & 0xFFFF) << b;
+        }
+        return m;
+      }
+#endif
+      for (size_t b = 0; b < n; ++b)
+        m |= (std::uint64_t)(flags[row + b] ? 1 : 0) << b;
+      return m;
+    }
+  };
+
+  struct BitRows
+  {
+    const std::uint64_t* words;
+
+    std::uint64_t operator()(size_t row, size_t n) const
+    {
+      return johl::detail::bitarray::read(words, row, n);
+    }
+  };
+
+  //appends row + b for each set bit b of m without branches, returns the new count
+  inline size_t compressScalar(std::uint64_t m, size_t row, std::uint32_t* out, size_t n)
+  {
+    for (unsigned b = 0; b < 64; ++b)
+    {
+      out[n] = (std::uint32_t)(row + b);
+      n += (size_t)((m >> b) & 1);
+    }
+    return n;
+  }
+
+  //indices the select functions may write behind the last selected row
+  static const size_t selectPadding = 16;
+
+  /**
+   * Writes the indices of the selected rows in [begin, end) to out and
+   * returns their number n. Blocks of 64 rows without a selected row are
+   * skipped. Every write goes to out[n + k] with the count n so far: the
+   * scalar version writes one index (k = 0), the simd versions a whole
+   * vector (k < 8 or 16). n never exceeds end - begin, so out needs room
+   * for (end - begin) + selectPadding indices.
+   */
+  template<typename TRows>
+  size_t selectScalar(const TRows& rows, size_t begin, size_t end, std::uint32_t* out)
+  {
+    size_t n = 0;
+    for (size_t row = begin; row < end; row += 64)
+    {
+      const std::uint64_t m = rows(row, end - row < 64 ? end - row : 64);
+      if (m != 0)
+        n = compressScalar(m, row, out, n);
+    }
+    return n;
+  }
+
+#if JOHL_KERNELS_X86
+
+  //8 rows per step: the table holds the lane indices of each byte of the mask
+  inline size_t compressSse(std::uint64_t m, size_t row, std::uint32_t* out, size_t n)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    for (unsigned b = 0; b < 64; b += 8)
+    {
+      const unsigned byte = (unsigned)(m >> b) & 0xFF;
+      const __m128i base = _mm_set1_epi32((int)(row + b));
+      const __m128i lanes = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&Compress::indices[byte])), zero);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm_add_epi32(base, _mm_unpacklo_epi16(lanes, zero)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 4), _mm_add_epi32(base, _mm_unpackhi_epi16(lanes, zero)));
+      n += Compress::counts[byte];
+    }
+    return n;
+  }
+
+  template<typename TRows>
+  size_t selectSse(const TRows& rows, size_t begin, size_t end, std::uint32_t* out)
+  {
+    size_t n = 0;
+    for (size_t row = begin; row < end; row += 64)
+    {
+      const std::uint64_t m = rows(row, end - row < 64 ? end - row : 64);
+      if (m != 0)
+        n = compressSse(m, row, out, n);
+    }
+    return n;
+  }
+
+  __attribute__((target("avx2"))) inline size_t compressAvx2(std::uint64_t m, size_t row, std::uint32_t* out, size_t n)
+  {
+    for (unsigned b = 0; b < 64; b += 8)
+    {
+      const unsigned byte = (unsigned)(m >> b) & 0xFF;
+      const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&Compress::indices[byte])));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), _mm256_add_epi32(_mm256_set1_epi32((int)(row + b)), lanes));
+      n += Compress::counts[byte];
+    }
+    return n;
+  }
+
+  template<typename TRows>
+  __attribute__((target("avx2"))) size_t selectAvx2(const TRows& rows, size_t begin, size_t end, std::uint32_t* out)
+  {
+    size_t n = 0;
+    for (size_t row = begin; row < end; row += 64)
+    {
+      const std::uint64_t m = rows(row, end - row < 64 ? end - row : 64);
+      if (m != 0)
+        n = compressAvx2(m, row, out, n);
+    }
+    return n;
+  }
+
+  //16 rows per step with the compress instruction (register form, the
+  //memory form is slow on some cpus)
+  __attribute__((target("avx512f"))) inline size_t compressAvx512(std::uint64_t m, size_t row, std::uint32_t* out, size_t n)
+  {
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    for (unsigned b = 0; b < 64; b += 16)
+    {
+      const unsigned bits = (unsigned)(m >> b) & 0xFFFF;
+      const __m512i indices = _mm512_add_epi32(_mm512_set1_epi32((int)(row + b)), lanes);
+      _mm512_storeu_si512(out + n, _mm512_maskz_compress_epi32((__mmask16)bits, indices));
+      n += Compress::counts[bits & 0xFF] + Compress::counts[bits >> 8];
+    }
+    return n;
+  }
+
+  template<typename TRows>
+  __attribute__((target("avx512f"))) size_t selectAvx512(const TRows& rows, size_t begin, size_t end, std::uint32_t* out)
+  {
+    size_t n = 0;
+    for (size_t row = begin; row < end; row += 64)
+    {
+      const std::uint64_t m = rows(row, end - row < 64 ? end - row : 64);
+      if (m != 0)
+        n = compressAvx512(m, row, out, n);
+    }
+    return n;
+  }
+
+#endif
+}
+}
+}
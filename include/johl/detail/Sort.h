@@ -0,0 +1,180 @@
+#pragma once
+
+#include <johl/Allocator.h>
+#include <johl/detail/Arrays.h>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <limits>
+
+namespace johl
+{
+namespace detail
+{
+namespace sort
+{
+  /**
+   * Maps a key to an unsigned integer with the same ordering, so it can be
+   * sorted with a radix sort (RadixKey::enabled).
+   * Only integral (except bool) and floating point types are supported.
+   */
+  template<typename T, typename Enable = void>
+  struct RadixKey final
+  {
+    RadixKey() = delete;
+    static const bool enabled = false;
+  };
+
+  template<typename T>
+  struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> final
+  {
+    RadixKey() = delete;
+    static const bool enabled = true;
+
+    using Bits = typename std::make_unsigned<T>::type;
+
+    //flip the sign bit of signed types, so negative values come first
+    static const Bits flip = std::is_signed<T>::value ? (Bits)((Bits)1 << (sizeof(Bits) * 8 - 1)) : (Bits)0;
+
+    static Bits get(T value)
+    {
+      return (Bits)((Bits)value ^ flip);
+    }
+  };
+
+  template<typename TFloat, typename TBits>
+  struct FloatRadixKey
+  {
+    static_assert(sizeof(TFloat) == sizeof(TBits), "unexpected floating point size");
+    static_assert(std::numeric_limits<TFloat>::is_iec559, "floating point type is not IEEE 754");
+
+    static const bool enabled = true;
+
+    using Bits = TBits;
+
+    //negative values: flip all bits (reverses their order),
+    //positive values: flip the sign bit
+    static Bits get(TFloat value)
+    {
+      const Bits signBit = (Bits)1 << (sizeof(Bits) * 8 - 1);
+
+      Bits bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return (bits & signBit) ? (Bits)~bits : (Bits)(bits | signBit);
+    }
+  };
+
+  template<>
+  struct RadixKey<float> final : public FloatRadixKey<float, std::uint32_t>
+  {
+    RadixKey() = delete;
+  };
+
+  template<>
+  struct RadixKey<double> final : public FloatRadixKey<double, std::uint64_t>
+  {
+    RadixKey() = delete;
+  };
+
+  /**
+   * Sorts perm[0..num) (initially 0, 1, ..., num-1) by keys[perm[i]] in
+   * ascending order. LSD radix sort with 8 bits per pass, stable.
+   * Passes in which all keys share the same byte are skipped.
+   * Temporary buffers are allocated from allocator.
+   */
+  template<typename T>
+  void radixSort(const T* keys, size_t* perm, size_t num, Allocator* allocator)
+  {
+    using Key = RadixKey<T>;
+    using Bits = typename Key::Bits;
+    static const size_t numPasses = sizeof(Bits);
+
+    void* buffer = allocator->allocate((sizeof(Bits) * 2 + sizeof(size_t)) * num);
+    size_t* permB = static_cast<size_t*>(buffer);
+    Bits* keysA = reinterpret_cast<Bits*>(&permB[num]);
+    Bits* keysB = &keysA[num];
+    size_t* permA = perm;
+
+    //one histogram per byte, all computed in a single pass
+    size_t counts[numPasses][256];
+    memset(counts, 0, sizeof(counts));
+
+    for (size_t i = 0; i < num; ++i)
+    {
+      const Bits k = Key::get(keys[i]);
+      keysA[i] = k;
+      for (size_t pass = 0; pass < numPasses; ++pass)
+        ++counts[pass][(k >> (pass * 8)) & 0xFF];
+    }
+
+    for (size_t pass = 0; pass < numPasses; ++pass)
+    {
+      size_t* count = counts[pass];
+      const size_t shift = pass * 8;
+
+      if (count[(keysA[0] >> shift) & 0xFF] == num)
+        continue;
+
+      size_t offset = 0;
+      for (size_t b = 0; b < 256; ++b)
+      {
+        const size_t c = count[b];
+        count[b] = offset;
+        offset += c;
+      }
+
+      for (size_t i = 0; i < num; ++i)
+      {
+        const Bits k = keysA[i];
+        const size_t dst = count[(k >> shift) & 0xFF]++;
+        keysB[dst] = k;
+        permB[dst] = permA[i];
+      }
+
+      std::swap(keysA, keysB);
+      std::swap(permA, permB);
+    }
+
+    if (permA != perm)
+      memcpy(perm, permA, sizeof(size_t) * num);
+
+    allocator->deallocate(buffer);
+  }
+
+  /**
+   * Sorts perm[0..num) (initially 0, 1, ..., num-1) with a comparison sort,
+   * cmp compares two keys.
+   */
+  template<typename T, typename TCompare>
+  void compareSort(const T* keys, size_t* perm, size_t num, TCompare cmp, bool stable)
+  {
+    auto compareIndices = [=](size_t a, size_t b) { return cmp(keys[a], keys[b]); };
+
+    if (stable)
+      std::stable_sort(perm, perm + num, compareIndices);
+    else
+      std::sort(perm, perm + num, compareIndices);
+  }
+
+  /**
+   * Sorts perm by keys in ascending order.
+   * Uses radix sort for radix-sortable keys (always stable).
+   */
+  template<typename T>
+  typename std::enable_if<RadixKey<T>::enabled, void>::type
+    sortAscending(const T* keys, size_t* perm, size_t num, bool stable, Allocator* allocator)
+  {
+    unused(stable);
+    radixSort(keys, perm, num, allocator);
+  }
+
+  template<typename T>
+  typename std::enable_if<!RadixKey<T>::enabled, void>::type
+    sortAscending(const T* keys, size_t* perm, size_t num, bool stable, Allocator* allocator)
+  {
+    unused(allocator);
+    compareSort(keys, perm, num, std::less<T>(), stable);
+  }
+}
+}
+}
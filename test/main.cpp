@@ -1,9 +1,29 @@
 #include <johl/Arrays.h>
+#include <johl/Kernels.h>
+#include <johl/Allocators.h>
+#include <johl/MmapAllocator.h>
+#include <johl/ChunkedArrays.h>
+#include <johl/TiledArrays.h>
+#include <johl/HandleArrays.h>
+#include <johl/IndexedArrays.h>
+#include <johl/ArraysView.h>
+#include <johl/Select.h>
+#include <johl/Reduce.h>
+#include <johl/SearchIndex.h>
+#include <johl/SnapshotArrays.h>
+#include <johl/TrackedArrays.h>
 
 //std stuff
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
 
 //unit test framework
 #include <gtest/gtest.h>
@@ -28,10 +48,49 @@ static_assert(std::is_same<AlignedType<aligned<int, 8>>::Type, int>::value, "");
 static_assert(std::is_same<AlignedType<aligned<std::string, 16>>::Type, std::string>::value, "");
 static_assert(AlignedType<aligned<std::string, 16>>::align ==16, "");
 
-using johl::detail::SumAlignment;
-static_assert(SumAlignment<int, float, double>::value == 12, "");
-static_assert(SumAlignment<int>::value == 4, "");
-static_assert(SumAlignment<aligned<int,8>, aligned<float, 16>>::value == 24, "");
+static_assert(AlignedType<double>::align == alignof(double), "");
+static_assert(AlignedType<aligned<double, 2>>::align == alignof(double), "");
+
+using johl::ArraysLayout;
+static_assert(ArraysLayout<int, float, double>::bytesPerRow == 16, "");
+static_assert(ArraysLayout<int, float, double>::maxAlignment == alignof(double), "");
+static_assert(ArraysLayout<int, float, double>::arrayAt(0) == 2, "");
+static_assert(ArraysLayout<int, float, double>::arrayAt(1) == 0, "");
+static_assert(ArraysLayout<int, float, double>::arrayAt(2) == 1, "");
+static_assert(ArraysLayout<int, float, double>::position(2) == 0, "");
+static_assert(ArraysLayout<int, float, double>::offset(2, 10) == 0, "");
+static_assert(ArraysLayout<int, float, double>::offset(0, 10) == 80, "");
+static_assert(ArraysLayout<int, float, double>::offset(1, 10) == 120, "");
+static_assert(ArraysLayout<int, float, double>::bytes(10) == 160, "");
+static_assert(ArraysLayout<int, float, double>::padding(10) == 0, "");
+static_assert(ArraysLayout<char, aligned<char, 16>>::offset(1, 3) == 0, "");
+static_assert(ArraysLayout<char, aligned<char, 16>>::offset(0, 3) == 3, "");
+static_assert(ArraysLayout<aligned<int, 8>, aligned<float, 16>>::bytes(3) == 28, "");
+static_assert(ArraysLayout<aligned<int, 8>, aligned<float, 16>>::padding(3) == 4, "");
+
+using johl::cold;
+using johl::group;
+using johl::ArraysGroupLayout;
+static_assert(std::is_same<AlignedType<cold<aligned<float, 16>>>::Type, float>::value, "");
+static_assert(AlignedType<cold<aligned<float, 16>>>::align == 16, "");
+static_assert(johl::detail::NumGroups<int, cold<float>>::value == 2, "");
+static_assert(johl::detail::NumGroups<int, group<float, 3>>::value == 4, "");
+static_assert(ArraysLayout<int, cold<double>>::bytesPerRow == 12, "");
+static_assert(ArraysGroupLayout<0, int, cold<double>, float>::bytesPerRow == 8, "");
+static_assert(ArraysGroupLayout<0, int, cold<double>, float>::maxAlignment == alignof(int), "");
+static_assert(ArraysGroupLayout<0, int, cold<double>, float>::offset(2, 10) == 40, "");
+static_assert(ArraysGroupLayout<0, int, cold<double>, float>::bytes(10) == 80, "");
+static_assert(!ArraysGroupLayout<0, int, cold<double>, float>::contains(1), "");
+static_assert(ArraysGroupLayout<1, int, cold<double>, float>::bytes(10) == 80, "");
+static_assert(ArraysGroupLayout<1, int, cold<double>, float>::contains(1), "");
+
+static_assert(std::is_same<AlignedType<bits>::Type, std::uint64_t>::value, "");
+static_assert(ArraysLayout<int, bits, bits>::bytesPerRow == 4, "");
+static_assert(ArraysLayout<int, bits, bits>::bitsPerRow == 34, "");
+static_assert(ArraysLayout<int, bits, bits>::offset(0, 10) == 16, "");
+static_assert(ArraysLayout<int, bits, bits>::bytes(10) == 56, "");
+static_assert(ArraysLayout<int, bits, bits>::bytes(65) == 292, "");
+static_assert(ArraysGroupLayout<1, int, cold<bits>>::bytes(64) == 8, "");
 
 using johl::detail::SumSize;
 static_assert(SumSize<int>::value == sizeof(int), "");
@@ -238,9 +297,8 @@ TEST(ArraysTest, CustomAllocator)
     arrays.append(1, 1.1);
 
     ASSERT_EQ((size_t)1, allocator.allocations.size());
-    //default alignment = 4
-    //sizeof(int) + sizeof(double) + (2 * default alignment) = 12
-    ASSERT_EQ((size_t)20, allocator.allocations[0].size); 
+    //double array first, no padding: sizeof(int) + sizeof(double) = 12
+    ASSERT_EQ((size_t)12, allocator.allocations[0].size); 
   }
 
   ASSERT_EQ((size_t)0, allocator.allocations.size());
@@ -262,6 +320,2372 @@ TEST(ArraysTest, Alignment)
   ASSERT_EQ( (uintptr_t)bools % 16, (uintptr_t)0);
 }
 
+TEST(ArraysTest, Layout)
+{
+  TestAllocator allocator;
+
+  {
+    using TestArrays = Arrays<bool, aligned<float, 64>, double, short, std::string>;
+    using Layout = TestArrays::Layout;
+
+    TestArrays arrays(&allocator);
+    arrays.reserve(7);
+
+    ASSERT_EQ((size_t)1, allocator.allocations.size());
+    //TestAllocator uses the default implementation of allocateAligned 
+    EXPECT_EQ(Layout::bytes(7) + 64, allocator.allocations[0].size);
+
+    //placed by descending alignment: float, double, string, short, bool
+    EXPECT_EQ((size_t)1, Layout::arrayAt(0));
+    EXPECT_EQ((size_t)0, Layout::arrayAt(4));
+    EXPECT_EQ((size_t)0, (uintptr_t)arrays.data<1>() % 64);
+
+    const char* begin = (const char*)arrays.data<1>();
+    EXPECT_EQ(begin + Layout::offset(0, 7), (const char*)arrays.data<0>());
+    EXPECT_EQ(begin + Layout::offset(2, 7), (const char*)arrays.data<2>());
+    EXPECT_EQ(begin + Layout::offset(3, 7), (const char*)arrays.data<3>());
+    EXPECT_EQ(begin + Layout::offset(4, 7), (const char*)arrays.data<4>());
+
+    for (int i = 0; i < 7; ++i)
+      arrays.append(i % 2 == 0, (float)i, i * 0.5, (short)i, std::to_string(i));
+
+    for (size_t i = 0; i < 7; ++i)
+    {
+      EXPECT_EQ(i % 2 == 0, arrays.at<0>(i));
+      EXPECT_EQ((float)i, arrays.data<1>()[i]);
+      EXPECT_EQ(i * 0.5, arrays.at<2>(i));
+      EXPECT_EQ((short)i, arrays.at<3>(i));
+      EXPECT_EQ(std::to_string(i), arrays.at<4>(i));
+    }
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(ArraysTest, GrowthPolicies)
+{
+  EXPECT_EQ((size_t)1, exact_growth::capacity(0, 1));
+  EXPECT_EQ((size_t)11, exact_growth::capacity(10, 11));
+
+  EXPECT_EQ((size_t)16, block_growth<16>::capacity(0, 1));
+  EXPECT_EQ((size_t)32, block_growth<16>::capacity(16, 17));
+
+  EXPECT_EQ((size_t)1, geometric_growth<>::capacity(0, 1));
+  EXPECT_EQ((size_t)2, geometric_growth<>::capacity(1, 2));
+  EXPECT_EQ((size_t)15, geometric_growth<>::capacity(10, 11));
+  EXPECT_EQ((size_t)20, (geometric_growth<2, 1>::capacity(10, 11)));
+  EXPECT_EQ((size_t)100, (geometric_growth<2, 1>::capacity(10, 100)));
+
+  static_assert(std::is_same<Arrays<int>::GrowthPolicy, geometric_growth<>>::value, "");
+}
+
+TEST(ArraysTest, GrowthPolicyAppend)
+{
+  TestAllocator allocator;
+  BasicArrays<block_growth<16>, int, std::string> blocks(&allocator);
+  BasicArrays<exact_growth, int, std::string> exact;
+  Arrays<int, std::string> geometric;
+
+  for (int i = 0; i < 100; ++i)
+  {
+    blocks.append(i, std::to_string(i));
+    exact.append(i, std::to_string(i));
+    geometric.append(i, std::to_string(i));
+    EXPECT_EQ((size_t)(i + 1), exact.capacity());
+  }
+
+  EXPECT_EQ((size_t)100, blocks.size());
+  EXPECT_EQ((size_t)112, blocks.capacity());
+  EXPECT_EQ((size_t)1, allocator.allocations.size());
+
+  EXPECT_EQ((size_t)100, geometric.size());
+  EXPECT_GE(geometric.capacity(), (size_t)100);
+  EXPECT_LT(geometric.capacity(), (size_t)150);
+
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(i, blocks.at<0>(i));
+    EXPECT_EQ(std::to_string(i), blocks.at<1>(i));
+    EXPECT_EQ(i, geometric.at<0>(i));
+    EXPECT_EQ(std::to_string(i), geometric.at<1>(i));
+  }
+
+  //explicit reserve is always exact
+  geometric.reserve(1000);
+  EXPECT_EQ((size_t)1000, geometric.capacity());
+}
+
+TEST(ArraysTest, AppendRange)
+{
+  TestAllocator allocator;
+  Arrays<int, std::string, aligned<double, 16>> arrays(&allocator);
+
+  arrays.append(0, "zero", 0.0);
+
+  const int ints[] = { 1, 2, 3 };
+  const std::string strings[] = { "one", "two", "three" };
+  const double doubles[] = { 1.1, 2.2, 3.3 };
+
+  arrays.appendRange(3, ints, strings, doubles);
+  ASSERT_EQ((size_t)4, arrays.size());
+  ASSERT_EQ((size_t)1, allocator.allocations.size());
+
+  EXPECT_EQ(0, arrays.at<0>(0));
+  EXPECT_EQ("zero", arrays.at<1>(0));
+  for (size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(ints[i], arrays.at<0>(i + 1));
+    EXPECT_EQ(strings[i], arrays.at<1>(i + 1));
+    EXPECT_DOUBLE_EQ(doubles[i], arrays.data<2>()[i + 1]);
+  }
+
+  arrays.appendRange(0, ints, strings, doubles);
+  EXPECT_EQ((size_t)4, arrays.size());
+}
+
+TEST(ArraysTest, InsertRange)
+{
+  Arrays<int, std::string> arrays;
+
+  arrays.append(0, "zero");
+  arrays.append(4, "four");
+
+  const int ints[] = { 1, 2, 3 };
+  const std::string strings[] = { "one", "two", "three" };
+
+  arrays.insertRange(1, 3, ints, strings);
+  arrays.insertRange(5, 1, ints, strings);
+  arrays.insertRange(0, 1, &ints[2], &strings[2]);
+
+  const int expectedInts[] = { 3, 0, 1, 2, 3, 4, 1 };
+  const char* expectedStrings[] = { "three", "zero", "one", "two", "three", "four", "one" };
+
+  ASSERT_EQ((size_t)7, arrays.size());
+  for (size_t i = 0; i < 7; ++i)
+  {
+    EXPECT_EQ(expectedInts[i], arrays.at<0>(i));
+    EXPECT_EQ(expectedStrings[i], arrays.at<1>(i));
+  }
+}
+
+namespace
+{
+  //counts how often instances are copied and moved
+  struct Counted
+  {
+    static int copies;
+    static int moves;
+
+    static void reset()
+    {
+      copies = 0;
+      moves = 0;
+    }
+
+    explicit Counted(int v = 0, const std::string& s = std::string())
+      : value(v)
+      , text(s)
+    {}
+
+    Counted(const Counted& c)
+      : value(c.value)
+      , text(c.text)
+    {
+      ++copies;
+    }
+
+    Counted(Counted&& c)
+      : value(c.value)
+      , text(std::move(c.text))
+    {
+      ++moves;
+    }
+
+    Counted& operator=(const Counted& c)
+    {
+      value = c.value;
+      text = c.text;
+      ++copies;
+      return *this;
+    }
+
+    Counted& operator=(Counted&& c)
+    {
+      value = c.value;
+      text = std::move(c.text);
+      ++moves;
+      return *this;
+    }
+
+    int value;
+    std::string text;
+  };
+
+  int Counted::copies = 0;
+  int Counted::moves = 0;
+}
+
+TEST(ArraysTest, EmplaceBack)
+{
+  Arrays<int, Counted> arrays;
+  arrays.reserve(10);
+
+  Counted c(1, "one");
+
+  Counted::reset();
+  arrays.emplaceBack(1, c);
+  EXPECT_EQ(1, Counted::copies);
+  EXPECT_EQ(0, Counted::moves);
+
+  Counted::reset();
+  arrays.emplaceBack(2, std::move(c));
+  EXPECT_EQ(0, Counted::copies);
+  EXPECT_EQ(1, Counted::moves);
+
+  Counted::reset();
+  arrays.emplaceBack(3, 3);
+  EXPECT_EQ(0, Counted::copies);
+  EXPECT_EQ(0, Counted::moves);
+
+  Counted::reset();
+  arrays.emplaceBack(std::piecewise_construct, std::forward_as_tuple(4), std::forward_as_tuple(4, "four"));
+  EXPECT_EQ(0, Counted::copies);
+  EXPECT_EQ(0, Counted::moves);
+
+  Counted::reset();
+  arrays.emplaceBack(std::piecewise_construct, std::make_tuple(5), std::make_tuple());
+  EXPECT_EQ(0, Counted::copies);
+  EXPECT_EQ(0, Counted::moves);
+
+  //append takes its arguments by value: one copy into the parameter, one move into the array
+  Counted::reset();
+  arrays.append(6, Counted(6));
+  EXPECT_EQ(0, Counted::copies);
+  EXPECT_EQ(1, Counted::moves);
+
+  Counted::reset();
+  arrays.append(7, arrays.at<1>(0));
+  EXPECT_EQ(1, Counted::copies);
+  EXPECT_EQ(1, Counted::moves);
+
+  ASSERT_EQ((size_t)7, arrays.size());
+  const int values[] = { 1, 1, 3, 4, 0, 6, 1 };
+  const char* texts[] = { "one", "one", "", "four", "", "", "one" };
+  for (size_t i = 0; i < arrays.size(); ++i)
+  {
+    EXPECT_EQ((int)i + 1, arrays.at<0>(i));
+    EXPECT_EQ(values[i], arrays.at<1>(i).value);
+    EXPECT_EQ(texts[i], arrays.at<1>(i).text);
+  }
+}
+
+TEST(ArraysTest, EmplaceAt)
+{
+  Arrays<int, Counted, std::unique_ptr<int>> arrays;
+  arrays.reserve(10);
+
+  arrays.emplaceBack(1, 1, std::unique_ptr<int>(new int(1)));
+  arrays.emplaceBack(3, 3, std::unique_ptr<int>(new int(3)));
+
+  Counted::reset();
+  arrays.emplaceAt(1, 2, 2, std::unique_ptr<int>(new int(2)));
+  arrays.emplaceAt(0, std::piecewise_construct, std::forward_as_tuple(0), std::forward_as_tuple(0, "zero"), std::forward_as_tuple(new int(0)));
+  arrays.emplaceAt(4, std::piecewise_construct, std::forward_as_tuple(4), std::forward_as_tuple(4), std::forward_as_tuple(new int(4)));
+  EXPECT_EQ(0, Counted::copies);
+
+  ASSERT_EQ((size_t)5, arrays.size());
+  for (size_t i = 0; i < arrays.size(); ++i)
+  {
+    EXPECT_EQ((int)i, arrays.at<0>(i));
+    EXPECT_EQ((int)i, arrays.at<1>(i).value);
+    EXPECT_EQ((int)i, *arrays.at<2>(i));
+  }
+  EXPECT_EQ("zero", arrays.at<1>(0).text);
+}
+
+namespace
+{
+  Arrays<int, std::string> createArrays(Allocator* allocator, int num)
+  {
+    Arrays<int, std::string> arrays(allocator);
+    for (int i = 0; i < num; ++i)
+      arrays.append(i, std::to_string(i));
+
+    return arrays;
+  }
+}
+
+TEST(ArraysTest, MoveConstruct)
+{
+  TestAllocator allocator;
+
+  {
+    Arrays<int, std::string> arrays = createArrays(&allocator, 3);
+    ASSERT_EQ((size_t)1, allocator.allocations.size());
+    const int* ints = arrays.data<0>();
+
+    Arrays<int, std::string> moved(std::move(arrays));
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_EQ((size_t)0, arrays.capacity());
+    EXPECT_EQ(nullptr, arrays.data<0>());
+    ASSERT_EQ((size_t)3, moved.size());
+    EXPECT_EQ(ints, moved.data<0>());
+    EXPECT_EQ("2", moved.at<1>(2));
+
+    //moved-from object keeps its allocator and is still usable
+    arrays.append(42, "42");
+    EXPECT_EQ((size_t)2, allocator.allocations.size());
+    EXPECT_EQ(42, arrays.at<0>(0));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+
+  std::vector<Arrays<int, std::string>> vector;
+  for (int i = 0; i < 10; ++i)
+    vector.push_back(createArrays(&allocator, i));
+
+  for (int i = 0; i < 10; ++i)
+  {
+    ASSERT_EQ((size_t)i, vector[i].size());
+    if (i > 0)
+    {
+      EXPECT_EQ(std::to_string(i - 1), vector[i].at<1>(i - 1));
+    }
+  }
+
+  vector.clear();
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(ArraysTest, MoveAssign)
+{
+  TestAllocator allocatorA;
+  TestAllocator allocatorB;
+
+  {
+    Arrays<int, std::string> a = createArrays(&allocatorA, 3);
+    Arrays<int, std::string> b = createArrays(&allocatorB, 5);
+
+    a = std::move(b);
+    //a's old memory was released, a now owns b's memory (and allocator)
+    EXPECT_EQ((size_t)0, allocatorA.allocations.size());
+    EXPECT_EQ((size_t)1, allocatorB.allocations.size());
+    ASSERT_EQ((size_t)5, a.size());
+    EXPECT_EQ("4", a.at<1>(4));
+    EXPECT_EQ((size_t)0, b.size());
+
+    a.append(5, "5");
+    EXPECT_EQ((size_t)0, allocatorA.allocations.size());
+    EXPECT_EQ((size_t)1, allocatorB.allocations.size());
+
+    //b keeps its allocator
+    b.append(0, "0");
+    EXPECT_EQ((size_t)2, allocatorB.allocations.size());
+  }
+
+  EXPECT_EQ((size_t)0, allocatorA.allocations.size());
+  EXPECT_EQ((size_t)0, allocatorB.allocations.size());
+}
+
+TEST(ArraysTest, Swap)
+{
+  TestAllocator allocatorA;
+  TestAllocator allocatorB;
+
+  {
+    Arrays<int, std::string> a = createArrays(&allocatorA, 3);
+    Arrays<int, std::string> b = createArrays(&allocatorB, 5);
+    const int* intsA = a.data<0>();
+    const int* intsB = b.data<0>();
+
+    swap(a, b);
+    EXPECT_EQ((size_t)5, a.size());
+    EXPECT_EQ((size_t)3, b.size());
+    EXPECT_EQ(intsB, a.data<0>());
+    EXPECT_EQ(intsA, b.data<0>());
+    EXPECT_EQ("4", a.at<1>(4));
+    EXPECT_EQ("2", b.at<1>(2));
+
+    //memory is released by the allocator that allocated it
+    a.reserve(100);
+    EXPECT_EQ((size_t)1, allocatorA.allocations.size());
+    EXPECT_EQ((size_t)1, allocatorB.allocations.size());
+    EXPECT_GE(allocatorB.allocations[0].size, 100 * (sizeof(int) + sizeof(std::string)));
+
+    a.swap(b);
+    EXPECT_EQ((size_t)3, a.size());
+    EXPECT_EQ((size_t)5, b.size());
+  }
+
+  EXPECT_EQ((size_t)0, allocatorA.allocations.size());
+  EXPECT_EQ((size_t)0, allocatorB.allocations.size());
+}
+
+TEST(ArraysTest, Copy)
+{
+  TestAllocator allocator;
+
+  {
+    Arrays<int, std::string, aligned<double, 16>> arrays(&allocator);
+    arrays.reserve(100);
+    for (int i = 0; i < 10; ++i)
+      arrays.append(i, std::to_string(i), i * 0.5);
+
+    Arrays<int, std::string, aligned<double, 16>> copy(arrays);
+    ASSERT_EQ((size_t)2, allocator.allocations.size());
+    //exactly one block for size() rows
+    EXPECT_EQ((size_t)10, copy.capacity());
+    EXPECT_EQ(allocator.allocations[0].size - 90 * (SumSize<int, std::string, double>::value), allocator.allocations[1].size);
+
+    ASSERT_EQ((size_t)10, copy.size());
+    for (size_t i = 0; i < 10; ++i)
+    {
+      EXPECT_EQ((int)i, copy.at<0>(i));
+      EXPECT_EQ(std::to_string(i), copy.at<1>(i));
+      EXPECT_DOUBLE_EQ(i * 0.5, copy.data<2>()[i]);
+    }
+    EXPECT_NE(arrays.data<1>(), copy.data<1>());
+
+    copy.at<1>(0) = "changed";
+    EXPECT_EQ("0", arrays.at<1>(0));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(ArraysTest, Clone)
+{
+  TestAllocator allocatorA;
+  TestAllocator allocatorB;
+
+  Arrays<int, std::string> arrays = createArrays(&allocatorA, 5);
+  {
+    Arrays<int, std::string> clone = arrays.clone(&allocatorB);
+    EXPECT_EQ((size_t)1, allocatorA.allocations.size());
+    EXPECT_EQ((size_t)1, allocatorB.allocations.size());
+    ASSERT_EQ((size_t)5, clone.size());
+    EXPECT_EQ("4", clone.at<1>(4));
+  }
+  EXPECT_EQ((size_t)0, allocatorB.allocations.size());
+
+  Arrays<int, std::string> empty(&allocatorB);
+  Arrays<int, std::string> emptyClone = empty.clone(&allocatorB);
+  EXPECT_EQ((size_t)0, emptyClone.size());
+  EXPECT_EQ((size_t)0, allocatorB.allocations.size());
+}
+
+TEST(ArraysTest, Assign)
+{
+  TestAllocator allocatorA;
+  TestAllocator allocatorB;
+
+  Arrays<int, std::string> a = createArrays(&allocatorA, 3);
+  Arrays<int, std::string> b = createArrays(&allocatorB, 8);
+  a.reserve(10);
+  const int* ints = a.data<0>();
+
+  //enough capacity: no allocation
+  a.assign(b);
+  EXPECT_EQ(ints, a.data<0>());
+  EXPECT_EQ((size_t)1, allocatorA.allocations.size());
+  EXPECT_EQ((size_t)10, a.capacity());
+  ASSERT_EQ((size_t)8, a.size());
+  EXPECT_EQ("7", a.at<1>(7));
+
+  //not enough capacity: exactly one new block from a's allocator
+  b.append(8, "8");
+  b.append(9, "9");
+  b.append(10, "10");
+  a = b;
+  EXPECT_EQ((size_t)1, allocatorA.allocations.size());
+  EXPECT_EQ((size_t)11, a.capacity());
+  ASSERT_EQ((size_t)11, a.size());
+  EXPECT_EQ("10", a.at<1>(10));
+
+  a.assign(a);
+  EXPECT_EQ((size_t)11, a.size());
+  EXPECT_EQ("10", a.at<1>(10));
+
+  a.assign(Arrays<int, std::string>());
+  EXPECT_EQ((size_t)0, a.size());
+  EXPECT_EQ((size_t)11, a.capacity());
+}
+
+TEST(ArraysTest, RemoveAtUnordered)
+{
+  Arrays<int, std::string> arrays = createArrays(Allocator::defaultAllocator(), 5);
+
+  arrays.removeAtUnordered(1);
+  arrays.removeAtUnordered(3);
+  arrays.removeAtUnordered(0);
+
+  ASSERT_EQ((size_t)2, arrays.size());
+  EXPECT_EQ(2, arrays.at<0>(0));
+  EXPECT_EQ("2", arrays.at<1>(0));
+  EXPECT_EQ(4, arrays.at<0>(1));
+  EXPECT_EQ("4", arrays.at<1>(1));
+
+  arrays.removeAtUnordered(1);
+  arrays.removeAtUnordered(0);
+  EXPECT_EQ((size_t)0, arrays.size());
+}
+
+TEST(ArraysTest, RemoveRange)
+{
+  Arrays<int, std::string> arrays = createArrays(Allocator::defaultAllocator(), 10);
+
+  arrays.removeRange(2, 3);
+  arrays.removeRange(5, 2);
+  arrays.removeRange(0, 0);
+  arrays.removeRange(5, 0);
+
+  const int expected[] = { 0, 1, 5, 6, 7 };
+  ASSERT_EQ((size_t)5, arrays.size());
+  for (size_t i = 0; i < arrays.size(); ++i)
+  {
+    EXPECT_EQ(expected[i], arrays.at<0>(i));
+    EXPECT_EQ(std::to_string(expected[i]), arrays.at<1>(i));
+  }
+
+  arrays.removeRange(0, 5);
+  EXPECT_EQ((size_t)0, arrays.size());
+}
+
+TEST(ArraysTest, RemoveIf)
+{
+  Arrays<int, std::string, bool> arrays;
+  for (int i = 0; i < 20; ++i)
+    arrays.append(i, std::to_string(i), i % 3 == 0 || (i > 10 && i < 15));
+
+  int calls = 0;
+  size_t removed = arrays.removeIf([&](size_t i) { 
+    ++calls;
+    return arrays.at<2>(i) && arrays.at<1>(i) != "12"; 
+  });
+
+  const int expected[] = { 1, 2, 4, 5, 7, 8, 10, 12, 16, 17, 19 };
+  const size_t num = sizeof(expected) / sizeof(expected[0]);
+  EXPECT_EQ(20, calls);
+  EXPECT_EQ(20 - num, removed);
+  ASSERT_EQ(num, arrays.size());
+  for (size_t i = 0; i < num; ++i)
+  {
+    EXPECT_EQ(expected[i], arrays.at<0>(i));
+    EXPECT_EQ(std::to_string(expected[i]), arrays.at<1>(i));
+  }
+
+  EXPECT_EQ((size_t)0, arrays.removeIf([](size_t) { return false; }));
+  EXPECT_EQ(num, arrays.size());
+  EXPECT_EQ(num, arrays.removeIf([](size_t) { return true; }));
+  EXPECT_EQ((size_t)0, arrays.size());
+  EXPECT_EQ((size_t)0, arrays.removeIf([](size_t) { return true; }));
+}
+
+using johl::detail::sort::RadixKey;
+static_assert(RadixKey<int>::enabled, "");
+static_assert(RadixKey<unsigned char>::enabled, "");
+static_assert(RadixKey<double>::enabled, "");
+static_assert(!RadixKey<bool>::enabled, "");
+static_assert(!RadixKey<std::string>::enabled, "");
+
+TEST(ArraysTest, RadixKey)
+{
+  EXPECT_LT(RadixKey<int>::get(-5), RadixKey<int>::get(-1));
+  EXPECT_LT(RadixKey<int>::get(-1), RadixKey<int>::get(0));
+  EXPECT_LT(RadixKey<int>::get(0), RadixKey<int>::get(7));
+  EXPECT_LT(RadixKey<float>::get(-2.5f), RadixKey<float>::get(-0.5f));
+  EXPECT_LT(RadixKey<float>::get(-0.5f), RadixKey<float>::get(0.0f));
+  EXPECT_LT(RadixKey<float>::get(0.0f), RadixKey<float>::get(0.25f));
+  EXPECT_LT(RadixKey<double>::get(1.0), RadixKey<double>::get(1e10));
+  EXPECT_LT(RadixKey<double>::get(-1e10), RadixKey<double>::get(-1.0));
+}
+
+TEST(ArraysTest, SortBy)
+{
+  Arrays<int, std::string, float> arrays;
+  const int ints[] = { 5, -3, 12, 0, -3, 1000000, 7, -200000 };
+  const size_t num = sizeof(ints) / sizeof(ints[0]);
+  for (size_t i = 0; i < num; ++i)
+    arrays.append(ints[i], std::to_string(ints[i]), -0.5f * ints[i]);
+
+  //radix sort
+  arrays.sortBy<0>();
+  ASSERT_EQ(num, arrays.size());
+  for (size_t i = 0; i < num; ++i)
+  {
+    EXPECT_EQ(std::to_string(arrays.at<0>(i)), arrays.at<1>(i));
+    EXPECT_FLOAT_EQ(-0.5f * arrays.at<0>(i), arrays.at<2>(i));
+    if (i > 0)
+    {
+      EXPECT_LE(arrays.at<0>(i - 1), arrays.at<0>(i));
+    }
+  }
+
+  //radix sort, float keys
+  arrays.sortBy<2>();
+  for (size_t i = 1; i < num; ++i)
+  {
+    EXPECT_LE(arrays.at<2>(i - 1), arrays.at<2>(i));
+    EXPECT_GE(arrays.at<0>(i - 1), arrays.at<0>(i));
+  }
+
+  //comparison sort, non-trivial keys
+  arrays.sortBy<1>();
+  for (size_t i = 1; i < num; ++i)
+  {
+    EXPECT_LE(arrays.at<1>(i - 1), arrays.at<1>(i));
+  }
+
+  //custom comparator
+  arrays.sortBy<0>([](int a, int b) { return a > b; });
+  for (size_t i = 0; i < num; ++i)
+  {
+    EXPECT_EQ(std::to_string(arrays.at<0>(i)), arrays.at<1>(i));
+    if (i > 0)
+    {
+      EXPECT_GE(arrays.at<0>(i - 1), arrays.at<0>(i));
+    }
+  }
+}
+
+TEST(ArraysTest, StableSortBy)
+{
+  Arrays<unsigned char, int, std::unique_ptr<int>> arrays;
+  for (int i = 0; i < 1000; ++i)
+    arrays.emplaceBack((unsigned char)((i * 7919) % 13), i, std::unique_ptr<int>(new int(i)));
+
+  arrays.stableSortBy<0>();
+  for (size_t i = 0; i < arrays.size(); ++i)
+  {
+    EXPECT_EQ(arrays.at<1>(i), *arrays.at<2>(i));
+    if (i > 0)
+    {
+      ASSERT_LE(arrays.at<0>(i - 1), arrays.at<0>(i));
+      if (arrays.at<0>(i - 1) == arrays.at<0>(i))
+      {
+        EXPECT_LT(arrays.at<1>(i - 1), arrays.at<1>(i));
+      }
+    }
+  }
+
+  arrays.stableSortBy<0>([](unsigned char a, unsigned char b) { return a % 2 < b % 2; });
+  for (size_t i = 1; i < arrays.size(); ++i)
+  {
+    ASSERT_LE(arrays.at<0>(i - 1) % 2, arrays.at<0>(i) % 2);
+    if (arrays.at<0>(i - 1) == arrays.at<0>(i))
+    {
+      EXPECT_LT(arrays.at<1>(i - 1), arrays.at<1>(i));
+    }
+  }
+
+  Arrays<int> empty;
+  empty.sortBy<0>();
+  empty.stableSortBy<0>([](int a, int b) { return a < b; });
+  EXPECT_EQ((size_t)0, empty.size());
+}
+
+TEST(ThreadPoolTest, ParallelFor)
+{
+  ThreadPool pool(4);
+  EXPECT_EQ((size_t)4, pool.size());
+
+  for (size_t num : { 0, 1, 3, 4, 5, 100, 10000 })
+  {
+    std::vector<std::atomic<int>> calls(num);
+    for (auto& c : calls)
+      c = 0;
+
+    pool.parallelFor(num, [&](size_t i) { ++calls[i]; });
+
+    for (size_t i = 0; i < num; ++i)
+    {
+      ASSERT_EQ(1, calls[i].load());
+    }
+  }
+}
+
+TEST(ThreadPoolTest, Nested)
+{
+  ThreadPool pool(3);
+  std::atomic<int> sum(0);
+
+  pool.parallelFor(10, [&](size_t i) {
+    pool.parallelFor(10, [&](size_t j) { sum += (int)(i * 10 + j); });
+  });
+
+  EXPECT_EQ(99 * 100 / 2, sum.load());
+
+  ThreadPool single(1);
+  sum = 0;
+  single.parallelFor(100, [&](size_t i) { sum += (int)i; });
+  EXPECT_EQ(99 * 100 / 2, sum.load());
+}
+
+TEST(ArraysTest, ParallelForEach)
+{
+  ThreadPool pool(4);
+  Arrays<bool, int, aligned<float, 16>, std::string> arrays;
+  const size_t num = 10000;
+  for (size_t i = 0; i < num; ++i)
+    arrays.append(i % 3 == 0, (int)i, 1.0f, std::to_string(i));
+
+  std::atomic<size_t> rows(0);
+  arrays.parallelForEach<0, 2, 1>(pool, [&](size_t begin, size_t end, const bool* active, float* values, const int* ints) {
+    EXPECT_EQ((size_t)0, begin % 64);
+    EXPECT_TRUE(end - begin == 128 || end == num);
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (active[i])
+        values[i] += ints[i];
+    }
+    rows += end - begin;
+  }, 100);
+
+  EXPECT_EQ(num, rows.load());
+  for (size_t i = 0; i < num; ++i)
+  {
+    EXPECT_FLOAT_EQ(i % 3 == 0 ? 1.0f + i : 1.0f, arrays.data<2>()[i]);
+  }
+
+  //default pool and grain size
+  rows = 0;
+  arrays.parallelForEach<3>([&](size_t begin, size_t end, std::string* strings) {
+    for (size_t i = begin; i < end; ++i)
+      strings[i] += "!";
+    rows += end - begin;
+  });
+  EXPECT_EQ(num, rows.load());
+  EXPECT_EQ("9999!", arrays.at<3>(num - 1));
+
+  Arrays<int> empty;
+  empty.parallelForEach<0>(pool, [&](size_t, size_t, int*) { FAIL(); });
+}
+
+namespace
+{
+  struct Float4
+  {
+    float x, y, z, w;
+  };
+}
+
+namespace johl
+{
+  template<>
+  struct is_float_vector<Float4> : std::true_type
+  {
+  };
+}
+
+namespace
+{
+
+  //runs f once for each available simd level
+  template<typename TFunction>
+  void forEachSimdLevel(TFunction f)
+  {
+    using kernels::SimdLevel;
+    const SimdLevel detected = kernels::detectSimdLevel();
+    for (int level = 0; level <= (int)detected; ++level)
+    {
+      kernels::setSimdLevel((SimdLevel)level);
+      ASSERT_EQ((SimdLevel)level, kernels::simdLevel());
+      f();
+    }
+    kernels::setSimdLevel(detected);
+  }
+
+  std::vector<float> testValues(size_t n, float offset)
+  {
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i)
+      v[i] = offset + (float)((i * 37) % 101) * 0.25f;
+    return v;
+  }
+}
+
+TEST(KernelsTest, Axpy)
+{
+  forEachSimdLevel([] {
+    for (size_t n : { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 64, 1001 })
+    {
+      //offset 1: unaligned pointers
+      for (size_t offset = 0; offset < 2; ++offset)
+      {
+        std::vector<float> x = testValues(n + offset, 1.0f);
+        std::vector<float> y = testValues(n + offset, -3.0f);
+        std::vector<float> expected = y;
+        for (size_t i = offset; i < n + offset; ++i)
+          expected[i] += 0.5f * x[i];
+
+        kernels::axpy(n, 0.5f, x.data() + offset, y.data() + offset);
+        ASSERT_EQ(expected, y);
+
+        for (size_t i = offset; i < n + offset; ++i)
+          expected[i] *= -2.0f;
+        kernels::scale(n, -2.0f, y.data() + offset);
+        ASSERT_EQ(expected, y);
+      }
+    }
+  });
+}
+
+TEST(KernelsTest, MaskedAxpy)
+{
+  forEachSimdLevel([] {
+    for (size_t width : { 1, 2, 3, 4, 8, 16, 20 })
+    {
+      for (size_t rows : { 0, 1, 5, 16, 63, 64, 65, 200 })
+      {
+        const size_t n = rows * width;
+        std::vector<float> x = testValues(n, 1.0f);
+        std::vector<float> y = testValues(n, 2.0f);
+        std::vector<float> bitsResult = y;
+        std::unique_ptr<bool[]> mask(new bool[rows + 1]);
+        std::vector<std::uint64_t> bits((rows + 63) / 64 + 1, 0);
+        std::vector<float> expected = y;
+
+        for (size_t r = 0; r < rows; ++r)
+        {
+          mask[r] = (r * 7) % 3 == 0;
+          if (mask[r])
+            bits[r / 64] |= (std::uint64_t)1 << (r % 64);
+
+          for (size_t k = 0; k < width; ++k)
+          {
+            if (mask[r])
+              expected[r * width + k] += 0.1f * x[r * width + k];
+            else if (r % 2 == 1)
+              y[r * width + k] = bitsResult[r * width + k] = expected[r * width + k] = -0.0f;
+          }
+        }
+
+        kernels::maskedAxpy(rows, width, 0.1f, mask.get(), x.data(), y.data());
+        ASSERT_EQ(expected, y) << "width " << width << " rows " << rows;
+
+        kernels::maskedAxpy(rows, width, 0.1f, bits.data(), x.data(), bitsResult.data());
+        ASSERT_EQ(expected, bitsResult) << "width " << width << " rows " << rows;
+
+        //inactive rows are not written, not even with +0.0
+        for (size_t i = 0; i < n; ++i)
+        {
+          ASSERT_EQ(std::signbit(expected[i]), std::signbit(y[i])) << "width " << width << " rows " << rows;
+          ASSERT_EQ(std::signbit(expected[i]), std::signbit(bitsResult[i])) << "width " << width << " rows " << rows;
+        }
+      }
+    }
+  });
+}
+
+TEST(KernelsTest, Arrays)
+{
+  forEachSimdLevel([] {
+    Arrays<bool, aligned<Float4, 64>, aligned<Float4, 64>, float, float> arrays;
+    for (int i = 0; i < 103; ++i)
+    {
+      const float f = (float)i;
+      arrays.append(i % 4 == 0, Float4{ f, f, f, f }, Float4{ 1.0f, 2.0f, 3.0f, 4.0f }, f, 1.0f);
+    }
+
+    kernels::maskedAxpy<1, 2, 0>(arrays, 0.5f);
+    kernels::axpy<3, 4>(arrays, 2.0f);
+    kernels::scale<4>(arrays, 3.0f);
+    kernels::map<4, 3>(arrays, [](float v) { return v * v; });
+
+    for (size_t i = 0; i < arrays.size(); ++i)
+    {
+      const float f = (float)i;
+      const Float4& p = arrays.data<1>()[i];
+      const bool active = i % 4 == 0;
+      EXPECT_EQ(active ? f + 0.5f : f, p.x);
+      EXPECT_EQ(active ? f + 1.0f : f, p.y);
+      EXPECT_EQ(active ? f + 1.5f : f, p.z);
+      EXPECT_EQ(active ? f + 2.0f : f, p.w);
+      EXPECT_EQ(f + 2.0f, arrays.at<3>(i));
+      EXPECT_EQ((f + 2.0f) * (f + 2.0f), arrays.at<4>(i));
+    }
+  });
+}
+
+TEST(AllocatorsTest, LinearArena)
+{
+  TestAllocator upstream;
+
+  {
+    LinearArenaAllocator arena(1024, &upstream);
+
+    void* a = arena.allocate(10);
+    void* b = arena.allocate(100);
+    ASSERT_EQ((size_t)1, upstream.allocations.size());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)a % alignof(std::max_align_t));
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)b % alignof(std::max_align_t));
+    EXPECT_LT(a, b);
+
+    //the most recent allocation is rolled back, others are ignored
+    arena.deallocate(b);
+    EXPECT_EQ(b, arena.allocate(50));
+    arena.deallocate(a);
+    EXPECT_NE(a, arena.allocate(10));
+
+    //larger than a block
+    void* large = arena.allocate(4992);
+    ASSERT_EQ((size_t)2, upstream.allocations.size());
+    EXPECT_EQ((size_t)(1024 + 4992), arena.capacity());
+    memset(large, 0, 4992);
+
+    //blocks are reused after reset
+    arena.reset();
+    EXPECT_EQ(a, arena.allocate(10));
+
+    {
+      Arrays<int, std::string> arrays(&arena);
+      for (int i = 0; i < 100; ++i)
+        arrays.append(i, std::to_string(i));
+
+      for (size_t i = 0; i < arrays.size(); ++i)
+        EXPECT_EQ(std::to_string(i), arrays.at<1>(i));
+    }
+
+    //blocks that are too small are replaced (except for the first one, that
+    //is the current block after reset)
+    arena.reset();
+    const size_t capacity = arena.capacity();
+    arena.allocate(capacity);
+    EXPECT_EQ((size_t)2, upstream.allocations.size());
+    EXPECT_EQ(1024 + capacity, arena.capacity());
+  }
+
+  EXPECT_EQ((size_t)0, upstream.allocations.size());
+}
+
+TEST(AllocatorsTest, AlignedAndSized)
+{
+  TestAllocator allocator;
+
+  void* a = allocator.allocateAligned(100, 256);
+  void* b = allocator.allocateAligned(100, 8);
+  EXPECT_EQ((uintptr_t)0, (uintptr_t)a % 256);
+  EXPECT_EQ((uintptr_t)0, (uintptr_t)b % 8);
+  memset(a, 1, 100);
+
+  EXPECT_FALSE(allocator.tryExpand(b, 100, 200, 8));
+  b = allocator.reallocate(b, 100, 200, 8);
+  memset(b, 2, 200);
+
+  a = allocator.reallocate(a, 100, 50, 256);
+  EXPECT_EQ((uintptr_t)0, (uintptr_t)a % 256);
+  EXPECT_EQ(1, ((const char*)a)[49]);
+
+  allocator.deallocateSized(a, 50, 256);
+  allocator.deallocateSized(b, 200, 8);
+  allocator.deallocateSized(nullptr, 0, 256);
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+
+  MallocAllocator mallocAllocator;
+  char* c = static_cast<char*>(mallocAllocator.reallocate(nullptr, 0, 10, 1));
+  memset(c, 3, 10);
+  c = static_cast<char*>(mallocAllocator.reallocate(c, 10, 100000, 1));
+  EXPECT_EQ(3, c[9]);
+  mallocAllocator.deallocateSized(c, 100000, 1);
+}
+
+TEST(AllocatorsTest, ReserveInPlace)
+{
+  TestAllocator upstream;
+
+  {
+    LinearArenaAllocator arena(1 << 16, &upstream);
+
+    void* p = arena.allocateAligned(100, 64);
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)p % 64);
+    EXPECT_TRUE(arena.tryExpand(p, 100, 1000, 64));
+    EXPECT_FALSE(arena.tryExpand(p, 1000, 1 << 17, 64));
+    arena.reset();
+
+    //trivial arrays: the block is expanded, the arrays are shifted inside of it
+    Arrays<char, aligned<int, 32>, double, short> arrays(&arena);
+    arrays.reserve(10);
+    for (int i = 0; i < 10; ++i)
+      arrays.append((char)i, i, i * 0.5, (short)-i);
+
+    const void* block = arrays.data<1>();
+    arrays.reserve(1000);
+    EXPECT_EQ((size_t)1000, arrays.capacity());
+    EXPECT_EQ(block, arrays.data<1>());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)arrays.data<1>() % 32);
+    for (int i = 10; i < 1000; ++i)
+      arrays.append((char)i, i, i * 0.5, (short)-i);
+
+    EXPECT_EQ(block, arrays.data<1>());
+    for (size_t i = 0; i < arrays.size(); ++i)
+    {
+      EXPECT_EQ((char)i, arrays.at<0>(i));
+      EXPECT_EQ((int)i, arrays.data<1>()[i]);
+      EXPECT_EQ(i * 0.5, arrays.at<2>(i));
+      EXPECT_EQ((short)-(int)i, arrays.at<3>(i));
+    }
+
+    //non-trivial arrays are moved to a new block
+    Arrays<int, std::string> strings(&arena);
+    strings.append(1, "1");
+    const void* stringBlock = strings.data<1>();
+    strings.reserve(100);
+    EXPECT_NE(stringBlock, strings.data<1>());
+    EXPECT_EQ("1", strings.at<1>(0));
+  }
+
+  {
+    //pool: grows in place up to the size of the size class
+    FreeListPoolAllocator pool(1 << 16, &upstream);
+    void* p = pool.allocate(40);
+    EXPECT_TRUE(pool.tryExpand(p, 40, 64, 16));
+    EXPECT_FALSE(pool.tryExpand(p, 64, 65, 16));
+    pool.deallocate(p);
+
+    Arrays<int, float> arrays(&pool);
+    arrays.append(1, 1.0f);
+    const int* block = arrays.data<0>();
+    arrays.append(2, 2.0f);
+    arrays.append(3, 3.0f);
+    EXPECT_EQ(block, arrays.data<0>());
+    EXPECT_EQ(3, arrays.at<0>(2));
+    EXPECT_EQ(2.0f, arrays.at<1>(1));
+  }
+
+  EXPECT_EQ((size_t)0, upstream.allocations.size());
+}
+
+TEST(AllocatorsTest, FreeListPool)
+{
+  TestAllocator upstream;
+
+  {
+    FreeListPoolAllocator pool(4096, &upstream);
+
+    void* a = pool.allocate(20);
+    void* b = pool.allocate(30);
+    void* c = pool.allocate(100);
+    //one slab per size class (32 and 128 bytes)
+    ASSERT_EQ((size_t)2, upstream.allocations.size());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)a % alignof(std::max_align_t));
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)c % alignof(std::max_align_t));
+    memset(a, 1, 20);
+    memset(b, 2, 30);
+    memset(c, 3, 100);
+
+    //freed blocks are reused by allocations of the same size class
+    pool.deallocate(b);
+    EXPECT_EQ(b, pool.allocate(32));
+    pool.deallocate(c);
+    EXPECT_EQ(c, pool.allocate(128));
+
+    //allocations larger than the largest size class go to upstream
+    void* large = pool.allocate(1 << 20);
+    ASSERT_EQ((size_t)3, upstream.allocations.size());
+    pool.deallocate(large);
+    EXPECT_EQ((size_t)2, upstream.allocations.size());
+    pool.deallocate(nullptr);
+
+    std::vector<Arrays<int, std::string>> tables;
+    for (int t = 0; t < 100; ++t)
+    {
+      tables.emplace_back(&pool);
+      for (int i = 0; i < t; ++i)
+        tables.back().append(i, std::to_string(i));
+    }
+    for (size_t t = 0; t < tables.size(); ++t)
+    {
+      ASSERT_EQ(t, tables[t].size());
+      for (size_t i = 0; i < t; ++i)
+        EXPECT_EQ(std::to_string(i), tables[t].at<1>(i));
+    }
+  }
+
+  EXPECT_EQ((size_t)0, upstream.allocations.size());
+}
+
+namespace
+{
+  //threadsafe allocator that counts live allocations
+  class CountingAllocator : public Allocator
+  {
+  public:
+    CountingAllocator()
+      : live(0)
+      , total(0)
+    {}
+
+    virtual void* allocate(size_t size) override
+    {
+      ++live;
+      ++total;
+      return ::malloc(size);
+    }
+
+    virtual void deallocate(void* p) override
+    {
+      if (p)
+        --live;
+      ::free(p);
+    }
+
+    std::atomic<int> live;
+    std::atomic<int> total;
+  };
+}
+
+TEST(AllocatorsTest, ThreadLocalCaching)
+{
+  CountingAllocator upstream;
+
+  {
+    ThreadLocalCachingAllocator allocator(&upstream, 4);
+
+    //freed blocks are cached and reused by the same thread
+    void* a = allocator.allocate(100);
+    allocator.deallocate(a);
+    EXPECT_EQ(a, allocator.allocate(120));
+    EXPECT_EQ(1, upstream.total.load());
+
+    //cache holds at most 4 blocks per size class
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10; ++i)
+      blocks.push_back(allocator.allocate(64));
+    for (void* p : blocks)
+      allocator.deallocate(p);
+    EXPECT_EQ(1 + 4, upstream.live.load());
+    allocator.deallocate(a);
+
+    //blocks can be passed between threads, caches of exited threads are released
+    std::vector<std::thread> threads;
+    std::vector<void*> shared(4, nullptr);
+    for (size_t t = 0; t < 4; ++t)
+    {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < 100; ++i)
+        {
+          Arrays<int, std::string> arrays(&allocator);
+          for (int j = 0; j < i; ++j)
+            arrays.append(j, std::to_string(j));
+        }
+        shared[t] = allocator.allocate(200);
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    for (void* p : shared)
+      allocator.deallocate(p);
+
+    //main thread cache only
+    EXPECT_LE(upstream.live.load(), 4 * (int)detail::allocators::numClasses);
+  }
+
+  EXPECT_EQ(0, upstream.live.load());
+}
+
+#if JOHL_HAS_MMAP_ALLOCATOR
+TEST(AllocatorsTest, Mmap)
+{
+  MmapAllocator allocator(1 << 24);
+
+  size_t allocatedSize = 0;
+  void* p = allocator.allocateAtLeast(100, 64, allocatedSize);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ((uintptr_t)0, (uintptr_t)p % 64);
+  EXPECT_GE(allocatedSize, (size_t)1 << 24);
+  EXPECT_TRUE(allocator.tryExpand(p, 100, allocatedSize, 64));
+  EXPECT_FALSE(allocator.tryExpand(p, 100, allocatedSize + 1, 64));
+
+  //decommitted pages read as zero
+  const size_t page = MmapAllocator::pageSize();
+  memset(p, 0xFF, 4 * page);
+  allocator.decommit(p, 4 * page);
+  EXPECT_EQ((char)0xFF, static_cast<char*>(p)[0]); //partial first page is kept
+  EXPECT_EQ((char)0, static_cast<char*>(p)[2 * page]);
+
+  //grows beyond the reserved range, contents are kept
+  static_cast<char*>(p)[0] = 42;
+  void* q = allocator.reallocate(p, allocatedSize, allocatedSize * 2, 64);
+  ASSERT_NE(nullptr, q);
+  EXPECT_EQ(42, static_cast<char*>(q)[0]);
+  EXPECT_TRUE(allocator.tryExpand(q, 100, allocatedSize * 2, 64));
+  allocator.deallocateSized(q, allocatedSize * 2, 64);
+
+  //arrays get the whole reserved range, appending never moves the rows
+  {
+    Arrays<int, aligned<double, 64>> arrays(&allocator);
+    arrays.append(0, 0.0);
+    EXPECT_GE(arrays.capacity(), ((size_t)1 << 24) / 16);
+
+    const void* ints = arrays.data<0>();
+    const void* doubles = arrays.data<1>();
+    const size_t capacity = arrays.capacity();
+    for (int i = 1; i < 100000; ++i)
+      arrays.append(i, i * 0.5);
+
+    EXPECT_EQ(ints, arrays.data<0>());
+    EXPECT_EQ(doubles, arrays.data<1>());
+    EXPECT_EQ(capacity, arrays.capacity());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)arrays.data<1>() % 64);
+    for (size_t i = 0; i < arrays.size(); ++i)
+    {
+      EXPECT_EQ((int)i, arrays.at<0>(i));
+      EXPECT_EQ(i * 0.5, arrays.data<1>()[i]);
+    }
+
+    //the memory of cleared rows is released, the capacity is kept
+    arrays.clear();
+    EXPECT_EQ(capacity, arrays.capacity());
+    EXPECT_EQ(0, static_cast<const int*>(ints)[50000]);
+
+    arrays.append(1, 1.0);
+    arrays.releaseUnused();
+    EXPECT_EQ(1, arrays.at<0>(0));
+    EXPECT_EQ(1.0, arrays.data<1>()[0]);
+  }
+
+  //address space that cannot be mapped
+  MmapAllocator huge((size_t)1 << 62);
+  EXPECT_THROW(huge.allocate(100), std::bad_alloc);
+  EXPECT_THROW(Arrays<int>(&huge).append(0), std::bad_alloc);
+}
+#endif
+
+using johl::detail::DefaultChunkRows;
+static_assert(DefaultChunkRows<4>::value == 16384, "");
+static_assert(DefaultChunkRows<12>::value == 4096, "");
+static_assert(DefaultChunkRows<4096>::value == 64, "");
+static_assert(ChunkedArrays<float, int>::chunkRows == 8192, "");
+
+TEST(ChunkedArraysTest, Append)
+{
+  TestAllocator allocator;
+
+  {
+    BasicChunkedArrays<4, int, std::string, aligned<float, 32>> arrays(&allocator);
+    EXPECT_EQ((size_t)0, arrays.numChunks());
+
+    arrays.append(0, std::string("0"), 0.0f);
+    const int* first = &arrays.at<0>(0);
+    const std::string* firstString = &arrays.at<1>(0);
+
+    for (int i = 1; i < 10; ++i)
+      arrays.emplaceBack(i, std::to_string(i), i * 0.5f);
+
+    //rows never move
+    EXPECT_EQ(first, &arrays.at<0>(0));
+    EXPECT_EQ(firstString, &arrays.at<1>(0));
+
+    EXPECT_EQ((size_t)10, arrays.size());
+    EXPECT_EQ((size_t)12, arrays.capacity());
+    EXPECT_EQ((size_t)3, arrays.numChunks());
+    EXPECT_EQ((size_t)4, arrays.chunkSize(0));
+    EXPECT_EQ((size_t)2, arrays.chunkSize(2));
+    EXPECT_EQ((size_t)3 + 1, allocator.allocations.size()); //chunks + chunk table
+
+    for (int i = 0; i < 10; ++i)
+    {
+      EXPECT_EQ(i, arrays.at<0>(i));
+      EXPECT_EQ(std::to_string(i), arrays.at<1>(i));
+      EXPECT_EQ(i * 0.5f, arrays.at<2>(i));
+    }
+
+    for (size_t chunk = 0; chunk < arrays.numChunks(); ++chunk)
+    {
+      EXPECT_EQ((uintptr_t)0, (uintptr_t)arrays.chunkData<2>(chunk) % 32);
+      EXPECT_EQ(arrays.chunkSize(chunk), arrays.chunkArray<0>(chunk).size());
+      EXPECT_EQ((int)(chunk * 4), arrays.chunkArray<0>(chunk)[0]);
+    }
+
+    //removeAtUnordered moves only the last row
+    arrays.removeAtUnordered(1);
+    EXPECT_EQ(9, arrays.at<0>(1));
+    EXPECT_EQ("9", arrays.at<1>(1));
+    arrays.removeLast();
+    EXPECT_EQ((size_t)8, arrays.size());
+    EXPECT_EQ(7, arrays.at<0>(7));
+
+    //copies
+    BasicChunkedArrays<4, int, std::string, aligned<float, 32>> copy(arrays);
+    EXPECT_EQ(arrays.size(), copy.size());
+    for (size_t i = 0; i < copy.size(); ++i)
+      EXPECT_EQ(arrays.at<1>(i), copy.at<1>(i));
+
+    //move
+    BasicChunkedArrays<4, int, std::string, aligned<float, 32>> moved(std::move(copy));
+    EXPECT_EQ((size_t)0, copy.size());
+    EXPECT_EQ((size_t)8, moved.size());
+    EXPECT_EQ("9", moved.at<1>(1));
+
+    //clear keeps the chunks, releaseUnused returns them
+    moved.clear();
+    EXPECT_EQ((size_t)8, moved.capacity());
+    moved.append(1, std::string("1"), 1.0f);
+    moved.releaseUnused();
+    EXPECT_EQ((size_t)4, moved.capacity());
+    EXPECT_EQ("1", moved.at<1>(0));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(ChunkedArraysTest, ForEachChunk)
+{
+  BasicChunkedArrays<64, bool, float, float> arrays;
+  for (int i = 0; i < 1000; ++i)
+    arrays.append(i % 2 == 0, 1.0f, (float)i);
+
+  //same loop as for BasicArrays::parallelForEach
+  auto update = [](size_t begin, size_t end, const bool* active, const float* velocity, float* position)
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (active[i])
+        position[i] += velocity[i];
+    }
+  };
+
+  size_t rows = 0;
+  arrays.forEachChunk<0, 1, 2>([&](size_t begin, size_t end, const bool* active, const float* velocity, float* position)
+  {
+    rows += end - begin;
+    update(begin, end, active, velocity, position);
+  });
+  EXPECT_EQ((size_t)1000, rows);
+
+  ThreadPool pool(4);
+  arrays.parallelForEach<0, 1, 2>(pool, update);
+
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 2 == 0 ? i + 2.0f : (float)i, arrays.at<2>(i));
+}
+
+static_assert(TiledArrays<8, float, int>::tileBytes == 64, "");
+static_assert(TiledArrays<4, char, aligned<float, 32>>::tileBytes == 32, "");
+static_assert(TiledArrays<16, double, char>::tileBytes == 144, "");
+
+TEST(TiledArraysTest, Append)
+{
+  TestAllocator allocator;
+
+  {
+    TiledArrays<4, char, float, aligned<double, 32>> arrays(&allocator);
+    for (int i = 0; i < 10; ++i)
+      arrays.append((char)i, i * 0.5f, i * 2.0);
+
+    EXPECT_EQ((size_t)10, arrays.size());
+    EXPECT_EQ((size_t)3, arrays.numTiles());
+    EXPECT_EQ((size_t)0, arrays.capacity() % 4);
+
+    //row i is element i % 4 of tile i / 4
+    using Tiled = TiledArrays<4, char, float, aligned<double, 32>>;
+    EXPECT_EQ((ptrdiff_t)sizeof(float), (char*)&arrays.at<1>(1) - (char*)&arrays.at<1>(0));
+    EXPECT_EQ((ptrdiff_t)Tiled::tileBytes, (char*)&arrays.at<1>(4) - (char*)&arrays.at<1>(0));
+    EXPECT_EQ((ptrdiff_t)Tiled::tileBytes, (char*)&arrays.at<2>(5) - (char*)&arrays.at<2>(1));
+
+    for (int i = 0; i < 10; ++i)
+    {
+      EXPECT_EQ((char)i, arrays.at<0>(i));
+      EXPECT_EQ(i * 0.5f, arrays.at<1>(i));
+      EXPECT_EQ(i * 2.0, arrays.at<2>(i));
+    }
+
+    size_t rows = 0;
+    size_t tiles = 0;
+    for (auto tile : arrays.tiles())
+    {
+      EXPECT_EQ((uintptr_t)0, (uintptr_t)tile.data<2>() % 32);
+      EXPECT_EQ((char)(tiles * 4), tile.data<0>()[0]);
+      rows += tile.size();
+      ++tiles;
+    }
+    EXPECT_EQ((size_t)10, rows);
+    EXPECT_EQ((size_t)3, tiles);
+
+    //same loop as for BasicArrays::parallelForEach
+    arrays.forEachTile<1, 2>([](size_t begin, size_t end, float* f, const double* d)
+    {
+      for (size_t i = begin; i < end; ++i)
+        f[i] += (float)d[i];
+    });
+    for (int i = 0; i < 10; ++i)
+      EXPECT_EQ(i * 2.5f, arrays.at<1>(i));
+
+    arrays.removeAtUnordered(2);
+    EXPECT_EQ((char)9, arrays.at<0>(2));
+    arrays.removeLast();
+    EXPECT_EQ((size_t)8, arrays.size());
+
+    Tiled copy(arrays);
+    for (size_t i = 0; i < copy.size(); ++i)
+      EXPECT_EQ(arrays.at<2>(i), copy.at<2>(i));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(TiledArraysTest, NonTrivial)
+{
+  TiledArrays<8, int, std::string> arrays;
+  for (int i = 0; i < 100; ++i)
+    arrays.emplaceBack(i, std::to_string(i));
+
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(i, arrays.at<0>(i));
+    EXPECT_EQ(std::to_string(i), arrays.at<1>(i));
+  }
+
+  TiledArrays<8, int, std::string> copy(arrays);
+  arrays.removeAtUnordered(0);
+  EXPECT_EQ("99", arrays.at<1>(0));
+  EXPECT_EQ("0", copy.at<1>(0));
+
+  TiledArrays<8, int, std::string> moved(std::move(copy));
+  EXPECT_EQ((size_t)100, moved.size());
+  EXPECT_EQ((size_t)0, copy.size());
+  EXPECT_EQ("42", moved.at<1>(42));
+}
+
+TEST(ArraysTest, ColumnGroups)
+{
+  using TestArrays = Arrays<int, cold<std::string>, aligned<float, 32>, group<short, 2>>;
+  static_assert(TestArrays::numGroups == 3, "");
+
+  TestAllocator allocator;
+  {
+    TestArrays arrays(&allocator);
+    for (int i = 0; i < 100; ++i)
+      arrays.append(i, std::to_string(i), i * 0.5f, (short)-i);
+
+    EXPECT_EQ((size_t)3, allocator.allocations.size());
+    EXPECT_GE(arrays.capacity(), (size_t)100);
+    for (size_t group = 0; group < TestArrays::numGroups; ++group)
+      EXPECT_GE(arrays.groupCapacity(group), arrays.capacity());
+
+    //the hot arrays are packed into their own block, no room for the others
+    const char* hot = reinterpret_cast<const char*>(arrays.data<2>());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)hot % 32);
+    EXPECT_EQ(hot + TestArrays::Layout::offset(0, arrays.groupCapacity(0)), reinterpret_cast<const char*>(arrays.data<0>()));
+    EXPECT_EQ(TestArrays::Layout::bytes(arrays.groupCapacity(0)), arrays.groupCapacity(0) * (sizeof(int) + sizeof(float)));
+
+    for (int i = 0; i < 100; ++i)
+    {
+      EXPECT_EQ(i, arrays.at<0>(i));
+      EXPECT_EQ(std::to_string(i), arrays.at<1>(i));
+      EXPECT_EQ(i * 0.5f, arrays.at<2>(i));
+      EXPECT_EQ((short)-i, arrays.at<3>(i));
+    }
+
+    arrays.sortBy<0>([](int a, int b) { return a > b; });
+    EXPECT_EQ(99, arrays.at<0>(0));
+    EXPECT_EQ("99", arrays.at<1>(0));
+    EXPECT_EQ((short)-99, arrays.at<3>(0));
+
+    arrays.removeAtUnordered(0);
+    EXPECT_EQ("0", arrays.at<1>(0));
+
+    TestArrays copy(arrays);
+    TestArrays moved(std::move(arrays));
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_EQ((size_t)99, moved.size());
+    EXPECT_EQ(copy.at<1>(42), moved.at<1>(42));
+    EXPECT_EQ(copy.at<3>(42), moved.at<3>(42));
+
+    moved.clear();
+    moved.releaseUnused();
+    EXPECT_EQ((size_t)0, moved.size());
+  }
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+
+  {
+    //only the trivially relocatable group grows in place
+    FreeListPoolAllocator pool(1 << 16, &allocator);
+    Arrays<int, cold<std::string>> arrays(&pool);
+    arrays.append(1, "1");
+
+    const int* hot = arrays.data<0>();
+    const std::string* strings = arrays.data<1>();
+    arrays.append(2, "2");
+    arrays.append(3, "3");
+    EXPECT_EQ(hot, arrays.data<0>());
+    EXPECT_NE(strings, arrays.data<1>());
+    EXPECT_EQ(3, arrays.at<0>(2));
+    EXPECT_EQ("1", arrays.at<1>(0));
+  }
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(ArraysTest, BitHelpers)
+{
+  std::uint64_t words[4] = {};
+  setBit(words, 3);
+  setBit(words, 63);
+  setBit(words, 64);
+  setBit(words, 200);
+  EXPECT_TRUE(testBit(words, 63));
+  EXPECT_TRUE(testBit(words, 64));
+  EXPECT_FALSE(testBit(words, 65));
+  EXPECT_EQ((std::uint64_t)1, words[1]);
+
+  EXPECT_EQ((size_t)4, countBits(words, 0, 256));
+  EXPECT_EQ((size_t)2, countBits(words, 4, 65));
+  EXPECT_EQ((size_t)1, countBits(words, 63, 64));
+  EXPECT_EQ((size_t)0, countBits(words, 65, 200));
+
+  std::vector<size_t> set;
+  forEachSetBit(words, 3, 201, [&](size_t i) { set.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{ 3, 63, 64, 200 }), set);
+
+  set.clear();
+  forEachSetBit(words, 4, 200, [&](size_t i) { set.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{ 63, 64 }), set);
+
+  setBit(words, 63, false);
+  EXPECT_FALSE(testBit(words, 63));
+  EXPECT_EQ((size_t)3, countBits(words, 0, 256));
+}
+
+TEST(ArraysTest, Bits)
+{
+  using TestArrays = Arrays<int, bits, std::string>;
+
+  TestAllocator allocator;
+  {
+    TestArrays arrays(&allocator);
+    for (int i = 0; i < 200; ++i)
+      arrays.append(i, i % 3 == 0, std::to_string(i));
+
+    EXPECT_EQ((size_t)200, arrays.size());
+    EXPECT_EQ((size_t)67, arrays.countBits<1>());
+    for (int i = 0; i < 200; ++i)
+      EXPECT_EQ(i % 3 == 0, arrays.testBit<1>(i));
+
+    std::vector<size_t> set;
+    arrays.forEachSetBit<1>([&](size_t i) { set.push_back(i); });
+    EXPECT_EQ((size_t)67, set.size());
+    EXPECT_EQ((size_t)198, set.back());
+
+    arrays.setBit<1>(1);
+    arrays.setBit<1>(0, false);
+    EXPECT_TRUE(arrays.testBit<1>(1));
+    EXPECT_FALSE(arrays.testBit<1>(0));
+
+    //removing and inserting shifts the bits of the following rows
+    arrays.removeAt(1);
+    EXPECT_EQ(2, arrays.at<0>(1));
+    for (size_t i = 1; i < arrays.size(); ++i)
+      EXPECT_EQ(arrays.at<0>(i) % 3 == 0, arrays.testBit<1>(i));
+
+    arrays.insertAt(1, -1, true, std::string("-1"));
+    EXPECT_TRUE(arrays.testBit<1>(1));
+    EXPECT_FALSE(arrays.testBit<1>(2));
+    EXPECT_TRUE(arrays.testBit<1>(3));
+
+    arrays.removeAtUnordered(0);
+    EXPECT_EQ(199, arrays.at<0>(0));
+    EXPECT_FALSE(arrays.testBit<1>(0));
+
+    arrays.swapAt(0, 3);
+    EXPECT_TRUE(arrays.testBit<1>(0));
+    EXPECT_FALSE(arrays.testBit<1>(3));
+    EXPECT_EQ("199", arrays.at<2>(3));
+
+    //bits follow the rows when sorting by another array
+    arrays.sortBy<0>();
+    for (size_t i = 0; i < arrays.size(); ++i)
+    {
+      const int value = arrays.at<0>(i);
+      EXPECT_EQ(value == -1 || (value != 0 && value % 3 == 0), arrays.testBit<1>(i));
+      EXPECT_EQ(std::to_string(value), arrays.at<2>(i));
+    }
+
+    const size_t count = arrays.countBits<1>();
+    arrays.removeIf([&](size_t i) { return !arrays.testBit<1>(i); });
+    EXPECT_EQ(count, arrays.size());
+    EXPECT_EQ(count, arrays.countBits<1>());
+
+    TestArrays copy(arrays);
+    EXPECT_EQ(count, copy.countBits<1>());
+    EXPECT_EQ(arrays.at<2>(5), copy.at<2>(5));
+  }
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+
+  {
+    //rows are appended from packed words
+    const int values[100] = {};
+    const std::string strings[100];
+    std::uint64_t words[2] = { 0xF0F0F0F0F0F0F0F0ull, 0xFull };
+
+    TestArrays arrays(&allocator);
+    arrays.append(1, true, "1");
+    arrays.appendRange(100, values, words, strings);
+    arrays.insertRange(1, 2, values, words, strings);
+    EXPECT_EQ((size_t)103, arrays.size());
+    EXPECT_EQ((size_t)1 + 36, arrays.countBits<1>());
+    EXPECT_TRUE(arrays.testBit<1>(0));
+    EXPECT_FALSE(arrays.testBit<1>(3));
+    EXPECT_TRUE(arrays.testBit<1>(7));
+    EXPECT_TRUE(arrays.testBit<1>(67));
+    EXPECT_FALSE(arrays.testBit<1>(102));
+
+    arrays.removeRange(0, 3);
+    EXPECT_EQ((size_t)36, arrays.countBits<1>());
+    EXPECT_EQ(0xF0u, (unsigned)(arrays.data<1>()[0] & 0xFF));
+
+    arrays.clear();
+    arrays.releaseUnused();
+  }
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+static_assert(sizeof(Handle) == 4, "");
+
+TEST(HandleArraysTest, CreateDestroy)
+{
+  TestAllocator allocator;
+
+  {
+    HandleArrays<int, std::string> arrays(&allocator);
+    EXPECT_FALSE(arrays.contains(Handle()));
+    EXPECT_TRUE(Handle().isNull());
+
+    std::vector<Handle> handles;
+    for (int i = 0; i < 100; ++i)
+      handles.push_back(arrays.create(i, std::to_string(i)));
+
+    EXPECT_EQ((size_t)100, arrays.size());
+    for (int i = 0; i < 100; ++i)
+    {
+      EXPECT_TRUE(arrays.contains(handles[i]));
+      EXPECT_EQ((size_t)i, arrays.indexOf(handles[i]));
+      EXPECT_EQ(handles[i], arrays.handleAt(i));
+      EXPECT_EQ(i, arrays.at<0>(handles[i]));
+    }
+
+    //swap-and-pop: rows move, handles stay valid
+    for (int i = 0; i < 100; i += 2)
+      arrays.destroy(handles[i]);
+
+    EXPECT_EQ((size_t)50, arrays.size());
+    for (int i = 0; i < 100; ++i)
+    {
+      EXPECT_EQ(i % 2 == 1, arrays.contains(handles[i]));
+      if (i % 2 == 1)
+      {
+        EXPECT_EQ(i, arrays.at<0>(handles[i]));
+        EXPECT_EQ(std::to_string(i), arrays.at<1>(handles[i]));
+        EXPECT_EQ(handles[i], arrays.handleAt(arrays.indexOf(handles[i])));
+      }
+    }
+
+    //rows stay dense
+    int sum = 0;
+    for (int value : arrays.array<0>())
+      sum += value;
+    EXPECT_EQ(2500, sum);
+
+    HandleArrays<int, std::string> copy(arrays);
+    HandleArrays<int, std::string> moved(std::move(arrays));
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_FALSE(arrays.contains(handles[1]));
+    EXPECT_EQ("1", moved.at<1>(handles[1]));
+    EXPECT_EQ("99", copy.at<1>(handles[99]));
+
+    moved.clear();
+    EXPECT_EQ((size_t)0, moved.size());
+    EXPECT_FALSE(moved.contains(handles[1]));
+
+    Handle h = moved.create(7, "7");
+    EXPECT_TRUE(moved.contains(h));
+    EXPECT_EQ("7", moved.at<1>(h));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(HandleArraysTest, Churn)
+{
+  HandleArrays<int> arrays;
+  std::vector<Handle> live;
+  std::vector<Handle> dead;
+
+  std::mt19937 generator(0);
+  for (int i = 0; i < 20000; ++i)
+  {
+    if (live.empty() || generator() % 3 != 0)
+    {
+      live.push_back(arrays.create(i));
+    }
+    else
+    {
+      const size_t k = generator() % live.size();
+      arrays.destroy(live[k]);
+      dead.push_back(live[k]);
+      live[k] = live.back();
+      live.pop_back();
+    }
+  }
+
+  //slots are only reused once more than minFreeSlots are free
+  EXPECT_EQ(live.size(), arrays.size());
+  EXPECT_LE(arrays.numSlots(), live.size() + HandleArrays<int>::minFreeSlots + 1);
+
+  for (Handle h : live)
+  {
+    ASSERT_TRUE(arrays.contains(h));
+    EXPECT_EQ(h, arrays.handleAt(arrays.indexOf(h)));
+  }
+
+  for (Handle h : dead)
+    EXPECT_FALSE(arrays.contains(h));
+}
+
+TEST(IndexedArraysTest, InsertRemove)
+{
+  TestAllocator allocator;
+
+  {
+    IndexedArrays<1, int, std::string> arrays(&allocator);
+    EXPECT_EQ((IndexedArrays<1, int, std::string>::npos), arrays.find<1>("0"));
+
+    for (int i = 0; i < 100; ++i)
+      EXPECT_TRUE(arrays.append(i, std::to_string(i)));
+
+    //keys are unique
+    EXPECT_FALSE(arrays.append(100, std::string("7")));
+    EXPECT_FALSE(arrays.insertAt(0, 100, std::string("7")));
+    EXPECT_EQ((size_t)100, arrays.size());
+    EXPECT_LE(arrays.size() * 2, arrays.numSlots());
+
+    for (int i = 0; i < 100; ++i)
+      EXPECT_EQ((size_t)i, arrays.find<1>(std::to_string(i)));
+    EXPECT_FALSE(arrays.contains("100"));
+
+    //the rows after index shift
+    EXPECT_TRUE(arrays.insertAt(10, -1, std::string("a")));
+    EXPECT_EQ((size_t)10, arrays.find<1>("a"));
+    EXPECT_EQ((size_t)11, arrays.find<1>("10"));
+    EXPECT_EQ((size_t)100, arrays.find<1>("99"));
+    EXPECT_EQ((size_t)9, arrays.find<1>("9"));
+
+    arrays.removeAt(0);
+    EXPECT_FALSE(arrays.contains("0"));
+    EXPECT_EQ((size_t)9, arrays.find<1>("a"));
+    EXPECT_EQ((size_t)99, arrays.find<1>("99"));
+
+    arrays.swapAt(0, 99);
+    EXPECT_EQ((size_t)0, arrays.find<1>("99"));
+    EXPECT_EQ((size_t)99, arrays.find<1>("1"));
+    EXPECT_EQ(1, arrays.at<0>(99));
+
+    arrays.removeAtUnordered(0);
+    EXPECT_FALSE(arrays.contains("99"));
+    EXPECT_EQ((size_t)0, arrays.find<1>("1"));
+    EXPECT_EQ((size_t)99, arrays.size());
+
+    for (size_t i = 0; i < arrays.size(); ++i)
+      EXPECT_EQ(i, arrays.find<1>(arrays.at<1>(i)));
+
+    IndexedArrays<1, int, std::string> copy(arrays);
+    IndexedArrays<1, int, std::string> moved(std::move(arrays));
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_FALSE(arrays.contains("1"));
+    EXPECT_EQ((size_t)0, moved.find<1>("1"));
+    EXPECT_EQ((size_t)9, copy.find<1>("a"));
+
+    EXPECT_TRUE(arrays.append(1, std::string("1")));
+    EXPECT_EQ((size_t)0, arrays.find<1>("1"));
+
+    moved.clear();
+    EXPECT_FALSE(moved.contains("1"));
+    EXPECT_TRUE(moved.append(1, std::string("1")));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(IndexedArraysTest, Churn)
+{
+  IndexedArrays<0, unsigned, int> arrays;
+  std::vector<unsigned> keys;
+
+  std::mt19937 generator(0);
+  for (int i = 0; i < 20000; ++i)
+  {
+    const unsigned op = generator() % 8;
+    if (keys.empty() || op < 3)
+    {
+      //small key range, so there are duplicates
+      const unsigned key = generator() % 4096;
+      const bool inserted = std::find(keys.begin(), keys.end(), key) == keys.end();
+      const size_t index = generator() % (keys.size() + 1);
+      EXPECT_EQ(inserted, op == 0 ? arrays.insertAt(index, key, i) : arrays.append(key, i));
+      if (inserted)
+        keys.insert(op == 0 ? keys.begin() + index : keys.end(), key);
+    }
+    else
+    {
+      const size_t index = generator() % keys.size();
+      if (op < 5)
+      {
+        arrays.removeAtUnordered(index);
+        keys[index] = keys.back();
+        keys.pop_back();
+      }
+      else if (op < 6)
+      {
+        arrays.removeAt(index);
+        keys.erase(keys.begin() + index);
+      }
+      else
+      {
+        const size_t other = generator() % keys.size();
+        arrays.swapAt(index, other);
+        std::swap(keys[index], keys[other]);
+      }
+    }
+  }
+
+  ASSERT_EQ(keys.size(), arrays.size());
+  for (size_t i = 0; i < keys.size(); ++i)
+  {
+    EXPECT_EQ(keys[i], arrays.at<0>(i));
+    EXPECT_EQ(i, arrays.find<0>(keys[i]));
+  }
+
+  for (unsigned key = 0; key < 4096; ++key)
+    EXPECT_EQ(std::find(keys.begin(), keys.end(), key) != keys.end(), arrays.contains(key));
+}
+
+TEST(SearchIndexTest, Bounds)
+{
+  //all tree shapes up to a few levels, with duplicate keys
+  for (int n = 0; n < 70; ++n)
+  {
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i)
+      keys.push_back(i / 3 * 2);
+
+    SearchIndex<int> index;
+    index.build(keys.data(), keys.size());
+    ASSERT_EQ(keys.size(), index.size());
+
+    for (int key = -1; key <= n; ++key)
+    {
+      const size_t first = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+      const size_t last = std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+      EXPECT_EQ(first, index.lowerBound(key));
+      EXPECT_EQ(last, index.upperBound(key));
+      EXPECT_EQ(std::make_pair(first, last), index.equalRange(key));
+    }
+  }
+}
+
+TEST(SearchIndexTest, Arrays)
+{
+  TestAllocator allocator;
+
+  {
+    Arrays<double, std::string> arrays(&allocator);
+    for (int i = 0; i < 1000; ++i)
+      arrays.append(i * 0.5, std::to_string(i));
+
+    SearchIndex<double> index(&allocator);
+    index.build<0>(arrays);
+    EXPECT_EQ((size_t)200, index.lowerBound(100.0));
+    EXPECT_EQ((size_t)201, index.lowerBound(100.1));
+    EXPECT_EQ((size_t)1000, index.lowerBound(500.0));
+    EXPECT_EQ("200", arrays.at<1>(index.lowerBound(100.0)));
+
+    //rebuild after appending more keys
+    for (int i = 1000; i < 5000; ++i)
+      arrays.append(i * 0.5, std::to_string(i));
+    index.build<0>(arrays);
+    EXPECT_EQ((size_t)5000, index.size());
+    EXPECT_EQ(std::make_pair((size_t)4000, (size_t)4001), index.equalRange(2000.0));
+    EXPECT_EQ(std::make_pair((size_t)0, (size_t)0), index.equalRange(-1.0));
+
+    index.clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ((size_t)0, index.lowerBound(1.0));
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(TrackedArraysTest, Dirty)
+{
+  TestAllocator allocator;
+
+  {
+    TrackedArrays<int, std::string> arrays(&allocator);
+    for (int i = 0; i < 100; ++i)
+      arrays.append(i, std::to_string(i));
+
+    //new rows are dirty
+    EXPECT_EQ((size_t)100, arrays.countDirty<0>());
+    EXPECT_EQ((size_t)100, arrays.countDirty<1>());
+
+    arrays.clearDirty();
+    EXPECT_EQ((size_t)0, arrays.countDirty<0>());
+    EXPECT_EQ((size_t)0, arrays.countDirty<1>());
+
+    //reads do not change anything
+    const std::uint64_t version = arrays.version();
+    const std::uint64_t version1 = arrays.version<1>();
+    const auto& constArrays = arrays;
+    EXPECT_EQ(10, constArrays.at<0>(10));
+    EXPECT_EQ(version, arrays.version());
+
+    arrays.at<0>(10) = -10;
+    arrays.markDirty<0>(70);
+    arrays.at<0>(70) += 1;
+    EXPECT_TRUE(arrays.isDirty<0>(10));
+    EXPECT_FALSE(arrays.isDirty<1>(10));
+    EXPECT_GT(arrays.version<0>(), version);
+    EXPECT_EQ(version1, arrays.version<1>());
+    EXPECT_EQ(arrays.version(), arrays.version<0>());
+
+    std::vector<size_t> dirty;
+    arrays.forEachDirty<0>([&](size_t i) { dirty.push_back(i); });
+    ASSERT_EQ((size_t)2, dirty.size());
+    EXPECT_EQ((size_t)10, dirty[0]);
+    EXPECT_EQ((size_t)70, dirty[1]);
+
+    //the flags move with the rows
+    arrays.removeAt(0);
+    EXPECT_TRUE(arrays.isDirty<0>(9));
+    EXPECT_TRUE(arrays.isDirty<0>(69));
+    EXPECT_EQ(arrays.version(), arrays.version<1>());
+
+    arrays.insertAt(5, 5, std::string("5"));
+    EXPECT_TRUE(arrays.isDirty<0>(5));
+    EXPECT_TRUE(arrays.isDirty<1>(5));
+    EXPECT_TRUE(arrays.isDirty<0>(10));
+    EXPECT_FALSE(arrays.isDirty<0>(9));
+
+    arrays.clearDirty<0>();
+    EXPECT_EQ((size_t)0, arrays.countDirty<0>());
+    EXPECT_EQ((size_t)1, arrays.countDirty<1>());
+
+    //inserting at the end
+    arrays.clearDirty();
+    arrays.insertAt(arrays.size(), 100, std::string("100"));
+    EXPECT_EQ((size_t)101, arrays.size());
+    EXPECT_EQ(100, arrays.at<0>(100));
+    EXPECT_TRUE(arrays.isDirty<0>(100));
+    EXPECT_TRUE(arrays.isDirty<1>(100));
+    EXPECT_EQ((size_t)1, arrays.countDirty<1>());
+
+    //the rows that received other elements are dirty
+    arrays.clearDirty();
+    arrays.swapAt(1, 2);
+    arrays.removeAtUnordered(3);
+    EXPECT_EQ((size_t)3, arrays.countDirty<1>());
+    EXPECT_TRUE(arrays.isDirty<1>(3));
+    EXPECT_EQ(100, arrays.at<0>(3));
+
+    arrays.clear();
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_EQ((size_t)0, arrays.countDirty<0>());
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+}
+
+TEST(TrackedArraysTest, Disabled)
+{
+  using TestArrays = BasicTrackedArrays<geometric_growth<>, false, int, float>;
+
+  //nothing is stored without tracking
+  static_assert(sizeof(TestArrays) == sizeof(Arrays<int, float>), "");
+
+  TestArrays arrays;
+  for (int i = 0; i < 10; ++i)
+    arrays.append(i, 0.0f);
+
+  arrays.clearDirty();
+  arrays.at<1>(3) = 1.0f;
+
+  //every row is dirty
+  size_t num = 0;
+  arrays.forEachDirty<1>([&](size_t i) { EXPECT_EQ(num++, i); });
+  EXPECT_EQ((size_t)10, num);
+  EXPECT_EQ((size_t)10, arrays.countDirty<0>());
+  EXPECT_TRUE(arrays.isDirty<0>(0));
+  EXPECT_EQ(~(std::uint64_t)0, arrays.version<0>());
+}
+
+TEST(SnapshotArraysTest, CopyOnWrite)
+{
+  using TestArrays = SnapshotArrays<int, aligned<float, 32>, std::string>;
+
+  TestAllocator allocator;
+
+  {
+    TestArrays arrays(&allocator);
+    for (int i = 0; i < 100; ++i)
+      arrays.append(i, i * 0.5f, std::to_string(i));
+
+    EXPECT_FALSE(arrays.isShared<0>());
+    const int* ints = arrays.data<0>();
+
+    auto snapshot = arrays.snapshot();
+    EXPECT_TRUE(arrays.isShared<0>());
+    EXPECT_TRUE(arrays.isShared<2>());
+    ASSERT_EQ((size_t)100, snapshot.size());
+    EXPECT_EQ(static_cast<const TestArrays&>(arrays).data<1>(), snapshot.data<1>());
+
+    //the first write copies only the written array
+    arrays.at<0>(10) = -10;
+    EXPECT_FALSE(arrays.isShared<0>());
+    EXPECT_TRUE(arrays.isShared<1>());
+    EXPECT_NE(ints, arrays.data<0>());
+    EXPECT_EQ(ints, snapshot.data<0>());
+    EXPECT_EQ(10, snapshot.at<0>(10));
+    EXPECT_EQ(-10, arrays.at<0>(10));
+
+    arrays.data<2>()[5] = "five";
+    EXPECT_EQ("5", snapshot.at<2>(5));
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)arrays.data<1>() % 32);
+
+    //structural changes copy the remaining shared arrays
+    auto second = arrays.snapshot();
+    arrays.removeAtUnordered(0);
+    arrays.append(100, 50.0f, std::string("100"));
+    EXPECT_EQ((size_t)100, arrays.size());
+    EXPECT_EQ(99, arrays.at<0>(0));
+    EXPECT_EQ(0, second.at<0>(0));
+    EXPECT_EQ("five", second.at<2>(5));
+    EXPECT_EQ(0, snapshot.at<0>(0));
+
+    float sum = 0.0f;
+    for (float f : snapshot.array<1>())
+      sum += f;
+    EXPECT_EQ(2475.0f, sum);
+
+    //copies share the arrays as well
+    TestArrays copy(arrays);
+    EXPECT_TRUE(arrays.isShared<0>());
+    copy.swapAt(0, 1);
+    EXPECT_EQ(99, arrays.at<0>(0));
+    EXPECT_EQ(1, copy.at<0>(0));
+
+    arrays.clear();
+    EXPECT_EQ((size_t)0, arrays.size());
+    EXPECT_EQ((size_t)100, copy.size());
+    EXPECT_FALSE(copy.isShared<0>());
+
+    TestArrays::Snapshot empty;
+    EXPECT_TRUE(empty.empty());
+    snapshot = empty;
+    EXPECT_TRUE(snapshot.empty());
+  }
+
+  EXPECT_EQ((size_t)0, allocator.allocations.size());
+
+  //blocks that cannot be allocated
+  struct NullAllocator : public Allocator
+  {
+    virtual void* allocate(size_t) override { return nullptr; }
+    virtual void deallocate(void*) override {}
+  } nullAllocator;
+
+  EXPECT_THROW(TestArrays(&nullAllocator).append(0, 0.0f, std::string()), std::bad_alloc);
+}
+
+TEST(SnapshotArraysTest, Readers)
+{
+  SnapshotArrays<int, int> arrays;
+  for (int i = 0; i < 1000; ++i)
+    arrays.append(i, -i);
+
+  //readers check the snapshots while the writer keeps changing the arrays
+  std::vector<SnapshotArrays<int, int>::Snapshot> snapshots;
+  for (int frame = 0; frame < 8; ++frame)
+  {
+    snapshots.push_back(arrays.snapshot());
+    for (size_t i = 0; i < arrays.size(); i += 10)
+    {
+      arrays.at<0>(i) += 1;
+      arrays.at<1>(i) -= 1;
+    }
+  }
+
+  std::atomic<int> errors(0);
+  std::vector<std::thread> readers;
+  for (auto& snapshot : snapshots)
+  {
+    readers.emplace_back([&errors](SnapshotArrays<int, int>::Snapshot snapshot) {
+      for (size_t i = 0; i < snapshot.size(); ++i)
+        if (snapshot.at<0>(i) != -snapshot.at<1>(i))
+          ++errors;
+    }, std::move(snapshot));
+  }
+
+  for (int i = 0; i < 1000; ++i)
+    arrays.at<0>(i) = 0;
+
+  for (auto& reader : readers)
+    reader.join();
+
+  EXPECT_EQ(0, errors.load());
+  EXPECT_FALSE(arrays.isShared<0>());
+  EXPECT_FALSE(arrays.isShared<1>());
+}
+
+TEST(ArraysViewTest, SaveAndOpen)
+{
+  const char* path = "arrays_view_test.bin";
+
+  Arrays<char, aligned<float, 32>, double, unsigned short> arrays;
+  for (int i = 0; i < 1000; ++i)
+    arrays.append((char)i, i * 0.5f, i * 0.25, (unsigned short)(i * 3));
+
+  ASSERT_TRUE(save(arrays, path));
+
+  {
+    ArraysView<char, aligned<float, 32>, double, unsigned short> view(path);
+    ASSERT_TRUE(view.isOpen());
+    ASSERT_EQ((size_t)1000, view.size());
+    EXPECT_EQ((uintptr_t)0, (uintptr_t)view.data<1>() % 32);
+
+    for (size_t i = 0; i < view.size(); ++i)
+    {
+      EXPECT_EQ(arrays.at<0>(i), view.at<0>(i));
+      EXPECT_EQ(arrays.at<1>(i), view.data<1>()[i]);
+      EXPECT_EQ(arrays.at<2>(i), view.array<2>()[i]);
+      EXPECT_EQ(arrays.at<3>(i), view.at<3>(i));
+    }
+
+    //bulk copy into an Arrays object
+    Arrays<char, aligned<float, 32>, double, unsigned short> copy;
+    copy.appendRange(view.size(), view.data<0>(), view.data<1>(), view.data<2>(), view.data<3>());
+    EXPECT_EQ(arrays.at<2>(999), copy.at<2>(999));
+
+    ArraysView<char, aligned<float, 32>, double, unsigned short> moved(std::move(view));
+    EXPECT_FALSE(view.isOpen());
+    EXPECT_EQ((size_t)0, view.size());
+    EXPECT_EQ((size_t)1000, moved.size());
+    EXPECT_EQ(arrays.at<3>(7), moved.at<3>(7));
+  }
+
+  //different arrays
+  EXPECT_FALSE((ArraysView<char, float, double, unsigned short>(path).isOpen()));
+  EXPECT_FALSE((ArraysView<char, aligned<float, 32>, double, short>(path).isOpen()));
+  EXPECT_FALSE((ArraysView<char, aligned<float, 32>, double>(path).isOpen()));
+  EXPECT_FALSE((ArraysView<int>("does_not_exist.bin").isOpen()));
+
+  //empty and truncated files
+  Arrays<int, float> empty;
+  ASSERT_TRUE(save(empty, path));
+  ArraysView<int, float> emptyView(path);
+  EXPECT_TRUE(emptyView.isOpen());
+  EXPECT_EQ((size_t)0, emptyView.size());
+  emptyView.close();
+
+  //bit arrays are stored as words
+  Arrays<int, bits> flags;
+  for (int i = 0; i < 130; ++i)
+    flags.append(i, i % 5 == 0);
+  ASSERT_TRUE(save(flags, path));
+  {
+    ArraysView<int, bits> view(path);
+    ASSERT_TRUE(view.isOpen());
+    EXPECT_EQ((size_t)26, countBits(view.data<1>(), 0, view.size()));
+    EXPECT_TRUE(testBit(view.data<1>(), 125));
+    EXPECT_FALSE((ArraysView<int, bool>(path).isOpen()));
+  }
+
+  std::ostringstream stream;
+  ASSERT_TRUE(save(arrays, stream));
+  {
+    std::ofstream out(path, std::ios::binary);
+    const std::string bytes = stream.str();
+    out.write(bytes.data(), bytes.size() - 1);
+  }
+  EXPECT_FALSE((ArraysView<char, aligned<float, 32>, double, unsigned short>(path).isOpen()));
+
+  std::remove(path);
+}
+
+TEST(SelectTest, Predicate)
+{
+  Arrays<int, float> arrays;
+  for (int i = 0; i < 3000; ++i)
+    arrays.append(i, (float)((i * 37) % 101));
+
+  Selection selection = select<1>(arrays, [](float v) { return v < 10.0f; });
+  std::vector<std::uint32_t> expected;
+  for (std::uint32_t i = 0; i < 3000; ++i)
+  {
+    if (arrays.at<1>(i) < 10.0f)
+      expected.push_back(i);
+  }
+  EXPECT_EQ(expected, std::vector<std::uint32_t>(selection.begin(), selection.end()));
+
+  //the selection is replaced, not extended
+  select<0>(arrays, [](int v) { return v % 1000 == 999; }, selection);
+  ASSERT_EQ((size_t)3, selection.size());
+  EXPECT_EQ((std::uint32_t)1999, selection[1]);
+
+  select<0>(Arrays<int, float>(), [](int) { return true; }, selection);
+  EXPECT_TRUE(selection.empty());
+}
+
+TEST(SelectTest, Flags)
+{
+  forEachSimdLevel([] {
+    for (size_t rows : { 0, 1, 15, 63, 64, 65, 200, 1023, 1024, 1025, 5000 })
+    {
+      for (unsigned ratio : { 0, 1, 3, 8 })
+      {
+        Arrays<bool, bits, int> arrays;
+        std::vector<std::uint32_t> expected;
+        for (size_t i = 0; i < rows; ++i)
+        {
+          const bool set = ratio == 0 || (i * 7919) % ratio == 0;
+          arrays.append(set, set, (int)i);
+          if (set)
+            expected.push_back((std::uint32_t)i);
+        }
+
+        Selection fromBools = select<0>(arrays);
+        EXPECT_EQ(expected, std::vector<std::uint32_t>(fromBools.begin(), fromBools.end())) << "rows " << rows << " ratio " << ratio;
+
+        Selection fromBits = select<1>(arrays);
+        EXPECT_EQ(expected, std::vector<std::uint32_t>(fromBits.begin(), fromBits.end())) << "rows " << rows << " ratio " << ratio;
+      }
+    }
+  });
+}
+
+TEST(SelectTest, FilteredView)
+{
+  Arrays<bool, float, float> arrays;
+  for (int i = 0; i < 1000; ++i)
+    arrays.append(i % 3 == 0, (float)i, 1.0f);
+
+  const Selection selection = select<0>(arrays);
+  auto view = filter(arrays, selection);
+  EXPECT_EQ((size_t)334, view.size());
+  EXPECT_EQ((size_t)9, view.rowAt(3));
+
+  //several passes over the same selection
+  for (int pass = 0; pass < 2; ++pass)
+    view.forEach<2, 1>([](float& y, float x) { y += x; });
+
+  float sum = 0.0f;
+  view.forEach<0>([&](bool active) { EXPECT_TRUE(active); });
+  view.forEach<2>([&](float y) { sum += y; });
+  EXPECT_EQ(334.0f + 2.0f * 166833.0f, sum);
+  EXPECT_EQ(1.0f, arrays.at<2>(1));
+  EXPECT_EQ(19.0f, arrays.at<2>(9));
+}
+
+TEST(KernelsTest, Reductions)
+{
+  forEachSimdLevel([] {
+    for (size_t width : { 1, 2, 3, 4, 8, 16, 20 })
+    {
+      for (size_t rows : { 0, 1, 5, 16, 63, 64, 65, 200 })
+      {
+        //integer values, the sums are exact in any order
+        std::vector<float> x = testValues(rows * width, -10.0f);
+        for (float& v : x)
+          v = (float)(int)(v * 4.0f);
+
+        std::vector<float> expectedSum(width, 0.0f);
+        std::vector<float> expectedMin(width, std::numeric_limits<float>::infinity());
+        std::vector<float> expectedMax(width, -std::numeric_limits<float>::infinity());
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+          expectedSum[i % width] += x[i];
+          expectedMin[i % width] = std::min(expectedMin[i % width], x[i]);
+          expectedMax[i % width] = std::max(expectedMax[i % width], x[i]);
+        }
+
+        std::vector<float> sum(width), min(width), max(width);
+        kernels::sum(rows, width, x.data(), sum.data());
+        kernels::minMax(rows, width, x.data(), min.data(), max.data());
+        ASSERT_EQ(expectedSum, sum) << "width " << width << " rows " << rows;
+        ASSERT_EQ(expectedMin, min) << "width " << width << " rows " << rows;
+        ASSERT_EQ(expectedMax, max) << "width " << width << " rows " << rows;
+      }
+    }
+
+    //NaNs are ignored
+    std::vector<float> x(100, 1.0f);
+    x[50] = 5.0f;
+    x[99] = std::numeric_limits<float>::quiet_NaN();
+    float min, max;
+    kernels::minMax(x.size(), 1, x.data(), &min, &max);
+    EXPECT_EQ(1.0f, min);
+    EXPECT_EQ(5.0f, max);
+  });
+}
+
+TEST(ReduceTest, Arrays)
+{
+  Arrays<int, float, Float4, unsigned> arrays;
+  for (int i = 0; i < 10000; ++i)
+    arrays.append(i - 5000, (float)(i % 100), Float4{ (float)i, (float)-i, 1.0f, (float)(i % 7) }, (unsigned)((i * 37) % 1000));
+
+  ThreadPool pool(4);
+
+  EXPECT_EQ(-5000, sum<0>(arrays));
+  EXPECT_EQ(-5000, sum<0>(pool, arrays, 100));
+  EXPECT_EQ(49.5f * 10000, sum<1>(arrays));
+  EXPECT_EQ(49.5f * 10000, sum<1>(pool, arrays, 1000));
+
+  const Float4 total = sum<2>(pool, arrays, 1000);
+  EXPECT_EQ(49995000.0f, total.x);
+  EXPECT_EQ(-49995000.0f, total.y);
+  EXPECT_EQ(10000.0f, total.z);
+
+  EXPECT_EQ(std::make_pair(-5000, 4999), minMax<0>(arrays));
+  EXPECT_EQ(std::make_pair(-5000, 4999), minMax<0>(pool, arrays, 64));
+  EXPECT_EQ(std::make_pair(0.0f, 99.0f), minMax<1>(pool, arrays));
+
+  //bounds of the positions
+  const std::pair<Float4, Float4> bounds = minMax<2>(arrays);
+  EXPECT_EQ(0.0f, bounds.first.x);
+  EXPECT_EQ(-9999.0f, bounds.first.y);
+  EXPECT_EQ(9999.0f, bounds.second.x);
+  EXPECT_EQ(6.0f, bounds.second.w);
+  EXPECT_EQ(bounds.second.w, (minMax<2>(pool, arrays, 100).second.w));
+
+  const std::pair<float, float> empty = minMax<1>(Arrays<int, float>());
+  EXPECT_GT(empty.first, empty.second);
+
+  EXPECT_EQ((size_t)5000, count<0>(arrays, [](int v) { return v >= 0; }));
+  EXPECT_EQ((size_t)5000, count<0>(pool, arrays, [](int v) { return v >= 0; }, 64));
+
+  EXPECT_EQ(-5000LL, reduce<0>(arrays, 0LL, [](long long a, long long b) { return a + b; }));
+  EXPECT_EQ(4999, reduce<0>(pool, arrays, std::numeric_limits<int>::min(), [](int a, int b) { return std::max(a, b); }, 64));
+
+  //the parallel result does not depend on the number of threads
+  ThreadPool single(1);
+  EXPECT_EQ(sum<1>(pool, arrays, 256), sum<1>(single, arrays, 256));
+
+  size_t counts[10], parallelCounts[10];
+  histogram<3>(arrays, 10, uniformBins(0u, 1000u, 10), counts);
+  histogram<3>(pool, arrays, 10, [](unsigned v) { return (size_t)v / 100; }, parallelCounts, 256);
+  for (size_t b = 0; b < 10; ++b)
+  {
+    EXPECT_EQ((size_t)1000, counts[b]);
+    EXPECT_EQ((size_t)1000, parallelCounts[b]);
+  }
+
+  const UniformBins<float> bins = uniformBins(0.0f, 1.0f, 4);
+  EXPECT_EQ((size_t)0, bins(-1.0f));
+  EXPECT_EQ((size_t)1, bins(0.25f));
+  EXPECT_EQ((size_t)3, bins(0.99f));
+  EXPECT_EQ((size_t)3, bins(7.0f));
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);